@@ -27,6 +27,7 @@ layout(std140, binding = 0) uniform Matrices
 };
 
 uniform bool u_UseAO = true;
+uniform bool u_UseLighting = true;
 
 void main() {
     uint x = bitfieldExtract(data.x, 0, 6);
@@ -34,7 +35,7 @@ void main() {
     uint z = bitfieldExtract(data.x, 12, 6);
     uint u = bitfieldExtract(data.x, 20, 6);
     uint v = bitfieldExtract(data.x, 26, 6);
-    uint tex_idx = bitfieldExtract(data.y, 0, 29);
+    uint tex_idx = bitfieldExtract(data.y, 0, 21);
     UniformData uniform_data = uniforms[gl_DrawID + gl_InstanceID];
     vec4 pos_world_space = vec4(vec3(x, y, z) + uniform_data.pos.xyz, 1.0);
     vs_out.normal = CubeNormals[bitfieldExtract(data.y, 29, 3)];
@@ -46,4 +47,10 @@ void main() {
     } else {
         vs_out.color = vec3(1);
     }
+    if (u_UseLighting) {
+        float sky_light = float(bitfieldExtract(data.y, 25, 4)) / 15.0;
+        float block_light = float(bitfieldExtract(data.y, 21, 4)) / 15.0;
+        float light = max(sky_light, block_light);
+        vs_out.color *= max(pow(0.8, (1.0 - light) * 15.0), 0.05);
+    }
 }
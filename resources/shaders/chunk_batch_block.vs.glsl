@@ -50,7 +50,7 @@ void main() {
     uint z = bitfieldExtract(data.x, 12, 6);
     uint u = bitfieldExtract(data.x, 20, 6);
     uint v = bitfieldExtract(data.x, 26, 6);
-    uint tex_idx = bitfieldExtract(data.y, 0, 29);
+    uint tex_idx = bitfieldExtract(data.y, 0, 21);
     UniformData uniform_data = uniforms[gl_DrawID + gl_InstanceID];
     vec4 pos_world_space = uniform_data.model * vec4(x, y, z, 1.0);
     gl_Position = vp_matrix * pos_world_space;
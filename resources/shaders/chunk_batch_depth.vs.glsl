@@ -22,7 +22,7 @@ void main() {
     uint z = bitfieldExtract(data.x, 12, 6);
     uint u = bitfieldExtract(data.x, 20, 6);
     uint v = bitfieldExtract(data.x, 26, 6);
-    uint tex_idx = bitfieldExtract(data.y, 0, 29);
+    uint tex_idx = bitfieldExtract(data.y, 0, 21);
     vs_out.tex_coords = vec3(u, v, tex_idx);
     UniformData uniform_data = uniforms[gl_DrawID + gl_InstanceID];
     vec4 pos_world_space = vec4(vec3(x, y, z) + uniform_data.pos.xyz, 1.0);
@@ -8,6 +8,7 @@
 #include <glm/vec3.hpp>
 #include <string>
 
+#include "Metrics.hpp"
 #include "SettingsManager.hpp"
 #include "Window.hpp"
 #include "application/Input.hpp"
@@ -33,6 +34,9 @@ Application::Application(int width, int height, const char* title) : scene_manag
 
   auto app_settings_json = SettingsManager::Get().LoadSetting("application");
   imgui_enabled_ = app_settings_json.value("imgui_enabled", true);
+  auto metrics_settings_json = SettingsManager::Get().LoadSetting("metrics");
+  MetricsRegistry::Get().SetDumpPath(metrics_settings_json.value("dump_path", ""),
+                                     metrics_settings_json.value("dump_interval_seconds", 10.0));
   window_.Init(width, height, title, [this](SDL_Event& event) { OnEvent(event); });
   Renderer::Init(window_);
 
@@ -54,11 +58,13 @@ void Application::Run() {
   Uint64 prev_time = 0;
   double dt = 0;
   // create vao
+  auto& frame_time_us = MetricsRegistry::Get().GetHistogram("frame.time_us");
   while (!window_.ShouldClose()) {
     ZoneScopedN("main loop");
     prev_time = curr_time;
     curr_time = SDL_GetPerformanceCounter();
     dt = ((curr_time - prev_time) / static_cast<double>(SDL_GetPerformanceFrequency()));
+    if (prev_time != 0) frame_time_us.Record(static_cast<uint64_t>(dt * 1'000'000));
 
     window_.PollEvents();
     scene_manager_.GetActiveScene().Update(dt);
@@ -72,10 +78,15 @@ void Application::Run() {
       if (imgui_enabled_) OnImGui();
       window_.EndRenderFrame(imgui_enabled_);
     }
+    MetricsRegistry::Get().EndFrame();
   }
 
   nlohmann::json app_settings_json = {{"imgui_enabled", imgui_enabled_}};
   SettingsManager::Get().SaveSetting(app_settings_json, "application");
+  nlohmann::json metrics_settings_json = {
+      {"dump_path", MetricsRegistry::Get().GetDumpPath()},
+      {"dump_interval_seconds", MetricsRegistry::Get().GetDumpIntervalSeconds()}};
+  SettingsManager::Get().SaveSetting(metrics_settings_json, "metrics");
 
   scene_manager_.Shutdown();
   ShaderManager::Shutdown();
@@ -141,6 +152,7 @@ void Application::OnImGui() {
   }
 
   SettingsManager::Get().OnImGui();
+  MetricsRegistry::Get().OnImGui();
   Renderer::Get().OnImGui();
   scene_manager_.GetActiveScene().OnImGui();
   ImGui::End();
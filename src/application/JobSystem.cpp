@@ -0,0 +1,261 @@
+#include "JobSystem.hpp"
+
+#include <imgui.h>
+
+#include <nlohmann/json.hpp>
+
+#include "application/Metrics.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+constexpr const char* kPriorityNames[JobSystem::kNumPriorities] = {"edit", "visible",
+                                                                   "background"};
+
+// the worker the current thread is, -1 on threads the job system didn't start
+thread_local const JobSystem* tls_job_system = nullptr;
+thread_local int tls_worker = -1;
+
+void PinThread(std::thread& thread, size_t index) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(index % std::max(1u, std::thread::hardware_concurrency()), &set);
+  if (pthread_setaffinity_np(thread.native_handle(), sizeof(set), &set) != 0) {
+    spdlog::warn("failed to pin job worker {}", index);
+  }
+#else
+  (void)thread;
+  spdlog::warn("pinning job worker {} is only supported on Linux", index);
+#endif
+}
+
+}  // namespace
+
+bool JobSystem::Handle::Done() const { return job_ && job_->done.load(std::memory_order_acquire); }
+
+JobSystem::~JobSystem() { Shutdown(); }
+
+void JobSystem::LoadSettings(const nlohmann::json& j) {
+  settings_.num_workers = j.value("num_workers", settings_.num_workers);
+  settings_.pin_workers = j.value("pin_workers", settings_.pin_workers);
+}
+
+nlohmann::json JobSystem::SaveSettings() const {
+  return {{"num_workers", settings_.num_workers}, {"pin_workers", settings_.pin_workers}};
+}
+
+void JobSystem::Start() { Start(settings_); }
+
+void JobSystem::Start(const Settings& settings) {
+  EASSERT_MSG(workers_.empty(), "Job system already started");
+  settings_ = settings;
+  stop_ = false;
+  size_t num_workers = settings_.num_workers;
+  if (num_workers == 0) num_workers = std::max(1u, std::thread::hardware_concurrency());
+  // every worker exists before any of them looks for jobs to steal
+  for (size_t i = 0; i < num_workers; i++) workers_.emplace_back(std::make_unique<Worker>());
+  for (size_t i = 0; i < num_workers; i++) {
+    workers_[i]->thread = std::thread([this, i] { WorkerLoop(i); });
+    if (settings_.pin_workers) PinThread(workers_[i]->thread, i);
+  }
+}
+
+void JobSystem::Shutdown() {
+  if (workers_.empty()) return;
+  WaitAll();
+  {
+    std::lock_guard<std::mutex> lock(sleep_mtx_);
+    stop_ = true;
+  }
+  sleep_cv_.notify_all();
+  for (auto& worker : workers_) worker->thread.join();
+  workers_.clear();
+}
+
+JobSystem::Handle JobSystem::Submit(Priority priority, JobFunc func) {
+  return Submit(priority, std::move(func), {});
+}
+
+JobSystem::Handle JobSystem::Submit(Priority priority, JobFunc func,
+                                    std::span<const Handle> dependencies) {
+  EASSERT_MSG(!workers_.empty(), "Job system not started");
+  auto job = std::make_shared<Job>();
+  job->func = std::move(func);
+  job->priority = priority;
+  // counted before a dependency can finish and enqueue it
+  pending_.fetch_add(1, std::memory_order_relaxed);
+  job->waiting_on.store(1, std::memory_order_relaxed);
+  for (const Handle& dependency : dependencies) {
+    if (!dependency.job_) continue;
+    std::lock_guard<std::mutex> lock(dependency.job_->mtx);
+    if (dependency.job_->done.load(std::memory_order_relaxed)) continue;
+    job->waiting_on.fetch_add(1, std::memory_order_relaxed);
+    dependency.job_->dependents.emplace_back(job);
+  }
+  if (job->waiting_on.fetch_sub(1, std::memory_order_acq_rel) == 1) Enqueue(job);
+  return Handle{std::move(job)};
+}
+
+void JobSystem::Enqueue(std::shared_ptr<Job> job) {
+  auto p = static_cast<size_t>(job->priority);
+  job->ready_time = std::chrono::steady_clock::now();
+  // counted before it's pushed, a worker that sees the count spins until it finds the job
+  queued_[p].fetch_add(1, std::memory_order_release);
+  int self = CurrentWorker();
+  if (self >= 0) {
+    Worker& worker = *workers_[self];
+    std::lock_guard<std::mutex> lock(worker.mtx);
+    worker.queues[p].emplace_front(std::move(job));
+  } else {
+    Worker& worker = *workers_[next_worker_.fetch_add(1, std::memory_order_relaxed) %
+                               workers_.size()];
+    std::lock_guard<std::mutex> lock(worker.mtx);
+    worker.queues[p].emplace_back(std::move(job));
+  }
+  // taken so a worker can't miss the wake up between checking the counts and sleeping
+  { std::lock_guard<std::mutex> lock(sleep_mtx_); }
+  sleep_cv_.notify_one();
+}
+
+std::shared_ptr<JobSystem::Job> JobSystem::FindJob(int self, Priority max_priority) {
+  size_t num_workers = workers_.size();
+  for (size_t p = 0; p <= static_cast<size_t>(max_priority); p++) {
+    if (queued_[p].load(std::memory_order_acquire) <= 0) continue;
+    // the owner takes from the front, thieves from the back so they leave its continuations
+    auto take = [this, p](Worker& worker, bool owner) -> std::shared_ptr<Job> {
+      std::lock_guard<std::mutex> lock(worker.mtx);
+      auto& queue = worker.queues[p];
+      if (queue.empty()) return nullptr;
+      std::shared_ptr<Job> job;
+      if (owner) {
+        job = std::move(queue.front());
+        queue.pop_front();
+      } else {
+        job = std::move(queue.back());
+        queue.pop_back();
+      }
+      queued_[p].fetch_sub(1, std::memory_order_relaxed);
+      return job;
+    };
+    if (self >= 0) {
+      if (auto job = take(*workers_[self], true)) return job;
+    }
+    size_t start = self >= 0 ? self + 1 : next_worker_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < num_workers; i++) {
+      size_t victim = (start + i) % num_workers;
+      if (static_cast<int>(victim) == self) continue;
+      if (auto job = take(*workers_[victim], false)) {
+        if (self >= 0) steals_.fetch_add(1, std::memory_order_relaxed);
+        return job;
+      }
+    }
+  }
+  return nullptr;
+}
+
+void JobSystem::Run(const std::shared_ptr<Job>& job) {
+  static std::array<MetricHistogram*, kNumPriorities> wait_us = [] {
+    std::array<MetricHistogram*, kNumPriorities> histograms{};
+    for (size_t i = 0; i < kNumPriorities; i++) {
+      histograms[i] = &MetricsRegistry::Get().GetHistogram(std::string("job_system.") +
+                                                           kPriorityNames[i] + "_wait_us");
+    }
+    return histograms;
+  }();
+  running_.fetch_add(1, std::memory_order_relaxed);
+  wait_us[static_cast<size_t>(job->priority)]->Record(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() -
+                                                            job->ready_time)
+          .count());
+  job->func();
+  // release the captures now, handles can keep the job alive for a while
+  job->func = nullptr;
+
+  std::vector<std::shared_ptr<Job>> dependents;
+  {
+    std::lock_guard<std::mutex> lock(job->mtx);
+    job->done.store(true, std::memory_order_release);
+    dependents.swap(job->dependents);
+  }
+  for (auto& dependent : dependents) {
+    if (dependent->waiting_on.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      Enqueue(std::move(dependent));
+    }
+  }
+  running_.fetch_sub(1, std::memory_order_relaxed);
+  if (pending_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    std::lock_guard<std::mutex> lock(sleep_mtx_);
+    idle_cv_.notify_all();
+  }
+}
+
+void JobSystem::WorkerLoop(size_t index) {
+  tls_job_system = this;
+  tls_worker = static_cast<int>(index);
+  while (true) {
+    if (auto job = FindJob(tls_worker, Priority::kBackground)) {
+      Run(job);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleep_mtx_);
+    sleep_cv_.wait(lock, [this] { return stop_ || NumQueued() > 0; });
+    if (stop_ && NumQueued() == 0) return;
+  }
+}
+
+void JobSystem::Wait(const Handle& handle) {
+  if (!handle.job_) return;
+  int self = CurrentWorker();
+  // a worker helps with anything, or every worker could end up waiting on a job none will run
+  Priority max_priority = self >= 0 ? Priority::kBackground : handle.job_->priority;
+  while (!handle.Done()) {
+    if (auto job = FindJob(self, max_priority)) {
+      Run(job);
+    } else {
+      // running on a worker or waiting on its dependencies
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::WaitAll() {
+  EASSERT_MSG(CurrentWorker() < 0, "WaitAll from a job waits on itself");
+  std::unique_lock<std::mutex> lock(sleep_mtx_);
+  idle_cv_.wait(lock, [this] { return pending_.load(std::memory_order_acquire) == 0; });
+}
+
+int JobSystem::CurrentWorker() const { return tls_job_system == this ? tls_worker : -1; }
+
+size_t JobSystem::NumQueued() const {
+  int64_t queued = 0;
+  for (const auto& count : queued_) queued += count.load(std::memory_order_relaxed);
+  return static_cast<size_t>(std::max<int64_t>(0, queued));
+}
+
+size_t JobSystem::NumRunning() const {
+  return static_cast<size_t>(std::max<int64_t>(0, running_.load(std::memory_order_relaxed)));
+}
+
+bool JobSystem::Idle() const { return pending_.load(std::memory_order_acquire) == 0; }
+
+void JobSystem::OnImGui() {
+  if (!ImGui::CollapsingHeader("Job System##chunk_manager_job_system")) return;
+  auto num_workers = static_cast<int>(settings_.num_workers);
+  if (ImGui::SliderInt("Workers (0 = all cores)##job_system", &num_workers, 0,
+                       static_cast<int>(std::thread::hardware_concurrency()))) {
+    settings_.num_workers = num_workers;
+  }
+  ImGui::Checkbox("Pin Workers##job_system", &settings_.pin_workers);
+  ImGui::TextUnformatted("Worker settings apply on restart");
+  ImGui::Text("Running Workers: %zu, Jobs Running: %zu", workers_.size(), NumRunning());
+  for (size_t i = 0; i < kNumPriorities; i++) {
+    ImGui::Text("Queued %s: %ld", kPriorityNames[i],
+                static_cast<long>(queued_[i].load(std::memory_order_relaxed)));
+  }
+  ImGui::Text("Steals: %lu", static_cast<unsigned long>(steals_.load(std::memory_order_relaxed)));
+}
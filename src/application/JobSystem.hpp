@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <nlohmann/json_fwd.hpp>
+#include <thread>
+
+// Work stealing thread pool for the chunk pipeline. Every worker has a deque per priority. Jobs
+// from other threads are spread round robin over the back of the workers' deques, and a job
+// submitted from a worker, like a continuation, goes to the front of that worker's own deque so it
+// runs next while its inputs are still in cache. An idle worker looks for the highest priority job
+// it can find. It takes from the front of its own deque first: its continuations, then the oldest
+// jobs, since chunk jobs are submitted nearest the player first. Otherwise it steals from the back
+// of another worker's deque, the newest job, which leaves the owner its continuations.
+class JobSystem {
+ public:
+  enum class Priority : uint8_t {
+    // remeshing chunks the player just edited, waited on the same frame
+    kEdit,
+    // meshes of the chunks around the player
+    kVisible,
+    // terrain, light, LOD meshes and releasing unloaded columns
+    kBackground,
+    kCount,
+  };
+  static constexpr size_t kNumPriorities = static_cast<size_t>(Priority::kCount);
+
+  using JobFunc = std::function<void()>;
+
+ private:
+  struct Job;
+
+ public:
+  // Refers to a submitted job, for waiting on it or running other jobs after it.
+  class Handle {
+   public:
+    Handle() = default;
+    [[nodiscard]] bool Done() const;
+    [[nodiscard]] bool Valid() const { return job_ != nullptr; }
+
+   private:
+    friend class JobSystem;
+    explicit Handle(std::shared_ptr<Job> job) : job_(std::move(job)) {}
+    std::shared_ptr<Job> job_;
+  };
+
+  struct Settings {
+    // 0 uses every core
+    uint32_t num_workers{0};
+    // pins worker i to core i, only supported on Linux
+    bool pin_workers{false};
+  };
+
+  JobSystem() = default;
+  // Waits for every job, then joins the workers.
+  ~JobSystem();
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  void LoadSettings(const nlohmann::json& j);
+  [[nodiscard]] nlohmann::json SaveSettings() const;
+  [[nodiscard]] const Settings& GetSettings() const { return settings_; }
+  // Starts the workers. Settings loaded after take effect on the next Start.
+  void Start();
+  void Start(const Settings& settings);
+  void Shutdown();
+
+  Handle Submit(Priority priority, JobFunc func);
+  // Runs func once every dependency has finished. Invalid handles are ignored.
+  Handle Submit(Priority priority, JobFunc func, std::span<const Handle> dependencies);
+  // Blocks until the job has finished. Meanwhile the calling thread runs queued jobs of the job's
+  // priority or higher, so waiting on edit jobs from the main thread helps finish them.
+  void Wait(const Handle& handle);
+  // Blocks until every submitted job has finished, including ones submitted by jobs.
+  void WaitAll();
+
+  // ready to run, not counting jobs waiting on dependencies
+  [[nodiscard]] size_t NumQueued() const;
+  [[nodiscard]] size_t NumRunning() const;
+  // no job queued, running or waiting on dependencies
+  [[nodiscard]] bool Idle() const;
+  [[nodiscard]] size_t NumWorkers() const { return workers_.size(); }
+
+  // worker settings changed here apply on the next Start
+  void OnImGui();
+
+ private:
+  struct Job {
+    JobFunc func;
+    Priority priority;
+    std::chrono::steady_clock::time_point ready_time;
+    // dependencies left, plus one while Submit is still adding them
+    std::atomic<uint32_t> waiting_on{0};
+    std::atomic<bool> done{false};
+    std::mutex mtx;
+    // run once this job is done, guarded by mtx
+    std::vector<std::shared_ptr<Job>> dependents;
+  };
+
+  struct Worker {
+    std::mutex mtx;
+    std::array<std::deque<std::shared_ptr<Job>>, kNumPriorities> queues;
+    std::thread thread;
+  };
+
+  void WorkerLoop(size_t index);
+  void Enqueue(std::shared_ptr<Job> job);
+  // the oldest job of priority max_priority or higher, from worker self first. self is -1 off the
+  // workers.
+  std::shared_ptr<Job> FindJob(int self, Priority max_priority);
+  void Run(const std::shared_ptr<Job>& job);
+  [[nodiscard]] int CurrentWorker() const;
+
+  Settings settings_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<uint32_t> next_worker_{0};
+  std::array<std::atomic<int64_t>, kNumPriorities> queued_{};
+  std::atomic<int64_t> running_{0};
+  // submitted and not finished, including jobs waiting on dependencies
+  std::atomic<int64_t> pending_{0};
+  std::atomic<uint64_t> steals_{0};
+
+  std::mutex sleep_mtx_;
+  std::condition_variable sleep_cv_;
+  std::condition_variable idle_cv_;
+  bool stop_{false};
+};
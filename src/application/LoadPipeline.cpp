@@ -0,0 +1,118 @@
+#include "LoadPipeline.hpp"
+
+#include <imgui.h>
+
+#include "application/Metrics.hpp"
+#include "util/Timer.hpp"
+
+namespace {
+
+double MSSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+LoadPipeline::LoadPipeline(std::string name) : name_(std::move(name)) {}
+
+LoadPipeline::~LoadPipeline() { thread_pool_.wait(); }
+
+void LoadPipeline::AddStage(std::string name, WorkFunc work, StepFunc step) {
+  stages_.push_back({.name = std::move(name), .work = std::move(work), .step = std::move(step)});
+}
+
+std::string_view LoadPipeline::CurrentStage() const {
+  return Done() ? std::string_view{} : std::string_view{stages_[current_].name};
+}
+
+void LoadPipeline::StartStage() {
+  if (current_ == 0) start_ = std::chrono::steady_clock::now();
+  stage_start_ = std::chrono::steady_clock::now();
+  stage_started_ = true;
+  Stage& stage = stages_[current_];
+  if (!stage.work) {
+    work_done_ = true;
+    return;
+  }
+  work_done_ = false;
+  thread_pool_.detach_task([this, &stage] {
+    ZoneScopedN("load stage work");
+    Timer timer;
+    stage.work();
+    stage.work_ms = timer.ElapsedMS();
+    work_done_.store(true, std::memory_order_release);
+  });
+}
+
+void LoadPipeline::FinishStage() {
+  Stage& stage = stages_[current_];
+  stage.wall_ms = MSSince(stage_start_);
+  // the work and its captures aren't needed again
+  stage.work = {};
+  stage.step = {};
+  stage_started_ = false;
+  current_++;
+  if (Done()) {
+    total_ms_ = MSSince(start_);
+    Report();
+  }
+}
+
+void LoadPipeline::Update(double budget_ms) {
+  ZoneScoped;
+  Timer timer;
+  while (!Done()) {
+    if (!stage_started_) StartStage();
+    if (!work_done_.load(std::memory_order_acquire)) return;
+    Stage& stage = stages_[current_];
+    bool stage_done = true;
+    if (stage.step) {
+      Timer step_timer;
+      stage_done = stage.step();
+      stage.main_ms += step_timer.ElapsedMS();
+      stage.steps++;
+    }
+    if (stage_done) FinishStage();
+    if (timer.ElapsedMS() >= budget_ms) return;
+  }
+}
+
+void LoadPipeline::Report() const {
+  spdlog::info("{} loaded in {:.1f} ms", name_, total_ms_);
+  for (const auto& stage : stages_) {
+    spdlog::info("  {}: {:.1f} ms, worker {:.1f} ms, main thread {:.1f} ms over {} steps",
+                 stage.name, stage.wall_ms, stage.work_ms, stage.main_ms, stage.steps);
+    MetricsRegistry::Get().GetGauge(fmt::format("load.{}_ms", stage.name)).Set(stage.wall_ms);
+  }
+  MetricsRegistry::Get().GetGauge(fmt::format("load.{}_ms", name_)).Set(total_ms_);
+}
+
+void LoadPipeline::OnImGui() const {
+  if (!ImGui::CollapsingHeader(fmt::format("Load: {}", name_).c_str())) return;
+  if (!Done()) {
+    ImGui::Text("Loading: %s (%zu/%zu)", stages_[current_].name.c_str(), current_ + 1,
+                stages_.size());
+  } else {
+    ImGui::Text("Total: %.1f ms", total_ms_);
+  }
+  if (ImGui::BeginTable("load stages", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+    for (const char* header : {"stage", "wall ms", "worker ms", "main ms"}) {
+      ImGui::TableSetupColumn(header);
+    }
+    ImGui::TableHeadersRow();
+    for (size_t i = 0; i < current_ && i < stages_.size(); i++) {
+      const Stage& stage = stages_[i];
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(stage.name.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", stage.wall_ms);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", stage.work_ms);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", stage.main_ms);
+    }
+    ImGui::EndTable();
+  }
+}
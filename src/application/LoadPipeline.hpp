@@ -0,0 +1,56 @@
+#pragma once
+
+#include <BS_thread_pool.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+// Runs named load stages in order without blocking the main loop. A stage's optional work runs on
+// a worker thread, then its step runs on the main thread, as many times per frame as the frame's
+// budget allows, until it reports the stage done. Put GL uploads in steps and IO and decode in
+// work. Stage times are logged and published as "load.<stage>_ms" gauges when the last one ends.
+class LoadPipeline {
+ public:
+  using WorkFunc = std::function<void()>;
+  // returns true once the stage is done
+  using StepFunc = std::function<bool()>;
+
+  explicit LoadPipeline(std::string name);
+  // Waits for stage work still running on the worker.
+  ~LoadPipeline();
+  LoadPipeline(const LoadPipeline&) = delete;
+  LoadPipeline& operator=(const LoadPipeline&) = delete;
+
+  // Add every stage before the first Update.
+  void AddStage(std::string name, WorkFunc work, StepFunc step);
+  // Call once per frame from the main thread.
+  void Update(double budget_ms);
+  [[nodiscard]] bool Done() const { return current_ >= stages_.size(); }
+  // empty when done
+  [[nodiscard]] std::string_view CurrentStage() const;
+  void OnImGui() const;
+
+ private:
+  struct Stage {
+    std::string name;
+    WorkFunc work;
+    StepFunc step;
+    double work_ms{};
+    double main_ms{};
+    double wall_ms{};
+    uint32_t steps{};
+  };
+  void StartStage();
+  void FinishStage();
+  void Report() const;
+
+  std::string name_;
+  std::vector<Stage> stages_;
+  size_t current_{0};
+  bool stage_started_{false};
+  std::atomic<bool> work_done_{false};
+  std::chrono::steady_clock::time_point stage_start_;
+  std::chrono::steady_clock::time_point start_;
+  double total_ms_{};
+  BS::thread_pool thread_pool_{1};
+};
@@ -0,0 +1,264 @@
+#include "Metrics.hpp"
+
+#include <imgui.h>
+
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+double SecondsBetween(std::chrono::steady_clock::time_point a,
+                      std::chrono::steady_clock::time_point b) {
+  return std::chrono::duration<double>(b - a).count();
+}
+
+}  // namespace
+
+int MetricHistogram::BucketIndex(uint64_t value) {
+  if (value < kSubBuckets) return static_cast<int>(value);
+  constexpr uint64_t kMaxValue = (uint64_t{2} << kMaxExponent) - 1;
+  value = std::min(value, kMaxValue);
+  int exponent = std::bit_width(value) - 1;
+  int shift = exponent - kSubBucketBits;
+  int sub = static_cast<int>((value >> shift) & (kSubBuckets - 1));
+  return kSubBuckets + shift * kSubBuckets + sub;
+}
+
+uint64_t MetricHistogram::BucketValue(int index) {
+  if (index < kSubBuckets) return index;
+  int shift = (index - kSubBuckets) / kSubBuckets;
+  uint64_t sub = (index - kSubBuckets) % kSubBuckets;
+  uint64_t low = (kSubBuckets + sub) << shift;
+  return low + ((uint64_t{1} << shift) >> 1);
+}
+
+void MetricHistogram::Record(uint64_t value) {
+  buckets_[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+  uint64_t prev_max = max_.load(std::memory_order_relaxed);
+  while (value > prev_max &&
+         !max_.compare_exchange_weak(prev_max, value, std::memory_order_relaxed)) {
+  }
+}
+
+MetricHistogram::Snapshot MetricHistogram::TakeSnapshot() const {
+  // not atomic as a whole, a record in flight can show up in count before its bucket
+  Snapshot snapshot;
+  for (int i = 0; i < kNumBuckets; i++) {
+    snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+  }
+  snapshot.count = count_.load(std::memory_order_relaxed);
+  snapshot.sum = sum_.load(std::memory_order_relaxed);
+  snapshot.max = max_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+uint64_t MetricHistogram::Snapshot::Percentile(double p) const {
+  uint64_t total = 0;
+  for (uint64_t c : buckets) total += c;
+  if (total == 0) return 0;
+  auto target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(p * total)));
+  uint64_t seen = 0;
+  for (int i = 0; i < kNumBuckets; i++) {
+    seen += buckets[i];
+    if (seen >= target) return std::min(BucketValue(i), max);
+  }
+  return max;
+}
+
+double MetricHistogram::Snapshot::Mean() const {
+  return count ? static_cast<double>(sum) / static_cast<double>(count) : 0;
+}
+
+MetricHistogram::Snapshot MetricHistogram::Snapshot::Since(const Snapshot& earlier) const {
+  Snapshot diff;
+  for (int i = 0; i < kNumBuckets; i++) diff.buckets[i] = buckets[i] - earlier.buckets[i];
+  diff.count = count - earlier.count;
+  diff.sum = sum - earlier.sum;
+  diff.max = max;
+  return diff;
+}
+
+MetricsRegistry& MetricsRegistry::Get() {
+  static MetricsRegistry registry;
+  return registry;
+}
+
+MetricCounter& MetricsRegistry::GetCounter(std::string_view name) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto it = counters_.find(name);
+  if (it == counters_.end()) it = counters_.try_emplace(std::string(name)).first;
+  return it->second.metric;
+}
+
+MetricGauge& MetricsRegistry::GetGauge(std::string_view name) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto it = gauges_.find(name);
+  if (it == gauges_.end()) it = gauges_.try_emplace(std::string(name)).first;
+  return it->second.metric;
+}
+
+MetricHistogram& MetricsRegistry::GetHistogram(std::string_view name) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  auto it = histograms_.find(name);
+  if (it == histograms_.end()) it = histograms_.try_emplace(std::string(name)).first;
+  return it->second.metric;
+}
+
+void MetricsRegistry::EndFrame() {
+  ZoneScoped;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    for (auto& [name, entry] : counters_) {
+      uint64_t value = entry.metric.Value();
+      entry.per_frame[history_idx_] = static_cast<float>(value - entry.last_frame_value);
+      entry.last_frame_value = value;
+    }
+    for (auto& [name, entry] : gauges_) {
+      entry.per_frame[history_idx_] = static_cast<float>(entry.metric.Value());
+    }
+    history_idx_ = (history_idx_ + 1) % kHistoryFrames;
+    frame_count_++;
+  }
+  if (!dump_path_.empty() &&
+      SecondsBetween(last_dump_time_, std::chrono::steady_clock::now()) >= dump_interval_seconds_) {
+    Dump();
+  }
+}
+
+void MetricsRegistry::SetDumpPath(const std::string& path, double interval_seconds) {
+  dump_path_ = path;
+  dump_interval_seconds_ = std::max(interval_seconds, 0.0);
+  std::snprintf(dump_path_input_, sizeof(dump_path_input_), "%s", path.c_str());
+}
+
+void MetricsRegistry::Dump() {
+  ZoneScoped;
+  if (dump_path_.empty()) return;
+  auto now = std::chrono::steady_clock::now();
+  double time_s = SecondsBetween(start_time_, now);
+  double interval = std::max(SecondsBetween(last_dump_time_, now), 1e-6);
+  last_dump_time_ = now;
+
+  bool csv = std::filesystem::path(dump_path_).extension() == ".csv";
+  bool write_header = csv && (!std::filesystem::exists(dump_path_) ||
+                              std::filesystem::file_size(dump_path_) == 0);
+  std::ofstream f(dump_path_, std::ios::app);
+  if (!f.is_open()) {
+    spdlog::error("Failed to open metrics dump file: {}", dump_path_);
+    dump_path_.clear();
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  // counters report the total and the rate over the interval, histograms only the values recorded
+  // during the interval
+  if (csv) {
+    if (write_header) f << "time_s,type,name,value,rate,count,mean,p50,p90,p99,max\n";
+    for (auto& [name, entry] : counters_) {
+      uint64_t value = entry.metric.Value();
+      f << fmt::format("{:.3f},counter,{},{},{:.3f},,,,,,\n", time_s, name, value,
+                       static_cast<double>(value - entry.last_dump_value) / interval);
+      entry.last_dump_value = value;
+    }
+    for (auto& [name, entry] : gauges_) {
+      f << fmt::format("{:.3f},gauge,{},{},,,,,,,\n", time_s, name, entry.metric.Value());
+    }
+    for (auto& [name, entry] : histograms_) {
+      auto snapshot = entry.metric.TakeSnapshot();
+      auto s = snapshot.Since(entry.last_dump);
+      f << fmt::format("{:.3f},histogram,{},,,{},{:.3f},{},{},{},{}\n", time_s, name, s.count,
+                       s.Mean(), s.Percentile(0.5), s.Percentile(0.9), s.Percentile(0.99), s.max);
+      entry.last_dump = snapshot;
+    }
+  } else {
+    nlohmann::json j = {{"time_s", time_s}, {"frame", frame_count_}};
+    auto& j_counters = j["counters"] = nlohmann::json::object();
+    for (auto& [name, entry] : counters_) {
+      uint64_t value = entry.metric.Value();
+      j_counters[name] = {
+          {"value", value},
+          {"rate", static_cast<double>(value - entry.last_dump_value) / interval}};
+      entry.last_dump_value = value;
+    }
+    auto& j_gauges = j["gauges"] = nlohmann::json::object();
+    for (auto& [name, entry] : gauges_) j_gauges[name] = entry.metric.Value();
+    auto& j_histograms = j["histograms"] = nlohmann::json::object();
+    for (auto& [name, entry] : histograms_) {
+      auto snapshot = entry.metric.TakeSnapshot();
+      auto s = snapshot.Since(entry.last_dump);
+      j_histograms[name] = {{"count", s.count},         {"mean", s.Mean()},
+                            {"p50", s.Percentile(0.5)}, {"p90", s.Percentile(0.9)},
+                            {"p99", s.Percentile(0.99)}, {"max", s.max}};
+      entry.last_dump = snapshot;
+    }
+    f << j.dump() << '\n';
+  }
+}
+
+void MetricsRegistry::OnImGui() {
+  ZoneScoped;
+  if (!ImGui::CollapsingHeader("Metrics")) return;
+  ImGui::InputText("Dump path", dump_path_input_, sizeof(dump_path_input_));
+  float interval = static_cast<float>(dump_interval_seconds_);
+  ImGui::SliderFloat("Dump interval (s)", &interval, 1, 120);
+  if (ImGui::Button("Apply dump settings")) SetDumpPath(dump_path_input_, interval);
+  ImGui::SameLine();
+  ImGui::BeginDisabled(dump_path_.empty());
+  if (ImGui::Button("Dump now")) Dump();
+  ImGui::EndDisabled();
+
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (ImGui::TreeNode("Counters")) {
+    for (const auto& [name, entry] : counters_) {
+      ImGui::Text("%s: %lu (%.0f last frame)", name.c_str(),
+                  static_cast<unsigned long>(entry.metric.Value()),
+                  entry.per_frame[(history_idx_ + kHistoryFrames - 1) % kHistoryFrames]);
+      ImGui::PushID(name.c_str());
+      ImGui::PlotLines("##per_frame", entry.per_frame.data(), kHistoryFrames, history_idx_,
+                       nullptr, 0, FLT_MAX, ImVec2(0, 40));
+      ImGui::PopID();
+    }
+    ImGui::TreePop();
+  }
+  if (ImGui::TreeNode("Gauges")) {
+    for (const auto& [name, entry] : gauges_) {
+      ImGui::Text("%s: %.2f", name.c_str(), entry.metric.Value());
+      ImGui::PushID(name.c_str());
+      ImGui::PlotLines("##per_frame", entry.per_frame.data(), kHistoryFrames, history_idx_,
+                       nullptr, 0, FLT_MAX, ImVec2(0, 40));
+      ImGui::PopID();
+    }
+    ImGui::TreePop();
+  }
+  if (ImGui::TreeNode("Histograms")) {
+    if (ImGui::BeginTable("histograms", 7, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+      for (const char* header : {"name", "count", "mean", "p50", "p90", "p99", "max"}) {
+        ImGui::TableSetupColumn(header);
+      }
+      ImGui::TableHeadersRow();
+      for (const auto& [name, entry] : histograms_) {
+        auto s = entry.metric.TakeSnapshot();
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(name.c_str());
+        ImGui::TableNextColumn();
+        ImGui::Text("%lu", static_cast<unsigned long>(s.count));
+        ImGui::TableNextColumn();
+        ImGui::Text("%.1f", s.Mean());
+        for (double p : {0.5, 0.9, 0.99}) {
+          ImGui::TableNextColumn();
+          ImGui::Text("%lu", static_cast<unsigned long>(s.Percentile(p)));
+        }
+        ImGui::TableNextColumn();
+        ImGui::Text("%lu", static_cast<unsigned long>(s.max));
+      }
+      ImGui::EndTable();
+    }
+    ImGui::TreePop();
+  }
+}
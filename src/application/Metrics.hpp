@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+
+// Lock-free metrics any thread can record into. Look a metric up once and keep the reference, e.g.
+//   static auto& latency = MetricsRegistry::Get().GetHistogram("chunk.mesh_us");
+//   latency.Record(us);
+// Registration locks, recording never does.
+
+class MetricCounter {
+ public:
+  inline void Add(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+  [[nodiscard]] inline uint64_t Value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> value_{0};
+};
+
+class MetricGauge {
+ public:
+  inline void Set(double value) { value_.store(value, std::memory_order_relaxed); }
+  [[nodiscard]] inline double Value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<double> value_{0};
+};
+
+// Log-linear buckets like HdrHistogram: values below 16 are exact, above that each power of two is
+// split into 16 buckets, so percentiles are within ~6%. Values are unitless, names say the unit.
+class MetricHistogram {
+ public:
+  static constexpr int kSubBucketBits = 4;
+  static constexpr int kSubBuckets = 1 << kSubBucketBits;
+  // values are clamped to below 2^(kMaxExponent + 1)
+  static constexpr int kMaxExponent = 40;
+  static constexpr int kNumBuckets = kSubBuckets + (kMaxExponent - kSubBucketBits + 1) * kSubBuckets;
+
+  void Record(uint64_t value);
+
+  struct Snapshot {
+    std::array<uint64_t, kNumBuckets> buckets{};
+    uint64_t count{};
+    uint64_t sum{};
+    uint64_t max{};
+    // p in [0, 1]
+    [[nodiscard]] uint64_t Percentile(double p) const;
+    [[nodiscard]] double Mean() const;
+    // the values recorded since an earlier snapshot of the same histogram, max is the overall max
+    [[nodiscard]] Snapshot Since(const Snapshot& earlier) const;
+  };
+  [[nodiscard]] Snapshot TakeSnapshot() const;
+
+  [[nodiscard]] static int BucketIndex(uint64_t value);
+  // middle of the values that fall in the bucket
+  [[nodiscard]] static uint64_t BucketValue(int index);
+
+ private:
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets_{};
+  std::atomic<uint64_t> count_{0};
+  std::atomic<uint64_t> sum_{0};
+  std::atomic<uint64_t> max_{0};
+};
+
+// Records the microseconds between construction and destruction.
+class ScopedMetricTimer {
+ public:
+  explicit ScopedMetricTimer(MetricHistogram& histogram)
+      : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+  ~ScopedMetricTimer() {
+    histogram_.Record(std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now() - start_)
+                          .count());
+  }
+  ScopedMetricTimer(const ScopedMetricTimer&) = delete;
+  ScopedMetricTimer& operator=(const ScopedMetricTimer&) = delete;
+
+ private:
+  MetricHistogram& histogram_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+class MetricsRegistry {
+ public:
+  // Lives for the whole program so worker threads can hold references safely.
+  static MetricsRegistry& Get();
+
+  // Creates the metric the first time a name is used. References stay valid.
+  MetricCounter& GetCounter(std::string_view name);
+  MetricGauge& GetGauge(std::string_view name);
+  MetricHistogram& GetHistogram(std::string_view name);
+
+  // Call once per frame from the main thread. Samples per-frame counter deltas and gauges for the
+  // panel, and dumps when the dump interval has passed.
+  void EndFrame();
+
+  // Appends to path every interval_seconds. A .csv path gets one row per metric per dump, anything
+  // else gets one JSON object per line. Empty path disables dumping.
+  void SetDumpPath(const std::string& path, double interval_seconds);
+  [[nodiscard]] const std::string& GetDumpPath() const { return dump_path_; }
+  [[nodiscard]] double GetDumpIntervalSeconds() const { return dump_interval_seconds_; }
+  void Dump();
+
+  void OnImGui();
+
+  static constexpr int kHistoryFrames = 240;
+
+ private:
+  MetricsRegistry() = default;
+
+  struct CounterEntry {
+    MetricCounter metric;
+    uint64_t last_frame_value{};
+    uint64_t last_dump_value{};
+    std::array<float, kHistoryFrames> per_frame{};
+  };
+  struct GaugeEntry {
+    MetricGauge metric;
+    std::array<float, kHistoryFrames> per_frame{};
+  };
+  struct HistogramEntry {
+    MetricHistogram metric;
+    MetricHistogram::Snapshot last_dump;
+  };
+  // std::map nodes don't move, so references handed out stay valid
+  std::mutex mtx_;
+  std::map<std::string, CounterEntry, std::less<>> counters_;
+  std::map<std::string, GaugeEntry, std::less<>> gauges_;
+  std::map<std::string, HistogramEntry, std::less<>> histograms_;
+
+  int history_idx_{0};
+  uint64_t frame_count_{0};
+  std::chrono::steady_clock::time_point start_time_{std::chrono::steady_clock::now()};
+  std::chrono::steady_clock::time_point last_dump_time_{std::chrono::steady_clock::now()};
+  std::string dump_path_;
+  double dump_interval_seconds_{10};
+  char dump_path_input_[256]{};
+};
@@ -0,0 +1,97 @@
+#include "BenchSuite.hpp"
+
+#include <cmath>
+
+#include "util/Timer.hpp"
+
+namespace {
+
+double Percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0;
+  auto idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+  return sorted[idx];
+}
+
+}  // namespace
+
+BenchSuite::BenchSuite(std::string filter) : filter_(std::move(filter)) {}
+
+bool BenchSuite::ShouldRun(const std::string& name) const {
+  return filter_.empty() || name.find(filter_) != std::string::npos;
+}
+
+void BenchSuite::Run(const std::string& name, int iterations, int warmup_iterations,
+                     const RunFunc& run, const nlohmann::json& counters) {
+  Run(name, iterations, warmup_iterations, [](int) {}, run, counters);
+}
+
+void BenchSuite::Run(const std::string& name, int iterations, int warmup_iterations,
+                     const SetupFunc& setup, const RunFunc& run, const nlohmann::json& counters) {
+  if (!ShouldRun(name)) return;
+  spdlog::info("running {}", name);
+  for (int i = 0; i < warmup_iterations; i++) {
+    setup(i);
+    run(i);
+  }
+
+  std::vector<double> samples_ms;
+  samples_ms.reserve(iterations);
+  for (int i = 0; i < iterations; i++) {
+    setup(i);
+    Timer timer;
+    run(i);
+    samples_ms.emplace_back(timer.ElapsedMicro() * 0.001);
+  }
+
+  double sum = 0;
+  for (double s : samples_ms) sum += s;
+  double mean = samples_ms.empty() ? 0 : sum / static_cast<double>(samples_ms.size());
+  double variance = 0;
+  for (double s : samples_ms) variance += (s - mean) * (s - mean);
+  if (samples_ms.size() > 1) variance /= static_cast<double>(samples_ms.size() - 1);
+  std::sort(samples_ms.begin(), samples_ms.end());
+
+  results_.push_back({{"name", name},
+                      {"iterations", iterations},
+                      {"unit", "ms"},
+                      {"mean", mean},
+                      {"stddev", std::sqrt(variance)},
+                      {"min", samples_ms.empty() ? 0 : samples_ms.front()},
+                      {"p50", Percentile(samples_ms, 0.5)},
+                      {"p90", Percentile(samples_ms, 0.9)},
+                      {"p99", Percentile(samples_ms, 0.99)},
+                      {"max", samples_ms.empty() ? 0 : samples_ms.back()},
+                      {"counters", counters}});
+  spdlog::info("{}: mean {:.4f} ms, p50 {:.4f} ms, min {:.4f} ms", name, mean,
+               Percentile(samples_ms, 0.5), samples_ms.empty() ? 0 : samples_ms.front());
+}
+
+void BenchSuite::Skip(const std::string& name, const std::string& reason) {
+  if (!ShouldRun(name)) return;
+  spdlog::warn("skipping {}: {}", name, reason);
+  results_.push_back({{"name", name}, {"skipped", reason}});
+}
+
+void BenchSuite::Fail(const std::string& name, const std::string& reason) {
+  spdlog::error("{} failed: {}", name, reason);
+  failed_ = true;
+  for (auto& result : results_) {
+    if (result["name"] == name) {
+      result["failed"] = reason;
+      return;
+    }
+  }
+  results_.push_back({{"name", name}, {"failed", reason}});
+}
+
+void BenchSuite::SetCounter(const std::string& name, const std::string& counter,
+                            const nlohmann::json& value) {
+  for (auto& result : results_) {
+    if (result["name"] == name) {
+      result["counters"][counter] = value;
+      return;
+    }
+  }
+}
+
+nlohmann::json BenchSuite::ToJson() const { return results_; }
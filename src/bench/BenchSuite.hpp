@@ -0,0 +1,37 @@
+#pragma once
+
+#include <functional>
+#include <nlohmann/json.hpp>
+
+// Times benchmark iterations and collects the results as JSON so runs can be diffed across
+// commits.
+class BenchSuite {
+ public:
+  // Only benchmarks whose name contains filter are run. Empty runs all.
+  explicit BenchSuite(std::string filter);
+
+  using SetupFunc = std::function<void(int iteration)>;
+  using RunFunc = std::function<void(int iteration)>;
+  // Runs setup then run once per iteration after warmup_iterations untimed ones. Only run is
+  // timed. Counters are reported as is next to the timings, e.g. vertices per mesh.
+  void Run(const std::string& name, int iterations, int warmup_iterations, const SetupFunc& setup,
+           const RunFunc& run, const nlohmann::json& counters = nlohmann::json::object());
+  void Run(const std::string& name, int iterations, int warmup_iterations, const RunFunc& run,
+           const nlohmann::json& counters = nlohmann::json::object());
+  // Records a benchmark that can't run in this environment so it doesn't silently disappear.
+  void Skip(const std::string& name, const std::string& reason);
+  // Records a check the benchmark's results failed, like a determinism check. The bench exits with
+  // an error if any did.
+  void Fail(const std::string& name, const std::string& reason);
+  [[nodiscard]] bool Failed() const { return failed_; }
+  // Counters only known after the benchmark has run.
+  void SetCounter(const std::string& name, const std::string& counter, const nlohmann::json& value);
+  [[nodiscard]] bool ShouldRun(const std::string& name) const;
+
+  [[nodiscard]] nlohmann::json ToJson() const;
+
+ private:
+  std::string filter_;
+  nlohmann::json results_ = nlohmann::json::array();
+  bool failed_{false};
+};
@@ -0,0 +1,1004 @@
+// Benchmarks the world pipeline kernels with fixed seeds and the real block and terrain data, and
+// writes the results as JSON for tracking regressions across commits.
+
+// SDL is only used for a GL context, main stays ours
+#define SDL_MAIN_HANDLED
+#include <SDL.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <BS_thread_pool.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <libcuckoo/cuckoohash_map.hh>
+#include <random>
+#include <thread>
+
+#include "application/JobSystem.hpp"
+#include "application/SettingsManager.hpp"
+#include "bench/BenchSuite.hpp"
+#include "gameplay/physics/VoxelPhysics.hpp"
+#include "gameplay/world/BlockDB.hpp"
+#include "gameplay/world/Chunk.hpp"
+#include "gameplay/world/ChunkGrid.hpp"
+#include "gameplay/world/ChunkHelpers.hpp"
+#include "gameplay/world/ChunkManager.hpp"
+#include "gameplay/world/ColumnHeightMap.hpp"
+#include "gameplay/world/SpiralOrder.hpp"
+#include "gameplay/world/Terrain.hpp"
+#include "gameplay/world/TerrainGenerator.hpp"
+#include "headless/HeadlessMeshSink.hpp"
+#include "renderer/ChunkMesher.hpp"
+#include "renderer/opengl/DynamicBuffer.hpp"
+#include "resource/ImageLoader.hpp"
+#include "util/LoadFile.hpp"
+#include "util/Paths.hpp"
+
+namespace {
+
+struct Options {
+  int seed{1337};
+  // scales every benchmark's iteration count
+  float iterations_scale{1.f};
+  std::string filter;
+  // stdout if empty
+  std::string out_path;
+};
+
+void PrintUsage() {
+  spdlog::info("usage: voxels_bench [--seed N] [--iterations-scale F] [--filter NAME] [--out PATH]");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--seed" && has_value) {
+      options.seed = std::atoi(argv[++i]);
+    } else if (arg == "--iterations-scale" && has_value) {
+      options.iterations_scale = static_cast<float>(std::atof(argv[++i]));
+    } else if (arg == "--filter" && has_value) {
+      options.filter = argv[++i];
+    } else if (arg == "--out" && has_value) {
+      options.out_path = argv[++i];
+    } else {
+      return false;
+    }
+  }
+  return options.iterations_scale > 0;
+}
+
+ChunkStackArray MakeColumn(const glm::ivec2& pos) {
+  ChunkStackArray column;
+  for (int y = 0; y < kNumVerticalChunks; y++) {
+    column[y] = std::make_shared<Chunk>(glm::ivec3{pos.x, y, pos.y});
+  }
+  return column;
+}
+
+// The columns in [-radius, radius] around the origin with generated terrain, for meshing.
+struct WorldFixture {
+  int radius;
+  std::vector<ChunkStackArray> columns;
+
+  // empty columns, generated later with GenerateColumn
+  explicit WorldFixture(int radius) : radius(radius) {
+    for (int z = -radius; z <= radius; z++) {
+      for (int x = -radius; x <= radius; x++) columns.emplace_back(MakeColumn({x, z}));
+    }
+  }
+
+  WorldFixture(int radius, int seed, const Terrain& terrain) : WorldFixture(radius) {
+    for (size_t i = 0; i < columns.size(); i++) GenerateColumn(i, seed, terrain);
+  }
+
+  // safe to call for different columns at once
+  void GenerateColumn(size_t index, int seed, const Terrain& terrain) {
+    int len = radius * 2 + 1;
+    glm::ivec2 pos{static_cast<int>(index) % len - radius, static_cast<int>(index) / len - radius};
+    ColumnHeightMap heights;
+    TerrainGenerator{columns[index], pos * kChunkLength, seed, terrain}.GenerateBiome(heights);
+  }
+
+  // LOD meshing reads the downsampled blocks
+  void DownSample() {
+    for (auto& column : columns) {
+      for (auto& chunk : column) chunk->data.DownSample();
+    }
+  }
+
+  [[nodiscard]] size_t ColumnIndex(int x, int z) const {
+    return (z + radius) * (radius * 2 + 1) + x + radius;
+  }
+
+  [[nodiscard]] const ChunkStackArray& GetColumn(int x, int z) const {
+    return columns[ColumnIndex(x, z)];
+  }
+
+  [[nodiscard]] std::shared_ptr<Chunk> GetChunk(const glm::ivec3& pos) const {
+    if (std::abs(pos.x) > radius || std::abs(pos.z) > radius || pos.y < 0 ||
+        pos.y >= kNumVerticalChunks) {
+      return nullptr;
+    }
+    return GetColumn(pos.x, pos.z)[pos.y];
+  }
+
+  void PopulateNeighbors(ChunkNeighborArray& neighbors, const glm::ivec3& pos) const {
+    for (int y = -1; y <= 1; y++) {
+      for (int z = -1; z <= 1; z++) {
+        for (int x = -1; x <= 1; x++) {
+          neighbors[ChunkNeighborOffsetToIdx(x, y, z)] = GetChunk(pos + glm::ivec3{x, y, z});
+        }
+      }
+    }
+  }
+};
+
+int Scaled(const Options& options, int iterations) {
+  return std::max(1, static_cast<int>(static_cast<float>(iterations) * options.iterations_scale));
+}
+
+void BenchTerrain(BenchSuite& suite, const Options& options, const Terrain& terrain) {
+  // a spread of positions so more than one biome is covered
+  constexpr int kNumColumns = 16;
+  std::vector<glm::ivec2> positions;
+  std::mt19937 rng(options.seed);
+  std::uniform_int_distribution<int> dist(-512, 512);
+  for (int i = 0; i < kNumColumns; i++) positions.emplace_back(dist(rng), dist(rng));
+
+  ChunkStackArray column;
+  ColumnHeightMap heights;
+  suite.Run(
+      "terrain_generate_biome", Scaled(options, 64), 4,
+      [&](int) {
+        column = MakeColumn({});
+        heights = ColumnHeightMap{};
+      },
+      [&](int i) {
+        glm::ivec2 pos = positions[i % kNumColumns];
+        TerrainGenerator{column, pos * kChunkLength, options.seed, terrain}.GenerateBiome(heights);
+      },
+      {{"per", "column"}, {"columns", kNumColumns}});
+}
+
+// Takes the world before it's downsampled, DownSample returns early on chunks already done.
+void BenchDownSample(BenchSuite& suite, const Options& options, const WorldFixture& world) {
+  std::vector<ChunkData> sources;
+  for (const auto& column : world.columns) {
+    for (const auto& chunk : column) {
+      if (chunk->data.GetBlockCount() > 0) sources.emplace_back(chunk->data);
+    }
+  }
+  if (sources.empty()) {
+    suite.Skip("chunk_data_downsample", "no non-empty chunks in the fixture");
+    return;
+  }
+  ChunkData data;
+  suite.Run(
+      "chunk_data_downsample", Scaled(options, 256), 8,
+      [&](int i) { data = sources[i % sources.size()]; }, [&](int) { data.DownSample(); },
+      {{"per", "chunk"}, {"chunks", sources.size()}});
+}
+
+void BenchMesher(BenchSuite& suite, const Options& options, const BlockDB& block_db,
+                 const WorldFixture& world) {
+  ChunkMesher mesher{block_db.GetBlockData(), block_db.GetMeshData()};
+
+  // the center column of the fixture, every chunk has all of its neighbors
+  std::vector<ChunkNeighborArray> neighbor_arrays;
+  for (int y = 0; y < kNumVerticalChunks; y++) {
+    ChunkNeighborArray neighbors;
+    world.PopulateNeighbors(neighbors, {0, y, 0});
+    neighbor_arrays.emplace_back(neighbors);
+  }
+  std::vector<MeshVerticesIndices> out(kNumVerticalChunks);
+  suite.Run(
+      "mesher_greedy", Scaled(options, 32), 2,
+      [&](int) {
+        for (auto& o : out) o = {};
+      },
+      [&](int) {
+        for (int y = 0; y < kNumVerticalChunks; y++) {
+          mesher.GenerateGreedy(neighbor_arrays[y], out[y]);
+        }
+      },
+      {{"per", "column"}});
+  uint64_t vertices = 0;
+  uint64_t indices = 0;
+  for (const auto& o : out) {
+    vertices += o.opaque_vertices.size() + o.transparent_vertices.size();
+    indices += o.opaque_indices.size() + o.transparent_indices.size();
+  }
+  suite.SetCounter("mesher_greedy", "vertices", vertices);
+  suite.SetCounter("mesher_greedy", "indices", indices);
+
+  std::vector<ChunkVertex> lod_vertices;
+  std::vector<uint32_t> lod_indices;
+  suite.Run(
+      "mesher_lod_greedy2", Scaled(options, 64), 4,
+      [&](int) {
+        lod_vertices.clear();
+        lod_indices.clear();
+      },
+      [&](int) { mesher.GenerateLODGreedy2(world.GetColumn(0, 0), lod_vertices, lod_indices); },
+      {{"per", "column"}});
+  suite.SetCounter("mesher_lod_greedy2", "vertices", lod_vertices.size());
+  suite.SetCounter("mesher_lod_greedy2", "indices", lod_indices.size());
+}
+
+void BenchSpiral(BenchSuite& suite, const Options& options, ChunkManager& chunk_manager) {
+  for (int load_distance : {16, 48}) {
+    uint64_t sum = 0;
+    int load_len = load_distance * 2 + 1;
+    suite.Run(
+        "chunk_manager_spiral_" + std::to_string(load_distance), Scaled(options, 256), 8,
+        [&](int) {
+          chunk_manager.IterateChunks(load_distance,
+                                      [&sum](const glm::ivec2& pos) { sum += pos.x ^ pos.y; });
+        },
+        {{"per", "iteration"}, {"positions", load_len * load_len}});
+    // keeps the visitor from being optimized out
+    suite.SetCounter("chunk_manager_spiral_" + std::to_string(load_distance), "checksum", sum);
+
+    // the columns a one column step exposes, what AddFrontierChunks walks instead of the square
+    const std::string frontier_name = "spiral_frontier_" + std::to_string(load_distance);
+    uint64_t frontier_sum = 0;
+    suite.Run(
+        frontier_name, Scaled(options, 256), 8,
+        [&](int i) {
+          util::spiral::ForEachFrontier({i + 1, 0}, {i, 0}, load_distance,
+                                        [&frontier_sum](const glm::ivec2& pos) {
+                                          frontier_sum += pos.x ^ pos.y;
+                                        });
+        },
+        {{"per", "iteration"}, {"positions", load_len}});
+    suite.SetCounter(frontier_name, "checksum", frontier_sum);
+  }
+}
+
+// Random chunk lookups in the cuckoo map the chunk manager used to keep its chunks in against the
+// chunk grid, from a worker (find_fn) and from the main thread (Peek). An eighth of the lookups
+// miss, like lookups past the edge of the loaded range.
+void BenchChunkLookup(BenchSuite& suite, const Options& options) {
+  constexpr int kRadius = 32;
+  constexpr int kLookups = 1 << 16;
+  const std::string cuckoo_name = "chunk_lookup_cuckoo";
+  const std::string grid_name = "chunk_lookup_grid";
+  const std::string peek_name = "chunk_lookup_grid_peek";
+  if (!suite.ShouldRun(cuckoo_name) && !suite.ShouldRun(grid_name) && !suite.ShouldRun(peek_name)) {
+    return;
+  }
+
+  libcuckoo::cuckoohash_map<glm::ivec3, std::shared_ptr<Chunk>> cuckoo_map;
+  ChunkGrid grid{kRadius};
+  for (int z = -kRadius; z <= kRadius; z++) {
+    for (int x = -kRadius; x <= kRadius; x++) {
+      auto column = std::make_shared<ChunkColumn>(glm::ivec2{x, z});
+      for (int y = 0; y < kNumVerticalChunks; y++) cuckoo_map.insert({x, y, z}, column->chunks[y]);
+      grid.InsertColumn(std::move(column));
+    }
+  }
+  std::mt19937 rng(options.seed);
+  std::uniform_int_distribution<int> xz_dist(-kRadius * 17 / 16, kRadius * 17 / 16);
+  std::uniform_int_distribution<int> y_dist(0, kNumVerticalChunks - 1);
+  std::vector<glm::ivec3> positions(kLookups);
+  for (auto& p : positions) p = {xz_dist(rng), y_dist(rng), xz_dist(rng)};
+
+  nlohmann::json counters = {{"per", "iteration"}, {"lookups", kLookups}, {"radius", kRadius}};
+  uint64_t found = 0;
+  auto count_found = [&found](const std::shared_ptr<Chunk>& chunk) { found += chunk != nullptr; };
+  suite.Run(
+      cuckoo_name, Scaled(options, 64), 4,
+      [&](int) {
+        for (const auto& p : positions) cuckoo_map.find_fn(p, count_found);
+      },
+      counters);
+  suite.SetCounter(cuckoo_name, "found", found);
+  found = 0;
+  suite.Run(
+      grid_name, Scaled(options, 64), 4,
+      [&](int) {
+        for (const auto& p : positions) grid.find_fn(p, count_found);
+      },
+      counters);
+  suite.SetCounter(grid_name, "found", found);
+  found = 0;
+  suite.Run(
+      peek_name, Scaled(options, 64), 4,
+      [&](int) {
+        for (const auto& p : positions) found += grid.Peek(p) != nullptr;
+      },
+      counters);
+  suite.SetCounter(peek_name, "found", found);
+}
+
+double MsSince(std::chrono::steady_clock::time_point start) {
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration<double, std::milli>(elapsed).count();
+}
+
+// Percentiles of samples in whatever unit they were taken in.
+nlohmann::json LatencyCounters(std::vector<double> samples) {
+  std::ranges::sort(samples);
+  auto at = [&samples](double p) {
+    if (samples.empty()) return 0.0;
+    return samples[static_cast<size_t>(p * static_cast<double>(samples.size() - 1))];
+  };
+  return {{"p50", at(0.5)}, {"p90", at(0.9)}, {"p99", at(0.99)}, {"max", at(1.0)}};
+}
+
+// Loads every column within the load distance of the origin, meshes included.
+void LoadWorld(ChunkManager& chunk_manager) {
+  chunk_manager.Init({0, 0, 0});
+  while (!chunk_manager.IsLoaded() ||
+         chunk_manager.GetStateStats().loaded_chunks < chunk_manager.GetStateStats().max_chunks) {
+    chunk_manager.Update(0);
+    std::this_thread::yield();
+  }
+}
+
+// Lets the relights and remeshes queued by edits finish.
+void Settle(ChunkManager& chunk_manager) {
+  while (!chunk_manager.IsLoaded()) {
+    chunk_manager.Update(0);
+    std::this_thread::yield();
+  }
+}
+
+// Macro benchmark: a full initial load of terrain, lighting and meshing on the thread pool.
+void BenchChunkManagerLoad(BenchSuite& suite, const Options& options, BlockDB& block_db) {
+  constexpr int kLoadDistance = 8;
+  const std::string name = "chunk_manager_initial_load";
+  if (!suite.ShouldRun(name)) return;
+  nlohmann::json settings = {{"load_distance", kLoadDistance}};
+  SettingsManager::Get().SaveSetting(settings, "chunk_manager");
+
+  HeadlessMeshSink mesh_sink;
+  std::unique_ptr<ChunkManager> chunk_manager;
+  uint32_t columns = 0;
+  suite.Run(
+      name, Scaled(options, 3), 0,
+      [&](int) {
+        chunk_manager = std::make_unique<ChunkManager>(block_db, mesh_sink);
+        chunk_manager->SetSeed(options.seed);
+      },
+      [&](int) {
+        LoadWorld(*chunk_manager);
+        columns = chunk_manager->GetStateStats().loaded_chunks / kNumVerticalChunks;
+      },
+      {{"per", "load"}, {"load_distance", kLoadDistance}});
+  chunk_manager = nullptr;
+  suite.SetCounter(name, "columns", columns);
+  suite.SetCounter(name, "meshes", mesh_sink.GetStats().allocs);
+  suite.SetCounter(name, "mesh_bytes", mesh_sink.GetStats().bytes_allocated);
+}
+
+// Per-block SetBlock against one SetBlocks of the same edits, and the box and sphere fills, into
+// a region of air at the top of a loaded world. Each case is timed until the relights and remeshes
+// queued by its edits are done, so work left to Update counts as much as work done in the call.
+// The settle part is also reported on its own. Setup clears the region untimed.
+void BenchEdits(BenchSuite& suite, const Options& options, ChunkManager& chunk_manager,
+                BlockType block) {
+  constexpr int kEditLength = 64;
+  const glm::ivec3 min{-kChunkLength, kMaxBlockHeight - kEditLength, -kChunkLength};
+  const glm::ivec3 max = min + kEditLength - 1;
+  std::vector<BlockEdit> edits;
+  edits.reserve(kEditLength * kEditLength * kEditLength);
+  glm::ivec3 pos;
+  for (pos.y = min.y; pos.y <= max.y; pos.y++) {
+    for (pos.z = min.z; pos.z <= max.z; pos.z++) {
+      for (pos.x = min.x; pos.x <= max.x; pos.x++) edits.emplace_back(BlockEdit{pos, block});
+    }
+  }
+  auto clear = [&](int) {
+    chunk_manager.FillBox(min, max, 0);
+    Settle(chunk_manager);
+  };
+  std::vector<double> settle_ms;
+  auto run = [&](const std::string& name, int iterations, const std::function<void()>& edit) {
+    if (!suite.ShouldRun(name)) return;
+    iterations = Scaled(options, iterations);
+    settle_ms.clear();
+    suite.Run(
+        name, iterations, 1, clear,
+        [&](int) {
+          edit();
+          auto start = std::chrono::steady_clock::now();
+          Settle(chunk_manager);
+          settle_ms.emplace_back(MsSince(start));
+        },
+        {{"per", "edit"}, {"region_blocks", edits.size()}});
+    // without the warmup's
+    suite.SetCounter(name, "settle_ms", LatencyCounters({settle_ms.end() - iterations,
+                                                         settle_ms.end()}));
+  };
+
+  run("edit_set_block", 4, [&] {
+    for (const auto& e : edits) chunk_manager.SetBlock(e.pos, e.block);
+  });
+  run("edit_set_blocks", 16, [&] { chunk_manager.SetBlocks(edits); });
+  run("edit_fill_box", 16, [&] { chunk_manager.FillBox(min, max, block); });
+  run("edit_fill_sphere", 16,
+      [&] { chunk_manager.FillSphere(min + kEditLength / 2, kEditLength / 2 - 1, block); });
+  clear(0);
+}
+
+// A light emitting block placed on the surface and removed again, one SetBlock each, like placing
+// and breaking a torch. SetBlock relights before it returns, so that's all on the main thread.
+void BenchTorchEdit(BenchSuite& suite, const Options& options, const BlockDB& block_db,
+                    ChunkManager& chunk_manager) {
+  constexpr int kPositions = 64;
+  constexpr double kMaxP99Us = 1000.0;
+  const std::string name = "edit_torch";
+  if (!suite.ShouldRun(name)) return;
+  const auto& block_data = block_db.GetBlockData();
+  auto torch = std::ranges::find_if(block_data, [](const BlockData& d) { return d.emits_light; });
+  if (torch == block_data.end()) {
+    suite.Skip(name, "no block emits light");
+    return;
+  }
+
+  // the air above the surface of the 3x3 chunks around the origin
+  std::vector<glm::ivec3> positions;
+  std::mt19937 rng(options.seed);
+  std::uniform_int_distribution<int> xz_dist(-kChunkLength, kChunkLength * 2 - 1);
+  for (int i = 0; i < kPositions; i++) {
+    glm::ivec3 pos{xz_dist(rng), 0, xz_dist(rng)};
+    pos.y = chunk_manager.GetHeight(pos.x, pos.z) + 1;
+    if (pos.y > 0 && pos.y < kMaxBlockHeight && chunk_manager.GetBlock(pos) == 0) {
+      positions.emplace_back(pos);
+    }
+  }
+
+  std::vector<double> latencies_us;
+  auto timed_set = [&](const glm::ivec3& pos, BlockType block) {
+    auto start = std::chrono::steady_clock::now();
+    chunk_manager.SetBlock(pos, block);
+    latencies_us.emplace_back(MsSince(start) * 1000.0);
+  };
+  suite.Run(
+      name, Scaled(options, 8), 1, [&](int) { Settle(chunk_manager); },
+      [&](int) {
+        for (const auto& pos : positions) {
+          timed_set(pos, torch->id);
+          timed_set(pos, 0);
+        }
+      },
+      {{"per", "run"}, {"edits", positions.size() * 2}, {"emission", kMaxLightLevel}});
+  Settle(chunk_manager);
+  nlohmann::json latency = LatencyCounters(std::move(latencies_us));
+  suite.SetCounter(name, "latency_us", latency);
+  if (latency["p99"].get<double>() > kMaxP99Us) {
+    suite.Fail(name, "p99 edit took " + std::to_string(latency["p99"].get<double>()) +
+                         " us, over " + std::to_string(kMaxP99Us));
+  }
+}
+
+// Reads every block of the full columns of the 3x3 chunks around the origin, x fastest like a scan
+// or a ray: a chunk map lookup per block, the accessor's cached chunk, and one bulk GetBlocks.
+void BenchBlockAccess(BenchSuite& suite, const Options& options,
+                      const ChunkManager& chunk_manager) {
+  const glm::ivec3 min{-kChunkLength, 0, -kChunkLength};
+  const glm::ivec3 max{kChunkLength * 2 - 1, kMaxBlockHeight - 1, kChunkLength * 2 - 1};
+  const glm::ivec3 dims = max - min + 1;
+  const nlohmann::json counters = {{"per", "region"}, {"blocks", dims.x * dims.y * dims.z}};
+  auto for_each_pos = [&min, &max](auto&& fn) {
+    glm::ivec3 pos;
+    for (pos.y = min.y; pos.y <= max.y; pos.y++) {
+      for (pos.z = min.z; pos.z <= max.z; pos.z++) {
+        for (pos.x = min.x; pos.x <= max.x; pos.x++) fn(pos);
+      }
+    }
+  };
+
+  // sums keep the reads from being optimized out and check the paths agree
+  uint64_t get_block_sum = 0;
+  suite.Run(
+      "block_access_get_block", Scaled(options, 16), 1,
+      [&](int) {
+        get_block_sum = 0;
+        for_each_pos([&](const glm::ivec3& pos) {
+          if (chunk_manager.BlockPosExists(pos)) get_block_sum += chunk_manager.GetBlock(pos);
+        });
+      },
+      counters);
+  suite.SetCounter("block_access_get_block", "checksum", get_block_sum);
+
+  uint64_t accessor_sum = 0;
+  uint32_t lookups = 0;
+  suite.Run(
+      "block_access_accessor", Scaled(options, 16), 1,
+      [&](int) {
+        accessor_sum = 0;
+        BlockAccessor accessor = chunk_manager.GetBlockAccessor();
+        for_each_pos([&](const glm::ivec3& pos) { accessor_sum += accessor.GetBlock(pos); });
+        lookups = accessor.GetLookupCount();
+      },
+      counters);
+  suite.SetCounter("block_access_accessor", "checksum", accessor_sum);
+  suite.SetCounter("block_access_accessor", "lookups", lookups);
+
+  std::vector<BlockType> blocks(dims.x * dims.y * dims.z);
+  suite.Run(
+      "block_access_get_blocks", Scaled(options, 16), 1,
+      [&](int) { chunk_manager.GetBlockAccessor().GetBlocks(min, max, blocks, 0); }, counters);
+  uint64_t get_blocks_sum = 0;
+  for (BlockType block : blocks) get_blocks_sum += block;
+  suite.SetCounter("block_access_get_blocks", "checksum", get_blocks_sum);
+
+  if (suite.ShouldRun("block_access_get_block") && suite.ShouldRun("block_access_accessor") &&
+      suite.ShouldRun("block_access_get_blocks") &&
+      (get_block_sum != accessor_sum || get_block_sum != get_blocks_sum)) {
+    std::string reason = fmt::format("checksums differ: GetBlock {}, Accessor {}, GetBlocks {}",
+                                     get_block_sum, accessor_sum, get_blocks_sum);
+    suite.Fail("block_access_accessor", reason);
+    suite.Fail("block_access_get_blocks", reason);
+  }
+}
+
+// Thousands of bodies dropped onto the terrain with random horizontal velocities, stepped at a
+// fixed dt. Every iteration starts from the same bodies, so the end states must match bit for bit.
+void BenchPhysics(BenchSuite& suite, const Options& options, const BlockDB& block_db,
+                  const ChunkManager& chunk_manager) {
+  constexpr int kNumBodies = 4096;
+  constexpr int kTicks = 120;
+  constexpr float kDt = 1.f / 60.f;
+  const std::string name = "physics_step";
+  if (!suite.ShouldRun(name)) return;
+
+  std::vector<PhysicsBody> start_bodies(kNumBodies);
+  std::mt19937 rng(options.seed);
+  std::uniform_int_distribution<int> xz_dist(-kChunkLength * 2, kChunkLength * 2 - 1);
+  std::uniform_real_distribution<float> drop_dist(1.f, 16.f);
+  std::uniform_real_distribution<float> velocity_dist(-6.f, 6.f);
+  for (auto& body : start_bodies) {
+    int x = xz_dist(rng);
+    int z = xz_dist(rng);
+    int height = std::max(chunk_manager.GetHeight(x, z), 0);
+    body.position = {static_cast<float>(x) + 0.5f, static_cast<float>(height) + drop_dist(rng),
+                     static_cast<float>(z) + 0.5f};
+    body.velocity = {velocity_dist(rng), 0.f, velocity_dist(rng)};
+  }
+
+  VoxelPhysics physics{VoxelPhysics::PropsFromBlockDB(block_db),
+                       [&chunk_manager](const glm::ivec3& min, const glm::ivec3& max,
+                                        std::span<BlockType> out) {
+                         chunk_manager.GetBlocks(min, max, out, VoxelPhysics::kUnloadedBlock);
+                       }};
+  std::vector<PhysicsBody> bodies;
+  std::vector<PhysicsBody> first_end;
+  uint64_t neighborhood_loads = 0;
+  uint32_t mismatched_runs = 0;
+  auto same = [](const PhysicsBody& a, const PhysicsBody& b) {
+    return a.position == b.position && a.velocity == b.velocity && a.on_ground == b.on_ground;
+  };
+  suite.Run(
+      name, Scaled(options, 8), 1, [&](int) { bodies = start_bodies; },
+      [&](int) {
+        neighborhood_loads = 0;
+        for (int tick = 0; tick < kTicks; tick++) {
+          physics.Step(bodies, kDt);
+          neighborhood_loads += physics.GetStats().neighborhood_loads;
+        }
+        if (first_end.empty()) {
+          first_end = bodies;
+        } else if (!std::ranges::equal(bodies, first_end, same)) {
+          mismatched_runs++;
+        }
+      },
+      {{"per", "run"}, {"bodies", kNumBodies}, {"ticks", kTicks}, {"dt", kDt}});
+  if (mismatched_runs > 0) {
+    suite.Fail(name, std::to_string(mismatched_runs) + " runs ended differently than the first");
+  }
+  uint32_t on_ground = 0;
+  for (const auto& body : bodies) on_ground += body.on_ground;
+  suite.SetCounter(name, "body_steps", static_cast<uint64_t>(kNumBodies) * kTicks);
+  suite.SetCounter(name, "neighborhood_loads", neighborhood_loads);
+  suite.SetCounter(name, "on_ground", on_ground);
+  suite.SetCounter(name, "mismatched_runs", mismatched_runs);
+}
+
+// The benchmarks that need a world loaded with the bench seed, sharing one load.
+void BenchLoadedWorld(BenchSuite& suite, const Options& options, BlockDB& block_db,
+                      const Terrain& terrain) {
+  const std::array<std::string, 9> names = {
+      "edit_set_block",         "edit_set_blocks",        "edit_fill_box",
+      "edit_fill_sphere",       "edit_torch",             "block_access_get_block",
+      "block_access_accessor",  "block_access_get_blocks", "physics_step"};
+  if (std::ranges::none_of(names, [&suite](const std::string& n) { return suite.ShouldRun(n); })) {
+    return;
+  }
+  nlohmann::json settings = {{"load_distance", 4}};
+  SettingsManager::Get().SaveSetting(settings, "chunk_manager");
+  HeadlessMeshSink mesh_sink;
+  ChunkManager chunk_manager{block_db, mesh_sink};
+  chunk_manager.SetSeed(options.seed);
+  LoadWorld(chunk_manager);
+  BenchEdits(suite, options, chunk_manager, terrain.id_stone);
+  BenchTorchEdit(suite, options, block_db, chunk_manager);
+  BenchBlockAccess(suite, options, chunk_manager);
+  BenchPhysics(suite, options, block_db, chunk_manager);
+}
+
+// The load pipeline on the BS::thread_pool the chunk manager used to have and on the job system:
+// terrain and downsampling for every column of a square, then a mesh for each chunk of the inner
+// columns. The pool has no dependencies, so like the chunk manager's queues it waits for all the
+// terrain before meshing. On the job system each mesh runs as soon as the 3x3 columns around it
+// have terrain. Latency is from the start of the load to each mesh being done.
+void BenchJobPipeline(BenchSuite& suite, const Options& options, const BlockDB& block_db,
+                      const Terrain& terrain) {
+  constexpr int kRadius = 4;
+  const std::string pool_name = "job_pipeline_bs_thread_pool";
+  const std::string jobs_name = "job_pipeline_job_system";
+  if (!suite.ShouldRun(pool_name) && !suite.ShouldRun(jobs_name)) return;
+
+  std::vector<glm::ivec3> mesh_positions;
+  for (int z = -kRadius + 1; z < kRadius; z++) {
+    for (int x = -kRadius + 1; x < kRadius; x++) {
+      for (int y = 0; y < kNumVerticalChunks; y++) mesh_positions.emplace_back(x, y, z);
+    }
+  }
+  std::unique_ptr<WorldFixture> world;
+  std::vector<MeshVerticesIndices> meshes;
+  std::vector<double> iteration_latencies_ms(mesh_positions.size());
+  std::vector<double> latencies_ms;
+  std::chrono::steady_clock::time_point start;
+  auto setup = [&](int) {
+    world = std::make_unique<WorldFixture>(kRadius);
+    meshes.assign(mesh_positions.size(), {});
+  };
+  auto generate = [&](size_t i) {
+    world->GenerateColumn(i, options.seed, terrain);
+    for (auto& chunk : world->columns[i]) chunk->data.DownSample();
+  };
+  auto mesh = [&](size_t i) {
+    ChunkNeighborArray neighbors;
+    world->PopulateNeighbors(neighbors, mesh_positions[i]);
+    ChunkMesher mesher{block_db.GetBlockData(), block_db.GetMeshData()};
+    mesher.GenerateGreedy(neighbors, meshes[i]);
+    iteration_latencies_ms[i] = MsSince(start);
+  };
+  auto finish = [&](const std::string& name) {
+    uint64_t vertices = 0;
+    for (const auto& m : meshes) {
+      vertices += m.opaque_vertices.size() + m.transparent_vertices.size();
+    }
+    suite.SetCounter(name, "vertices", vertices);
+    suite.SetCounter(name, "latency_ms", LatencyCounters(std::move(latencies_ms)));
+    latencies_ms.clear();
+  };
+  const nlohmann::json counters = {{"per", "load"},
+                                   {"columns", (kRadius * 2 + 1) * (kRadius * 2 + 1)},
+                                   {"meshes", mesh_positions.size()}};
+
+  if (suite.ShouldRun(pool_name)) {
+    BS::thread_pool pool;
+    suite.Run(
+        pool_name, Scaled(options, 8), 0, setup,
+        [&](int) {
+          start = std::chrono::steady_clock::now();
+          for (size_t i = 0; i < world->columns.size(); i++) {
+            pool.detach_task([&generate, i] { generate(i); });
+          }
+          pool.wait();
+          for (size_t i = 0; i < mesh_positions.size(); i++) {
+            pool.detach_task([&mesh, i] { mesh(i); });
+          }
+          pool.wait();
+          latencies_ms.insert(latencies_ms.end(), iteration_latencies_ms.begin(),
+                              iteration_latencies_ms.end());
+        },
+        counters);
+    suite.SetCounter(pool_name, "workers", pool.get_thread_count());
+    finish(pool_name);
+  }
+
+  if (suite.ShouldRun(jobs_name)) {
+    JobSystem jobs;
+    jobs.Start();
+    std::vector<JobSystem::Handle> terrain_jobs;
+    suite.Run(
+        jobs_name, Scaled(options, 8), 0, setup,
+        [&](int) {
+          start = std::chrono::steady_clock::now();
+          terrain_jobs.clear();
+          for (size_t i = 0; i < world->columns.size(); i++) {
+            terrain_jobs.emplace_back(
+                jobs.Submit(JobSystem::Priority::kBackground, [&generate, i] { generate(i); }));
+          }
+          for (size_t i = 0; i < mesh_positions.size(); i++) {
+            std::array<JobSystem::Handle, 9> neighbor_terrain;
+            int n = 0;
+            for (int z = -1; z <= 1; z++) {
+              for (int x = -1; x <= 1; x++) {
+                neighbor_terrain[n++] = terrain_jobs[world->ColumnIndex(mesh_positions[i].x + x,
+                                                                        mesh_positions[i].z + z)];
+              }
+            }
+            jobs.Submit(JobSystem::Priority::kVisible, [&mesh, i] { mesh(i); }, neighbor_terrain);
+          }
+          jobs.WaitAll();
+          latencies_ms.insert(latencies_ms.end(), iteration_latencies_ms.begin(),
+                              iteration_latencies_ms.end());
+        },
+        counters);
+    suite.SetCounter(jobs_name, "workers", jobs.NumWorkers());
+    finish(jobs_name);
+  }
+}
+
+// Edit remeshes submitted behind a full queue of background terrain, what a block edit waits for
+// while the world streams in. BS::thread_pool runs them after the terrain in submission order. The
+// job system runs them at edit priority and the submitting thread helps while it waits, like the
+// chunk manager's immediate remesh. Latency is from submitting the edits to each being done.
+void BenchJobEditLatency(BenchSuite& suite, const Options& options, const BlockDB& block_db,
+                         const Terrain& terrain, const WorldFixture& edited) {
+  constexpr int kBackgroundRadius = 4;
+  const std::string pool_name = "job_edit_latency_bs_thread_pool";
+  const std::string jobs_name = "job_edit_latency_job_system";
+  if (!suite.ShouldRun(pool_name) && !suite.ShouldRun(jobs_name)) return;
+
+  // the center column of the edited fixture, every chunk has all of its neighbors
+  std::vector<ChunkNeighborArray> neighbor_arrays(kNumVerticalChunks);
+  for (int y = 0; y < kNumVerticalChunks; y++) {
+    edited.PopulateNeighbors(neighbor_arrays[y], {0, y, 0});
+  }
+  std::unique_ptr<WorldFixture> background;
+  std::vector<MeshVerticesIndices> meshes(kNumVerticalChunks);
+  std::vector<double> iteration_latencies_ms(kNumVerticalChunks);
+  std::vector<double> latencies_ms;
+  std::chrono::steady_clock::time_point start;
+  auto setup = [&](int) {
+    background = std::make_unique<WorldFixture>(kBackgroundRadius);
+    meshes.assign(kNumVerticalChunks, {});
+  };
+  auto generate = [&](size_t i) { background->GenerateColumn(i, options.seed, terrain); };
+  auto remesh = [&](int y) {
+    ChunkMesher mesher{block_db.GetBlockData(), block_db.GetMeshData()};
+    mesher.GenerateGreedy(neighbor_arrays[y], meshes[y]);
+    iteration_latencies_ms[y] = MsSince(start);
+  };
+  const nlohmann::json counters = {
+      {"per", "load"},
+      {"background_columns", (kBackgroundRadius * 2 + 1) * (kBackgroundRadius * 2 + 1)},
+      {"edits", kNumVerticalChunks}};
+  auto finish = [&](const std::string& name) {
+    suite.SetCounter(name, "edit_latency_ms", LatencyCounters(std::move(latencies_ms)));
+    latencies_ms.clear();
+  };
+
+  if (suite.ShouldRun(pool_name)) {
+    BS::thread_pool pool;
+    suite.Run(
+        pool_name, Scaled(options, 8), 0, setup,
+        [&](int) {
+          for (size_t i = 0; i < background->columns.size(); i++) {
+            pool.detach_task([&generate, i] { generate(i); });
+          }
+          start = std::chrono::steady_clock::now();
+          for (int y = 0; y < kNumVerticalChunks; y++) {
+            pool.detach_task([&remesh, y] { remesh(y); });
+          }
+          pool.wait();
+          latencies_ms.insert(latencies_ms.end(), iteration_latencies_ms.begin(),
+                              iteration_latencies_ms.end());
+        },
+        counters);
+    finish(pool_name);
+  }
+
+  if (suite.ShouldRun(jobs_name)) {
+    JobSystem jobs;
+    jobs.Start();
+    std::vector<JobSystem::Handle> edit_jobs;
+    suite.Run(
+        jobs_name, Scaled(options, 8), 0, setup,
+        [&](int) {
+          for (size_t i = 0; i < background->columns.size(); i++) {
+            jobs.Submit(JobSystem::Priority::kBackground, [&generate, i] { generate(i); });
+          }
+          start = std::chrono::steady_clock::now();
+          edit_jobs.clear();
+          for (int y = 0; y < kNumVerticalChunks; y++) {
+            edit_jobs.emplace_back(
+                jobs.Submit(JobSystem::Priority::kEdit, [&remesh, y] { remesh(y); }));
+          }
+          for (const auto& job : edit_jobs) jobs.Wait(job);
+          jobs.WaitAll();
+          latencies_ms.insert(latencies_ms.end(), iteration_latencies_ms.begin(),
+                              iteration_latencies_ms.end());
+        },
+        counters);
+    finish(jobs_name);
+  }
+}
+
+// The block texture decode at world load: the old serial stb path, the parallel loader decoding
+// every file, and the parallel loader reading back its cache.
+void BenchTextureDecode(BenchSuite& suite, const Options& options, const BlockDB& block_db) {
+  std::vector<std::string> paths;
+  for (const auto& tex_name : block_db.GetTextureNamesInUse()) {
+    paths.emplace_back(GET_PATH("resources/textures/" + tex_name + ".png"));
+  }
+  if (paths.empty()) {
+    suite.Skip("texture_decode_serial", "no textures in use");
+    return;
+  }
+  const nlohmann::json counters = {{"per", "load"}, {"textures", paths.size()}};
+
+  uint64_t checksum = 0;
+  suite.Run(
+      "texture_decode_serial", Scaled(options, 8), 1,
+      [&](int) {
+        for (const auto& path : paths) {
+          Image image;
+          util::LoadImage(image, path, 4, true);
+          if (!image.pixels) continue;
+          checksum += ImageLoader::AverageColor(image.pixels, image.width, image.height).x;
+          util::FreeImage(image.pixels);
+        }
+      },
+      counters);
+  suite.SetCounter("texture_decode_serial", "checksum", checksum);
+
+  {
+    ImageLoader loader{std::filesystem::path{}};
+    suite.Run(
+        "texture_decode_parallel", Scaled(options, 8), 1,
+        [&](int) {
+          auto images = loader.Load(paths, {.flip = true, .generate_mipmaps = true});
+          checksum += images.size();
+        },
+        counters);
+    suite.SetCounter("texture_decode_parallel", "decoded", loader.GetStats().decoded);
+  }
+
+  std::filesystem::path cache_dir =
+      std::filesystem::temp_directory_path() / "voxels_bench_image_cache";
+  std::filesystem::remove_all(cache_dir);
+  {
+    // the warmup iteration fills the cache
+    ImageLoader loader{cache_dir};
+    suite.Run(
+        "texture_decode_cached", Scaled(options, 8), 1,
+        [&](int) {
+          auto images = loader.Load(paths, {.flip = true, .generate_mipmaps = true});
+          checksum += images.size();
+        },
+        counters);
+    suite.SetCounter("texture_decode_cached", "cache_hits", loader.GetStats().cache_hits);
+  }
+  std::filesystem::remove_all(cache_dir);
+}
+
+// DynamicBuffer uploads with GL, so this needs a context. Build machines without a GPU or display
+// record it as skipped.
+void BenchDynamicBuffer(BenchSuite& suite, const Options& options) {
+  const std::string name = "dynamic_buffer_churn";
+  if (!suite.ShouldRun(name)) return;
+  if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+    suite.Skip(name, SDL_GetError());
+    return;
+  }
+  SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+  SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+  SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 6);
+  SDL_Window* window = SDL_CreateWindow("voxels_bench", SDL_WINDOWPOS_UNDEFINED,
+                                        SDL_WINDOWPOS_UNDEFINED, 1, 1,
+                                        SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+  SDL_GLContext context = window ? SDL_GL_CreateContext(window) : nullptr;
+  if (!context || !gladLoadGL()) {
+    suite.Skip(name, "no OpenGL 4.6 context");
+    if (context) SDL_GL_DeleteContext(context);
+    if (window) SDL_DestroyWindow(window);
+    SDL_Quit();
+    return;
+  }
+
+  {
+    // mesh sized allocations like the static chunk buffers, freed in random order
+    constexpr int kOpsPerIteration = 1000;
+    constexpr uint32_t kMaxVertices = 32'000;
+    std::vector<ChunkVertex> data(kMaxVertices);
+    DynamicBuffer<> buffer;
+    buffer.Init(sizeof(ChunkVertex) * 8'000'000, sizeof(ChunkVertex));
+    std::mt19937 rng(options.seed);
+    std::uniform_int_distribution<uint32_t> size_dist(256, kMaxVertices);
+    std::vector<uint32_t> handles;
+    uint64_t failed = 0;
+    suite.Run(
+        name, Scaled(options, 64), 2,
+        [&](int) {
+          for (int op = 0; op < kOpsPerIteration; op++) {
+            // grows to a steady state of roughly a few hundred live allocations
+            if (!handles.empty() && (rng() % 100 < 45 || handles.size() > 400)) {
+              size_t idx = rng() % handles.size();
+              buffer.Free(handles[idx]);
+              handles[idx] = handles.back();
+              handles.pop_back();
+            } else {
+              uint32_t offset;
+              uint32_t handle =
+                  buffer.Allocate(sizeof(ChunkVertex) * size_dist(rng), data.data(), offset);
+              if (handle) {
+                handles.emplace_back(handle);
+              } else {
+                failed++;
+              }
+            }
+          }
+          glFinish();
+        },
+        {{"per", "iteration"}, {"ops", kOpsPerIteration}});
+    suite.SetCounter(name, "live_allocs", buffer.NumActiveAllocs());
+    suite.SetCounter(name, "failed_allocs", failed);
+  }
+
+  SDL_GL_DeleteContext(context);
+  SDL_DestroyWindow(window);
+  SDL_Quit();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  // the results go to stdout, so logs go to stderr
+  spdlog::set_default_logger(spdlog::stderr_color_mt("bench"));
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    PrintUsage();
+    return 1;
+  }
+
+  SettingsManager::Init();
+  BlockDB block_db;
+  {
+    // textures are never sampled, the mesher only needs an index per texture
+    std::unordered_map<std::string, uint32_t> tex_name_to_idx;
+    uint32_t tex_idx = 0;
+    for (const auto& tex_name : block_db.GetTextureNamesInUse()) {
+      tex_name_to_idx[tex_name] = tex_idx++;
+    }
+    block_db.LoadMeshData(tex_name_to_idx);
+  }
+  Terrain terrain;
+  terrain.Load(block_db);
+
+  BenchSuite suite{options.filter};
+  BenchTerrain(suite, options, terrain);
+  {
+    WorldFixture world{1, options.seed, terrain};
+    BenchDownSample(suite, options, world);
+    world.DownSample();
+    BenchMesher(suite, options, block_db, world);
+    BenchJobEditLatency(suite, options, block_db, terrain, world);
+  }
+  {
+    HeadlessMeshSink mesh_sink;
+    ChunkManager chunk_manager{block_db, mesh_sink};
+    BenchSpiral(suite, options, chunk_manager);
+  }
+  BenchChunkLookup(suite, options);
+  BenchChunkManagerLoad(suite, options, block_db);
+  BenchLoadedWorld(suite, options, block_db, terrain);
+  BenchJobPipeline(suite, options, block_db, terrain);
+  BenchTextureDecode(suite, options, block_db);
+  BenchDynamicBuffer(suite, options);
+
+  nlohmann::json result = {{"seed", options.seed},
+                           {"iterations_scale", options.iterations_scale},
+                           {"hardware_concurrency", std::thread::hardware_concurrency()},
+                           {"benchmarks", suite.ToJson()}};
+  SettingsManager::Shutdown();
+  if (options.out_path.empty()) {
+    std::cout << result.dump(2) << '\n';
+  } else {
+    std::ofstream file(options.out_path);
+    if (!file.is_open()) {
+      spdlog::error("failed to open {}", options.out_path);
+      return 1;
+    }
+    file << result.dump(2) << '\n';
+  }
+  return suite.Failed() ? 2 : 0;
+}
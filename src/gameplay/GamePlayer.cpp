@@ -1,8 +1,10 @@
 #include "GamePlayer.hpp"
 
+#include <SDL_keycode.h>
 #include <imgui.h>
 
 #include "Constants.hpp"
+#include "application/Input.hpp"
 #include "gameplay/world/BlockDB.hpp"
 #include "gameplay/world/ChunkManager.hpp"
 
@@ -15,10 +17,20 @@ float IntBound(float s, float ds) {
   return (ds > 0 ? (s == 0.0f ? 1.0f : glm::ceil(s)) - s : s - glm::floor(s)) / glm::abs(ds);
 }
 
+// fixed tick so stepping is independent of frame rate
+constexpr double kPhysicsTickSeconds = 1.0 / 60.0;
+constexpr int kMaxPhysicsTicksPerFrame = 5;
+
 }  // namespace
 
 GamePlayer::GamePlayer(ChunkManager& chunk_manager, const BlockDB& block_db)
-    : chunk_manager_(chunk_manager), block_db_(block_db) {}
+    : chunk_manager_(chunk_manager),
+      block_db_(block_db),
+      physics_(VoxelPhysics::PropsFromBlockDB(block_db),
+               [&chunk_manager](const glm::ivec3& min, const glm::ivec3& max,
+                                std::span<BlockType> out) {
+                 chunk_manager.GetBlocks(min, max, out, VoxelPhysics::kUnloadedBlock);
+               }) {}
 
 void GamePlayer::RayCast() {
   ZoneScoped;
@@ -49,6 +61,16 @@ void GamePlayer::RayCast() {
   }
 
   float radius = raycast_radius_ / glm::length(direction);
+  BlockAccessor accessor = chunk_manager_.GetBlockAccessor();
+
+  // a ray starting above every block in reach that doesn't go down can't hit anything
+  if (direction.y >= 0) {
+    glm::ivec2 reach_min{glm::floor(glm::vec2{origin.x, origin.z} - raycast_radius_)};
+    glm::ivec2 reach_max{glm::floor(glm::vec2{origin.x, origin.z} + raycast_radius_)};
+    if (block_pos.y > chunk_manager_.GetMaxHeight(reach_min, reach_max)) {
+      goto not_found;
+    }
+  }
 
   while (true) {
     // incremental, find the axis where the distance to voxel edge along that axis is the least
@@ -88,7 +110,7 @@ void GamePlayer::RayCast() {
     }
     ray_cast_air_pos_ = ray_cast_non_air_pos_;
     ray_cast_non_air_pos_ = block_pos;
-    if (chunk_manager_.BlockPosExists(block_pos) && chunk_manager_.GetBlock(block_pos) != 0) {
+    if (accessor.GetBlock(block_pos) != 0) {
       return;
     }
   }
@@ -97,6 +119,15 @@ not_found:
   ray_cast_non_air_pos_ = glm::kNullIVec3;
 }
 
+void GamePlayer::SetBlockEditCallback(BlockEditCallback callback) {
+  block_edit_callback_ = std::move(callback);
+}
+
+void GamePlayer::SetBlock(const glm::ivec3& pos, BlockType block) {
+  chunk_manager_.SetBlock(pos, block);
+  if (block_edit_callback_) block_edit_callback_({pos, block});
+}
+
 const glm::ivec3& GamePlayer::GetRayCastBlockPos() const { return ray_cast_non_air_pos_; }
 const glm::ivec3& GamePlayer::GetAirRayCastBlockPos() const { return ray_cast_air_pos_; }
 
@@ -113,14 +144,43 @@ void GamePlayer::Update(double dt) {
       if (block_db_.GetBlockData()[0].id) {
       }
       if (elapsed_break_time_ >= 0.5) {
-        chunk_manager_.SetBlock(ray_cast_non_air_pos_, 0);
+        SetBlock(ray_cast_non_air_pos_, 0);
       }
     }
   } else {
     elapsed_break_time_ = 0;
   }
   prev_frame_ray_cast_non_air_pos_ = ray_cast_non_air_pos_;
-  Player::Update(dt);
+  if (physics_enabled_ && camera_mode == CameraMode::kFPS) {
+    UpdatePhysics(dt);
+  } else {
+    Player::Update(dt);
+  }
+}
+
+void GamePlayer::UpdatePhysics(double dt) {
+  ZoneScoped;
+  fps_camera_.SetPosition(position_);
+  glm::vec3 movement{0.f};
+  bool jump = false;
+  if (camera_focused_ || override_movement_) {
+    movement = GetMovementInput();
+    movement.y = 0;
+    jump = Input::IsKeyDown(SDLK_SPACE);
+  }
+  if (glm::length(movement) > 0) movement = glm::normalize(movement) * walk_speed_;
+
+  physics_time_accumulator_ = std::min(physics_time_accumulator_ + dt,
+                                       kPhysicsTickSeconds * kMaxPhysicsTicksPerFrame);
+  while (physics_time_accumulator_ >= kPhysicsTickSeconds) {
+    physics_time_accumulator_ -= kPhysicsTickSeconds;
+    body_.velocity.x = movement.x;
+    body_.velocity.z = movement.z;
+    if (jump && body_.on_ground) body_.velocity.y = jump_speed_;
+    physics_.Step(std::span<PhysicsBody>(&body_, 1), kPhysicsTickSeconds);
+  }
+  position_ = body_.position + glm::vec3{0.f, eye_height_, 0.f};
+  if (camera_focused_) fps_camera_.Update(dt);
 }
 
 void GamePlayer::OnImGui() {
@@ -129,16 +189,33 @@ void GamePlayer::OnImGui() {
                ImGuiWindowFlags_NoNavFocus | ImGuiWindowFlags_NoFocusOnAppearing);
   ImGui::Text("Held Item %s", block_db_.GetBlockData()[held_item_id].formatted_name.c_str());
   ImGui::SliderFloat("Temp Mining Speed", &mine_speed_, 0.5, 10.0);
+  if (ImGui::Checkbox("Physics", &physics_enabled_) && physics_enabled_) {
+    body_.position = position_ - glm::vec3{0.f, eye_height_, 0.f};
+    body_.velocity = glm::vec3{0.f};
+    // start on the surface instead of stuck in the ground
+    glm::ivec3 feet = glm::floor(body_.position);
+    if (chunk_manager_.BlockPosExists(feet) && chunk_manager_.GetBlock(feet) != 0) {
+      body_.position.y = static_cast<float>(chunk_manager_.GetHeight(feet.x, feet.z) + 1);
+    }
+    physics_time_accumulator_ = 0;
+  }
+  if (physics_enabled_) {
+    ImGui::SliderFloat("Walk Speed", &walk_speed_, 1.f, 20.f);
+    ImGui::SliderFloat("Jump Speed", &jump_speed_, 1.f, 20.f);
+    ImGui::Text("On Ground: %s, Slow Multiplier: %.2f", body_.on_ground ? "true" : "false",
+                body_.move_slow_multiplier);
+  }
   if (chunk_manager_.BlockPosExists(ray_cast_air_pos_)) {
     ImGui::Text(
         "Block Type: %s",
         block_db_.GetBlockData()[chunk_manager_.GetBlock(ray_cast_non_air_pos_)].name.c_str());
     Chunk* chunk = chunk_manager_.GetChunk(ray_cast_non_air_pos_);
     if (chunk) {
+      const ChunkColumn* column = chunk_manager_.GetColumn({chunk->GetPos().x, chunk->GetPos().z});
       ImGui::Text("Aim Chunk Terrain State: %s",
-                  chunk->terrain_state == Chunk::State::kFinished ? "Finished"
-                  : chunk->terrain_state == Chunk::State::kQueued ? "Queued"
-                                                                  : "Not Finished");
+                  column->terrain_state == Chunk::State::kFinished ? "Finished"
+                  : column->terrain_state == Chunk::State::kQueued ? "Queued"
+                                                                   : "Not Finished");
       ImGui::Text("Aim Chunk Mesh State: %s",
                   chunk->mesh_state == Chunk::State::kFinished ? "Finished"
                   : chunk->mesh_state == Chunk::State::kQueued ? "Queued"
@@ -148,16 +225,19 @@ void GamePlayer::OnImGui() {
   {
     Chunk* chunk = chunk_manager_.GetChunk(glm::ivec3(position_));
     if (chunk) {
+      const ChunkColumn* column = chunk_manager_.GetColumn({chunk->GetPos().x, chunk->GetPos().z});
       ImGui::Text("Pos Chunk Terrain State: %s",
-                  chunk->terrain_state == Chunk::State::kFinished ? "Finished"
-                  : chunk->terrain_state == Chunk::State::kQueued ? "Queued"
-                                                                  : "Not Finished");
+                  column->terrain_state == Chunk::State::kFinished ? "Finished"
+                  : column->terrain_state == Chunk::State::kQueued ? "Queued"
+                                                                   : "Not Finished");
       ImGui::Text("Pos Chunk Mesh State: %s",
                   chunk->mesh_state == Chunk::State::kFinished ? "Finished"
                   : chunk->mesh_state == Chunk::State::kQueued ? "Queued"
                                                                : "Not Finished");
     }
     ImGui::Text("Pos Chunk Exists: %s", chunk ? "Yes" : "No");
+    glm::ivec3 block_pos = glm::floor(position_);
+    ImGui::Text("Ground Height: %d", chunk_manager_.GetHeight(block_pos.x, block_pos.z));
   }
   ImGui::End();
 }
@@ -169,7 +249,7 @@ bool GamePlayer::OnEvent(const SDL_Event& event) {
       if (event.button.button == SDL_BUTTON_RIGHT) {
         if (ray_cast_air_pos_ != glm::kNullIVec3) {
           // TODO: access held block in inventory
-          chunk_manager_.SetBlock(ray_cast_air_pos_, held_item_id);
+          SetBlock(ray_cast_air_pos_, held_item_id);
         }
         return true;
       } else if (event.button.button == SDL_BUTTON_LEFT) {
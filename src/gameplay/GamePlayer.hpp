@@ -1,9 +1,11 @@
 #pragma once
 
 #include "gameplay/Player.hpp"
+#include "gameplay/physics/VoxelPhysics.hpp"
 
 class ChunkManager;
 class BlockDB;
+struct BlockEdit;
 
 class GamePlayer : public Player {
  public:
@@ -17,6 +19,10 @@ class GamePlayer : public Player {
 
   int held_item_id{0};
 
+  // Called for every block the player places or breaks, e.g. to record it.
+  using BlockEditCallback = std::function<void(const BlockEdit&)>;
+  void SetBlockEditCallback(BlockEditCallback callback);
+
  private:
   glm::ivec3 ray_cast_non_air_pos_;
   glm::ivec3 ray_cast_air_pos_;
@@ -29,4 +35,15 @@ class GamePlayer : public Player {
 
   ChunkManager& chunk_manager_;
   const BlockDB& block_db_;
+
+  VoxelPhysics physics_;
+  PhysicsBody body_;
+  bool physics_enabled_{false};
+  double physics_time_accumulator_{0};
+  float walk_speed_{5.f};
+  float jump_speed_{9.f};
+  float eye_height_{1.6f};
+  BlockEditCallback block_edit_callback_;
+  void UpdatePhysics(double dt);
+  void SetBlock(const glm::ivec3& pos, BlockType block);
 };
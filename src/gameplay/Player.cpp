@@ -36,25 +36,7 @@ void Player::Update(double dt) {
   if (camera_mode == CameraMode::kFPS) {
     fps_camera_.SetPosition(position_);
     float movement_offset = move_speed_ * dt;
-    glm::vec3 movement{0.f};
-    if (Input::IsKeyDown(SDLK_w) || Input::IsKeyDown(SDLK_i)) {
-      movement += fps_camera_.GetFront();
-    }
-    if (Input::IsKeyDown(SDLK_s) || Input::IsKeyDown(SDLK_k)) {
-      movement -= fps_camera_.GetFront();
-    }
-    if (Input::IsKeyDown(SDLK_d) || Input::IsKeyDown(SDLK_l)) {
-      movement += glm::normalize(glm::cross(fps_camera_.GetFront(), FPSCamera::kUpVector));
-    }
-    if (Input::IsKeyDown(SDLK_a) || Input::IsKeyDown(SDLK_j)) {
-      movement -= glm::normalize(glm::cross(fps_camera_.GetFront(), FPSCamera::kUpVector));
-    }
-    if (Input::IsKeyDown(SDLK_y) || Input::IsKeyDown(SDLK_r)) {
-      movement += FPSCamera::kUpVector;
-    }
-    if (Input::IsKeyDown(SDLK_h) || Input::IsKeyDown(SDLK_f)) {
-      movement -= FPSCamera::kUpVector;
-    }
+    glm::vec3 movement = GetMovementInput();
     if (glm::length(movement) > 0) {
       movement = glm::normalize(movement) * movement_offset;
       position_ += movement;
@@ -65,6 +47,29 @@ void Player::Update(double dt) {
   }
 }
 
+glm::vec3 Player::GetMovementInput() const {
+  glm::vec3 movement{0.f};
+  if (Input::IsKeyDown(SDLK_w) || Input::IsKeyDown(SDLK_i)) {
+    movement += fps_camera_.GetFront();
+  }
+  if (Input::IsKeyDown(SDLK_s) || Input::IsKeyDown(SDLK_k)) {
+    movement -= fps_camera_.GetFront();
+  }
+  if (Input::IsKeyDown(SDLK_d) || Input::IsKeyDown(SDLK_l)) {
+    movement += glm::normalize(glm::cross(fps_camera_.GetFront(), FPSCamera::kUpVector));
+  }
+  if (Input::IsKeyDown(SDLK_a) || Input::IsKeyDown(SDLK_j)) {
+    movement -= glm::normalize(glm::cross(fps_camera_.GetFront(), FPSCamera::kUpVector));
+  }
+  if (Input::IsKeyDown(SDLK_y) || Input::IsKeyDown(SDLK_r)) {
+    movement += FPSCamera::kUpVector;
+  }
+  if (Input::IsKeyDown(SDLK_h) || Input::IsKeyDown(SDLK_f)) {
+    movement -= FPSCamera::kUpVector;
+  }
+  return movement;
+}
+
 void Player::OnImGui() {
   ZoneScoped;
   ImGui::Begin("Player", nullptr,
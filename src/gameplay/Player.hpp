@@ -31,4 +31,6 @@ class Player {
   bool camera_focused_{false};
   float move_speed_{10.f};
   bool override_movement_{true};
+  // unnormalized direction from the held movement keys
+  [[nodiscard]] glm::vec3 GetMovementInput() const;
 };
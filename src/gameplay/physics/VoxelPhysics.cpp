@@ -0,0 +1,164 @@
+#include "VoxelPhysics.hpp"
+
+#include <glm/common.hpp>
+
+#include "gameplay/world/BlockDB.hpp"
+
+namespace {
+
+// keeps boxes resting exactly on a face from counting the cell on the other side
+constexpr float kEps = 0.0001f;
+// extra blocks loaded around a body so nearby bodies can share a neighborhood
+constexpr int kNeighborhoodPadding = 2;
+
+}  // namespace
+
+void BlockNeighborhood::Load(const RegionFunc& region_func, const glm::ivec3& min,
+                             const glm::ivec3& max) {
+  ZoneScoped;
+  min_ = min;
+  max_ = max;
+  dims_ = max - min + 1;
+  blocks_.resize(static_cast<size_t>(dims_.x) * dims_.y * dims_.z);
+  region_func(min_, max_, blocks_);
+  valid_ = true;
+}
+
+bool BlockNeighborhood::Contains(const glm::ivec3& min, const glm::ivec3& max) const {
+  return valid_ && min.x >= min_.x && min.y >= min_.y && min.z >= min_.z && max.x <= max_.x &&
+         max.y <= max_.y && max.z <= max_.z;
+}
+
+VoxelPhysics::VoxelPhysics(std::vector<BlockPhysicsProps> props,
+                           BlockNeighborhood::RegionFunc region_func)
+    : props_(std::move(props)), region_func_(std::move(region_func)) {}
+
+std::vector<BlockPhysicsProps> VoxelPhysics::PropsFromBlockDB(const BlockDB& block_db) {
+  const auto& block_data = block_db.GetBlockData();
+  std::vector<BlockPhysicsProps> props(block_data.size());
+  for (size_t i = 0; i < block_data.size(); i++) {
+    float move_slow_multiplier = std::max(block_data[i].move_slow_multiplier, 1.f);
+    props[i].solid = i != 0 && move_slow_multiplier <= 1.f;
+    props[i].move_slow_multiplier = move_slow_multiplier;
+  }
+  return props;
+}
+
+void VoxelPhysics::Step(std::span<PhysicsBody> bodies, float dt) {
+  ZoneScoped;
+  stats_ = {};
+  neighborhood_.Clear();
+  for (auto& body : bodies) {
+    StepBody(body, dt);
+  }
+}
+
+void VoxelPhysics::StepBody(PhysicsBody& body, float dt) {
+  stats_.bodies_stepped++;
+  const glm::vec3& half = body.half_extents;
+  glm::vec3 min = body.position - glm::vec3{half.x, 0.f, half.z};
+  glm::vec3 max = body.position + glm::vec3{half.x, half.y * 2.f, half.z};
+
+  body.velocity.y = std::max(body.velocity.y - gravity * dt, -terminal_velocity);
+  glm::vec3 delta = body.velocity * dt / body.move_slow_multiplier;
+  glm::vec3 swept_max = glm::max(max, max + delta);
+  swept_max.y += body.step_height;
+  EnsureNeighborhood(glm::min(min, min + delta), swept_max);
+
+  // vertical first so on_ground is known before stepping
+  float moved_y = SweepAxis(min, max, 1, delta.y);
+  min.y += moved_y;
+  max.y += moved_y;
+  body.on_ground = moved_y != delta.y && delta.y < 0.f;
+  if (moved_y != delta.y) body.velocity.y = 0.f;
+
+  for (int axis : {0, 2}) {
+    if (delta[axis] == 0.f) continue;
+    float moved = SweepAxis(min, max, axis, delta[axis]);
+    if (moved != delta[axis] && body.on_ground && body.step_height > 0.f) {
+      // try moving from step_height up, then settle back down onto whatever is there
+      glm::vec3 step_min = min;
+      glm::vec3 step_max = max;
+      float up = SweepAxis(step_min, step_max, 1, body.step_height);
+      step_min.y += up;
+      step_max.y += up;
+      float stepped = SweepAxis(step_min, step_max, axis, delta[axis]);
+      if (std::abs(stepped) > std::abs(moved)) {
+        step_min[axis] += stepped;
+        step_max[axis] += stepped;
+        float down = SweepAxis(step_min, step_max, 1, -up);
+        step_min.y += down;
+        step_max.y += down;
+        min = step_min;
+        max = step_max;
+        continue;
+      }
+    }
+    min[axis] += moved;
+    max[axis] += moved;
+    if (moved != delta[axis]) body.velocity[axis] = 0.f;
+  }
+
+  body.position = min + glm::vec3{half.x, 0.f, half.z};
+  body.move_slow_multiplier = MaxSlowMultiplier(min, max);
+}
+
+void VoxelPhysics::EnsureNeighborhood(const glm::vec3& box_min, const glm::vec3& box_max) {
+  glm::ivec3 min = glm::ivec3(glm::floor(box_min)) - 1;
+  glm::ivec3 max = glm::ivec3(glm::floor(box_max)) + 1;
+  if (neighborhood_.Contains(min, max)) return;
+  stats_.neighborhood_loads++;
+  neighborhood_.Load(region_func_, min - kNeighborhoodPadding, max + kNeighborhoodPadding);
+}
+
+float VoxelPhysics::SweepAxis(const glm::vec3& box_min, const glm::vec3& box_max, int axis,
+                              float delta) const {
+  if (delta == 0.f) return 0.f;
+  int axis1 = (axis + 1) % 3;
+  int axis2 = (axis + 2) % 3;
+  int lo1 = static_cast<int>(std::floor(box_min[axis1] + kEps));
+  int hi1 = static_cast<int>(std::floor(box_max[axis1] - kEps));
+  int lo2 = static_cast<int>(std::floor(box_min[axis2] + kEps));
+  int hi2 = static_cast<int>(std::floor(box_max[axis2] - kEps));
+  // true if any cell the box face covers at axis coordinate c is solid
+  auto slice_solid = [&](int c) {
+    glm::ivec3 pos;
+    pos[axis] = c;
+    for (pos[axis1] = lo1; pos[axis1] <= hi1; pos[axis1]++) {
+      for (pos[axis2] = lo2; pos[axis2] <= hi2; pos[axis2]++) {
+        if (GetProps(neighborhood_.GetBlock(pos.x, pos.y, pos.z)).solid) return true;
+      }
+    }
+    return false;
+  };
+
+  if (delta > 0.f) {
+    float leading = box_max[axis];
+    int c_end = static_cast<int>(std::ceil(leading + delta)) - 1;
+    for (int c = static_cast<int>(std::ceil(leading - kEps)); c <= c_end; c++) {
+      if (slice_solid(c)) return std::max(0.f, static_cast<float>(c) - leading);
+    }
+  } else {
+    float leading = box_min[axis];
+    int c_end = static_cast<int>(std::floor(leading + delta));
+    for (int c = static_cast<int>(std::floor(leading + kEps)) - 1; c >= c_end; c--) {
+      if (slice_solid(c)) return std::min(0.f, static_cast<float>(c + 1) - leading);
+    }
+  }
+  return delta;
+}
+
+float VoxelPhysics::MaxSlowMultiplier(const glm::vec3& box_min, const glm::vec3& box_max) const {
+  glm::ivec3 min = glm::floor(box_min + kEps);
+  glm::ivec3 max = glm::floor(box_max - kEps);
+  float result = 1.f;
+  for (int y = min.y; y <= max.y; y++) {
+    for (int z = min.z; z <= max.z; z++) {
+      for (int x = min.x; x <= max.x; x++) {
+        const auto& props = GetProps(neighborhood_.GetBlock(x, y, z));
+        if (!props.solid) result = std::max(result, props.move_slow_multiplier);
+      }
+    }
+  }
+  return result;
+}
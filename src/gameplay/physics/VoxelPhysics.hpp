@@ -0,0 +1,89 @@
+#pragma once
+
+#include <functional>
+#include <glm/vec3.hpp>
+#include <limits>
+
+#include "gameplay/world/ChunkDef.hpp"
+
+class BlockDB;
+
+struct PhysicsBody {
+  // center of the bottom face of the box
+  glm::vec3 position{0};
+  glm::vec3 velocity{0};
+  glm::vec3 half_extents{0.3f, 0.9f, 0.3f};
+  float step_height{1.f};
+  bool on_ground{false};
+  // largest move_slow_multiplier of the blocks the body was in last step
+  float move_slow_multiplier{1.f};
+};
+
+struct BlockPhysicsProps {
+  bool solid{false};
+  float move_slow_multiplier{1.f};
+};
+
+// Copy of the blocks in a box of the world, filled once per region instead of per voxel lookups.
+class BlockNeighborhood {
+ public:
+  // Fills out with the blocks in the inclusive region [min, max], x fastest then z then y.
+  using RegionFunc =
+      std::function<void(const glm::ivec3& min, const glm::ivec3& max, std::span<BlockType> out)>;
+
+  void Load(const RegionFunc& region_func, const glm::ivec3& min, const glm::ivec3& max);
+  void Clear() { valid_ = false; }
+  [[nodiscard]] bool Contains(const glm::ivec3& min, const glm::ivec3& max) const;
+  [[nodiscard]] inline BlockType GetBlock(int x, int y, int z) const {
+    return blocks_[((y - min_.y) * dims_.z + (z - min_.z)) * dims_.x + (x - min_.x)];
+  }
+
+ private:
+  std::vector<BlockType> blocks_;
+  glm::ivec3 min_{0};
+  glm::ivec3 max_{0};
+  glm::ivec3 dims_{0};
+  bool valid_{false};
+};
+
+// Swept AABB collision against the voxel grid with gravity and stepping. Steps are deterministic
+// for a given dt, block region and body order, and don't touch the renderer, so any number of
+// bodies can be stepped headless.
+class VoxelPhysics {
+ public:
+  // Block ids not covered by props, like the unloaded block, are solid.
+  VoxelPhysics(std::vector<BlockPhysicsProps> props, BlockNeighborhood::RegionFunc region_func);
+  // Blocks are solid unless they are air or slow movement down (water).
+  static std::vector<BlockPhysicsProps> PropsFromBlockDB(const BlockDB& block_db);
+  // Block id used for unloaded blocks so bodies don't fall out of the loaded world.
+  static constexpr BlockType kUnloadedBlock = std::numeric_limits<BlockType>::max();
+
+  // Blocks are reloaded every step, so edits between steps are seen.
+  void Step(std::span<PhysicsBody> bodies, float dt);
+
+  float gravity{28.f};
+  float terminal_velocity{60.f};
+
+  struct Stats {
+    uint32_t bodies_stepped{};
+    uint32_t neighborhood_loads{};
+  };
+  [[nodiscard]] const Stats& GetStats() const { return stats_; }
+
+ private:
+  std::vector<BlockPhysicsProps> props_;
+  BlockNeighborhood::RegionFunc region_func_;
+  BlockNeighborhood neighborhood_;
+  Stats stats_;
+
+  [[nodiscard]] inline const BlockPhysicsProps& GetProps(BlockType block) const {
+    static constexpr BlockPhysicsProps kSolid{true, 1.f};
+    return block < props_.size() ? props_[block] : kSolid;
+  }
+  void StepBody(PhysicsBody& body, float dt);
+  void EnsureNeighborhood(const glm::vec3& box_min, const glm::vec3& box_max);
+  // Returns how far the box can move along axis, up to delta.
+  [[nodiscard]] float SweepAxis(const glm::vec3& box_min, const glm::vec3& box_max, int axis,
+                                float delta) const;
+  [[nodiscard]] float MaxSlowMultiplier(const glm::vec3& box_min, const glm::vec3& box_max) const;
+};
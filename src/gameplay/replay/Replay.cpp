@@ -0,0 +1,88 @@
+#include "Replay.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include "util/JsonUtil.hpp"
+#include "util/LoadFile.hpp"
+
+bool Replay::Load(const std::string& path) {
+  if (!std::filesystem::exists(path)) {
+    spdlog::error("Replay file does not exist: {}", path);
+    return false;
+  }
+  auto j = util::LoadJsonFile(path);
+  if (!j.is_object() || !j.contains("frames") || !j["frames"].is_array()) {
+    spdlog::error("Invalid replay file: {}", path);
+    return false;
+  }
+  dt = j.value("dt", 1.0 / 60.0);
+  seed = j.value("seed", 0u);
+  frames.clear();
+  frames.reserve(j["frames"].size());
+  for (const auto& f : j["frames"]) {
+    ReplayFrame& frame = frames.emplace_back();
+    auto p = f.value("position", std::array<float, 3>{});
+    frame.position = {p[0], p[1], p[2]};
+    frame.pitch = f.value("pitch", 0.f);
+    frame.yaw = f.value("yaw", 0.f);
+    if (f.contains("edits")) {
+      for (const auto& e : f["edits"]) {
+        // [x, y, z, block]
+        auto edit = e.get<std::array<int, 4>>();
+        frame.edits.push_back(
+            BlockEdit{{edit[0], edit[1], edit[2]}, static_cast<BlockType>(edit[3])});
+      }
+    }
+  }
+  return true;
+}
+
+void Replay::Write(const std::string& path) const {
+  nlohmann::json j_frames = nlohmann::json::array();
+  for (const auto& frame : frames) {
+    nlohmann::json f = {{"position", {frame.position.x, frame.position.y, frame.position.z}},
+                        {"pitch", frame.pitch},
+                        {"yaw", frame.yaw}};
+    if (!frame.edits.empty()) {
+      auto& edits = f["edits"] = nlohmann::json::array();
+      for (const auto& edit : frame.edits) {
+        edits.push_back({edit.pos.x, edit.pos.y, edit.pos.z, edit.block});
+      }
+    }
+    j_frames.emplace_back(std::move(f));
+  }
+  nlohmann::json j = {{"dt", dt}, {"seed", seed}, {"frames", std::move(j_frames)}};
+  util::json::WriteJson(j, path);
+}
+
+void ReplayRecorder::Start(uint32_t seed, double dt) {
+  replay_ = {.dt = dt, .seed = seed, .frames = {}};
+  pending_edits_.clear();
+  accumulator_ = 0;
+  recording_ = true;
+}
+
+void ReplayRecorder::Update(double dt, const glm::vec3& position, float pitch, float yaw) {
+  if (!recording_) return;
+  accumulator_ += dt;
+  while (accumulator_ >= replay_.dt) {
+    accumulator_ -= replay_.dt;
+    // positions in between steps aren't interpolated, a frame is far shorter than a chunk crossing
+    replay_.frames.push_back(ReplayFrame{position, pitch, yaw, std::move(pending_edits_)});
+    pending_edits_.clear();
+  }
+}
+
+void ReplayRecorder::AddEdit(const BlockEdit& edit) {
+  if (recording_) pending_edits_.emplace_back(edit);
+}
+
+Replay ReplayRecorder::Stop() {
+  recording_ = false;
+  if (!pending_edits_.empty()) {
+    replay_.frames.emplace_back(replay_.frames.empty() ? ReplayFrame{} : replay_.frames.back());
+    replay_.frames.back().edits = std::move(pending_edits_);
+    pending_edits_.clear();
+  }
+  return std::move(replay_);
+}
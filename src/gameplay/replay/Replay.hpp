@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include "gameplay/world/ChunkManager.hpp"
+
+// One fixed timestep of a recording: where the player was, where it looked, and the blocks it
+// changed during the step.
+struct ReplayFrame {
+  glm::vec3 position{};
+  float pitch{};
+  float yaw{};
+  std::vector<BlockEdit> edits;
+};
+
+struct Replay {
+  // seconds per frame
+  double dt{1.0 / 60.0};
+  // world seed the replay was recorded with
+  uint32_t seed{};
+  std::vector<ReplayFrame> frames;
+
+  // Returns false if the file is missing or malformed.
+  bool Load(const std::string& path);
+  void Write(const std::string& path) const;
+};
+
+// Samples the player at a fixed timestep regardless of the frame rate.
+class ReplayRecorder {
+ public:
+  void Start(uint32_t seed, double dt = 1.0 / 60.0);
+  // Call once per frame with the frame's dt. Emits a frame for every whole timestep elapsed.
+  void Update(double dt, const glm::vec3& position, float pitch, float yaw);
+  // Attached to the next frame emitted.
+  void AddEdit(const BlockEdit& edit);
+  // Returns the recording and stops.
+  Replay Stop();
+  [[nodiscard]] bool IsRecording() const { return recording_; }
+  [[nodiscard]] size_t NumFrames() const { return replay_.frames.size(); }
+
+ private:
+  Replay replay_;
+  std::vector<BlockEdit> pending_edits_;
+  double accumulator_{0};
+  bool recording_{false};
+};
@@ -0,0 +1,230 @@
+#include "ReplayDriver.hpp"
+
+#include <glm/ext/matrix_clip_space.hpp>
+#include <glm/ext/matrix_transform.hpp>
+#include <glm/trigonometric.hpp>
+#include <nlohmann/json.hpp>
+
+#include "gameplay/world/ChunkUtil.hpp"
+#include "renderer/Frustum.hpp"
+
+namespace {
+
+constexpr size_t kNumWorstUpdates = 10;
+
+double Percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0;
+  auto idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+  return sorted[idx];
+}
+
+nlohmann::json Summary(std::vector<double> values) {
+  std::sort(values.begin(), values.end());
+  return {{"count", values.size()},
+          {"p50", Percentile(values, 0.5)},
+          {"p90", Percentile(values, 0.9)},
+          {"p99", Percentile(values, 0.99)},
+          {"max", values.empty() ? 0 : values.back()}};
+}
+
+bool AABBInFrustum(Frustum& frustum, const glm::vec3& min, const glm::vec3& max) {
+  for (const auto& plane : frustum.GetData()) {
+    // the corner furthest along the plane normal
+    glm::vec3 p{plane[Frustum::kX] > 0 ? max.x : min.x, plane[Frustum::kY] > 0 ? max.y : min.y,
+                plane[Frustum::kZ] > 0 ? max.z : min.z};
+    if (plane[Frustum::kX] * p.x + plane[Frustum::kY] * p.y + plane[Frustum::kZ] * p.z +
+            plane[Frustum::kDist] <
+        0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// same orientation math as FPSCamera
+glm::vec3 FrameFront(const ReplayFrame& frame) {
+  return {glm::cos(glm::radians(frame.yaw)) * glm::cos(glm::radians(frame.pitch)),
+          glm::sin(glm::radians(frame.pitch)),
+          glm::sin(glm::radians(frame.yaw)) * glm::cos(glm::radians(frame.pitch))};
+}
+
+}  // namespace
+
+ReplayDriver::ReplayDriver(const Replay& replay, ChunkManager& chunk_manager)
+    : replay_(replay), chunk_manager_(chunk_manager) {
+  update_ms_.reserve(replay.frames.size());
+  queue_depths_.reserve(replay.frames.size());
+  missing_visible_meshes_.reserve(replay.frames.size());
+  missing_visible_terrain_.reserve(replay.frames.size());
+}
+
+const ReplayFrame& ReplayDriver::CurrentFrame() const {
+  EASSERT_MSG(frame_idx_ > 0, "No frame stepped yet");
+  return replay_.frames[frame_idx_ - 1];
+}
+
+bool ReplayDriver::Step() {
+  ZoneScoped;
+  if (Done()) return false;
+  if (frame_idx_ == 0) timer_.Reset();
+  const ReplayFrame& frame = replay_.frames[frame_idx_];
+  chunk_manager_.SetCenter(frame.position);
+  chunk_manager_.SetHeading(FrameFront(frame));
+  if (!frame.edits.empty()) chunk_manager_.SetBlocks(frame.edits);
+
+  Timer update_timer;
+  chunk_manager_.Update(replay_.dt);
+  update_ms_.emplace_back(update_timer.ElapsedMicro() * 0.001);
+
+  queue_depths_.emplace_back(chunk_manager_.GetQueueDepths());
+  UpdateColumns(static_cast<int>(frame_idx_));
+  CountMissingVisible(frame);
+  frame_idx_++;
+  return true;
+}
+
+void ReplayDriver::UpdateColumns(int frame) {
+  ZoneScoped;
+  double now_ms = timer_.ElapsedMicro() * 0.001;
+  int load_distance = chunk_manager_.GetLoadDistance();
+  chunk_manager_.IterateChunks(load_distance, [&](const glm::ivec2& pos) {
+    if (columns_.contains(pos)) return;
+    columns_.emplace(pos, ColumnTiming{.requested_frame = frame, .requested_ms = now_ms});
+    pending_columns_.emplace_back(pos);
+  });
+
+  glm::ivec3 center = util::chunk::WorldToChunkPos(replay_.frames[frame].position);
+  const ChunkMap& chunk_map = chunk_manager_.GetVisibleChunks();
+  std::erase_if(pending_columns_, [&](const glm::ivec2& pos) {
+    ColumnTiming& timing = columns_[pos];
+    if (std::abs(pos.x - center.x) > load_distance || std::abs(pos.y - center.z) > load_distance) {
+      timing.unloaded = true;
+      return true;
+    }
+    bool meshed = false;
+    glm::ivec3 p{pos.x, 0, pos.y};
+    for (p.y = 0; p.y < kNumVerticalChunks && !meshed; p.y++) {
+      chunk_map.find_fn(p, [&meshed](const std::shared_ptr<Chunk>& chunk) {
+        // air chunks are marked meshed without any work, they don't count
+        meshed = chunk->mesh_state == Chunk::State::kFinished && chunk->data.GetBlockCount() > 0;
+      });
+    }
+    if (!meshed) return false;
+    timing.first_mesh_frame = frame;
+    timing.first_mesh_ms = now_ms;
+    return true;
+  });
+}
+
+void ReplayDriver::CountMissingVisible(const ReplayFrame& frame) {
+  ZoneScoped;
+  glm::vec3 front = FrameFront(frame);
+  glm::mat4 view = glm::lookAt(frame.position, frame.position + glm::normalize(front),
+                               glm::vec3{0.f, 1.f, 0.f});
+  glm::mat4 proj = glm::perspective(glm::radians(fov_degrees), aspect_ratio, 0.1f, far_plane);
+  Frustum frustum{proj * view};
+
+  uint32_t missing_meshes = 0;
+  uint32_t missing_terrain = 0;
+  const ChunkMap& chunk_map = chunk_manager_.GetVisibleChunks();
+  chunk_manager_.IterateChunks(chunk_manager_.GetLoadDistance(), [&](const glm::ivec2& pos) {
+    const ChunkColumn* column = chunk_map.PeekColumn(pos);
+    glm::ivec3 p{pos.x, 0, pos.y};
+    for (p.y = 0; p.y < kNumVerticalChunks; p.y++) {
+      glm::vec3 min = glm::vec3(p * kChunkLength);
+      if (!AABBInFrustum(frustum, min, min + glm::vec3(kChunkLength))) continue;
+      if (!column || column->terrain_state != Chunk::State::kFinished) {
+        missing_terrain++;
+      } else if (column->chunks[p.y]->data.GetBlockCount() > 0 &&
+                 column->chunks[p.y]->mesh_state != Chunk::State::kFinished) {
+        missing_meshes++;
+      }
+    }
+  });
+  missing_visible_meshes_.emplace_back(missing_meshes);
+  missing_visible_terrain_.emplace_back(missing_terrain);
+}
+
+nlohmann::json ReplayDriver::GetReport() const {
+  nlohmann::json report;
+  report["frames"] = frame_idx_;
+  report["dt"] = replay_.dt;
+  report["load_distance"] = chunk_manager_.GetLoadDistance();
+
+  {
+    report["update_ms"] = Summary(update_ms_);
+    std::vector<size_t> order(update_ms_.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    size_t num_worst = std::min(kNumWorstUpdates, order.size());
+    std::partial_sort(order.begin(), order.begin() + num_worst, order.end(),
+                      [this](size_t a, size_t b) { return update_ms_[a] > update_ms_[b]; });
+    auto& worst = report["worst_updates"] = nlohmann::json::array();
+    for (size_t i = 0; i < num_worst; i++) {
+      const auto& pos = replay_.frames[order[i]].position;
+      worst.push_back({{"frame", order[i]},
+                       {"ms", update_ms_[order[i]]},
+                       {"position", {pos.x, pos.y, pos.z}}});
+    }
+  }
+
+  {
+    std::vector<double> first_mesh_ms;
+    std::vector<double> first_mesh_frames;
+    auto& columns = report["columns"] = nlohmann::json::array();
+    uint32_t pending = 0;
+    uint32_t unloaded = 0;
+    for (const auto& [pos, timing] : columns_) {
+      nlohmann::json c = {{"x", pos.x}, {"z", pos.y}, {"requested_frame", timing.requested_frame}};
+      if (timing.first_mesh_frame >= 0) {
+        double ms = timing.first_mesh_ms - timing.requested_ms;
+        int frames = timing.first_mesh_frame - timing.requested_frame;
+        first_mesh_ms.emplace_back(ms);
+        first_mesh_frames.emplace_back(frames);
+        c["first_mesh_frame"] = timing.first_mesh_frame;
+        c["time_to_first_mesh_ms"] = ms;
+      } else if (timing.unloaded) {
+        unloaded++;
+      } else {
+        pending++;
+      }
+      columns.emplace_back(std::move(c));
+    }
+    report["time_to_first_mesh_ms"] = Summary(first_mesh_ms);
+    report["time_to_first_mesh_frames"] = Summary(first_mesh_frames);
+    report["columns_never_meshed"] = pending;
+    report["columns_unloaded_before_mesh"] = unloaded;
+  }
+
+  {
+    auto& depths = report["queue_depths"];
+    auto add_series = [&depths, this](const char* name, size_t ChunkManager::QueueDepths::*field) {
+      auto& series = depths[name] = nlohmann::json::array();
+      for (const auto& d : queue_depths_) series.push_back(d.*field);
+    };
+    add_series("terrain", &ChunkManager::QueueDepths::terrain);
+    add_series("terrain_finished", &ChunkManager::QueueDepths::terrain_finished);
+    add_series("light", &ChunkManager::QueueDepths::light);
+    add_series("light_finished", &ChunkManager::QueueDepths::light_finished);
+    add_series("lit", &ChunkManager::QueueDepths::lit);
+    add_series("mesh", &ChunkManager::QueueDepths::mesh);
+    add_series("mesh_immediate", &ChunkManager::QueueDepths::mesh_immediate);
+    add_series("mesh_finished", &ChunkManager::QueueDepths::mesh_finished);
+    add_series("lod_mesh_finished", &ChunkManager::QueueDepths::lod_mesh_finished);
+    add_series("tasks_queued", &ChunkManager::QueueDepths::tasks_queued);
+    add_series("tasks_running", &ChunkManager::QueueDepths::tasks_running);
+  }
+
+  {
+    uint32_t frames_missing = 0;
+    uint32_t max_missing = 0;
+    for (uint32_t missing : missing_visible_meshes_) {
+      frames_missing += missing > 0;
+      max_missing = std::max(max_missing, missing);
+    }
+    report["missing_visible_meshes"] = {{"per_frame", missing_visible_meshes_},
+                                        {"frames_with_missing", frames_missing},
+                                        {"max", max_missing}};
+    report["missing_visible_terrain"] = {{"per_frame", missing_visible_terrain_}};
+  }
+  return report;
+}
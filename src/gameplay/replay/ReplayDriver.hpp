@@ -0,0 +1,56 @@
+#pragma once
+
+#include <nlohmann/json_fwd.hpp>
+
+#include "gameplay/replay/Replay.hpp"
+#include "util/Timer.hpp"
+
+// Feeds a Replay into a ChunkManager one fixed timestep per Step and measures how streaming keeps
+// up: time to first mesh per column, queue depths and Update duration per frame, and how many
+// chunks in view were missing their mesh.
+class ReplayDriver {
+ public:
+  ReplayDriver(const Replay& replay, ChunkManager& chunk_manager);
+  // Moves the center to the next frame, applies its edits and runs Update. Returns false once every
+  // frame has run.
+  bool Step();
+  [[nodiscard]] bool Done() const { return frame_idx_ >= replay_.frames.size(); }
+  // The last frame Step applied.
+  [[nodiscard]] const ReplayFrame& CurrentFrame() const;
+  [[nodiscard]] size_t NumFramesRun() const { return frame_idx_; }
+  [[nodiscard]] size_t NumFrames() const { return replay_.frames.size(); }
+  [[nodiscard]] nlohmann::json GetReport() const;
+
+  // view used to decide which chunks are visible
+  float fov_degrees{75.f};
+  float aspect_ratio{16.f / 9.f};
+  float far_plane{3000.f};
+
+ private:
+  const Replay& replay_;
+  ChunkManager& chunk_manager_;
+  size_t frame_idx_{0};
+  Timer timer_;
+
+  struct ColumnTiming {
+    int requested_frame{};
+    double requested_ms{};
+    int first_mesh_frame{-1};
+    double first_mesh_ms{};
+    // left the load distance before getting a mesh
+    bool unloaded{false};
+  };
+  std::unordered_map<glm::ivec2, ColumnTiming> columns_;
+  // requested and still waiting for a mesh
+  std::vector<glm::ivec2> pending_columns_;
+
+  std::vector<double> update_ms_;
+  std::vector<ChunkManager::QueueDepths> queue_depths_;
+  // chunks in view with terrain and blocks but no mesh yet
+  std::vector<uint32_t> missing_visible_meshes_;
+  // chunks in view still waiting for terrain
+  std::vector<uint32_t> missing_visible_terrain_;
+
+  void UpdateColumns(int frame);
+  void CountMissingVisible(const ReplayFrame& frame);
+};
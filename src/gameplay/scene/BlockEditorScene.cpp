@@ -102,36 +102,21 @@ void BlockEditorScene::Reload() {
   {
     ZoneScopedN("Load texture data");
     // auto all_texture_names = BlockDB::GetAllBlockTexturesFromAllModels();
-    Image image;
-    int tex_idx = 0;
-    std::vector<Image> images;
-    // TODO: handle diff sizes?
+    std::vector<std::string> tex_names;
     for (const auto& file :
          std::filesystem::directory_iterator(GET_PATH("resources/textures/block"))) {
       // TODO: mcmeta animations or custom animation format
       if (file.path().extension() != ".png") {
         continue;
       }
-      std::string tex_name =
-          file.path().parent_path().filename().string() + "/" + file.path().stem().string();
-      auto str = file.path().parent_path().string() + "/" + file.path().filename().string();
-      util::LoadImage(image, str, 4);
-      if (image.width != 32 || image.height != 32) continue;
-      tex_name_to_idx_[tex_name] = tex_idx++;
-      images.emplace_back(image);
+      tex_names.emplace_back(file.path().parent_path().filename().string() + "/" +
+                             file.path().stem().string());
     }
-
-    chunk_tex_array_ = TextureManager::Get().Load({.images = images,
-                                                   .generate_mipmaps = true,
-                                                   .internal_format = GL_RGBA8,
-                                                   .format = GL_RGBA,
-                                                   .filter_mode_min = GL_NEAREST_MIPMAP_LINEAR,
-                                                   .filter_mode_max = GL_NEAREST,
-                                                   .texture_wrap = GL_REPEAT});
+    // the editor remeshes without LOD colors
+    std::vector<glm::ivec3> tex_avg_colors;
+    chunk_tex_array_ =
+        util::renderer::LoadBlockTextureArray(tex_names, tex_name_to_idx_, tex_avg_colors);
     Renderer::Get().chunk_tex_array = chunk_tex_array_;
-    for (const auto& image : images) {
-      util::FreeImage(image.pixels);
-    }
   }
   // block_db_.Init();
   block_db_.LoadMeshData(tex_name_to_idx_);
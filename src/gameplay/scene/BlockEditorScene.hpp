@@ -64,7 +64,7 @@ class BlockEditorScene : public Scene {
   BlockModelDataTopBot edit_model_data_top_bot_;
   BlockModelDataUnique edit_model_data_unique_;
 
-  BlockDB block_db_;
+  BlockDB block_db_{BlockDBSource::kJson};
   Player player_;
 
   std::vector<SingleBlock> blocks_;
@@ -10,6 +10,7 @@
 #include "gameplay/world/TerrainGenerator.hpp"
 #include "renderer/ChunkMesher.hpp"
 #include "renderer/Renderer.hpp"
+#include "renderer/RendererUtil.hpp"
 #include "renderer/opengl/Shader.hpp"
 #include "renderer/opengl/Texture2d.hpp"
 #include "resource/Image.hpp"
@@ -119,29 +120,12 @@ ShadowScene::ShadowScene(SceneManager& scene_manager) : Scene(scene_manager) {
   player_.LookAt({0.5f, 0.5f, 0.5f});
 
   std::unordered_map<std::string, uint32_t> tex_name_to_idx;
-  Image image;
-  int tex_idx = 0;
-  std::vector<Image> images;
-  for (const auto& tex_name : block_db_.GetTextureNamesInUse()) {
-    util::LoadImage(image, GET_PATH("resources/textures/" + tex_name + ".png"), 4, true);
-    // TODO: handle other sizes/animations
-    if (image.width != 32 || image.height != 32) continue;
-    tex_name_to_idx[tex_name] = tex_idx++;
-    images.emplace_back(image);
-  }
-  chunk_tex_array_ = TextureManager::Get().Load(
-      Texture2DArrayCreateParams{.images = images,
-                                 .generate_mipmaps = true,
-                                 .internal_format = GL_RGBA8,
-                                 .format = GL_RGBA,
-                                 .filter_mode_min = GL_NEAREST_MIPMAP_LINEAR,
-                                 .filter_mode_max = GL_NEAREST,
-                                 .texture_wrap = GL_REPEAT});
+  std::vector<glm::ivec3> tex_avg_colors;
+  const auto& names_in_use = block_db_.GetTextureNamesInUse();
+  chunk_tex_array_ = util::renderer::LoadBlockTextureArray(
+      {names_in_use.begin(), names_in_use.end()}, tex_name_to_idx, tex_avg_colors);
   Renderer::Get().chunk_tex_array = chunk_tex_array_;
-  block_db_.LoadMeshData(tex_name_to_idx, images);
-  for (auto const& p : images) {
-    util::FreeImage(p.pixels);
-  }
+  block_db_.LoadMeshData(tex_name_to_idx, tex_avg_colors);
 
   {
     Chunk chunk(glm::vec3(0));
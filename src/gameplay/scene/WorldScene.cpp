@@ -7,8 +7,10 @@
 
 #include "Constants.hpp"
 #include "application/SceneManager.hpp"
+#include "application/SettingsManager.hpp"
 #include "application/Window.hpp"
 #include "gameplay/GamePlayer.hpp"
+#include "gameplay/replay/ReplayDriver.hpp"
 #include "gameplay/world/BlockDB.hpp"
 #include "gameplay/world/ChunkManager.hpp"
 #include "renderer/Constants.hpp"
@@ -24,9 +26,25 @@
 #include "util/LoadFile.hpp"
 #include "util/Paths.hpp"
 
+namespace {
+
+// main thread time per frame for texture uploads while loading
+constexpr double kLoadBudgetMS = 4.0;
+constexpr size_t kTextureLayersPerStep = 16;
+
+}  // namespace
+
+struct WorldScene::LoadState {
+  std::vector<std::string> tex_names;
+  util::renderer::DecodedBlockTextures block_textures;
+  size_t layers_uploaded{0};
+  std::vector<util::renderer::IconSource> icon_sources;
+  util::renderer::DecodedIcons icons;
+};
+
 WorldScene::WorldScene(SceneManager& scene_manager, const std::string& directory_path)
     : Scene(scene_manager),
-      chunk_manager_(std::make_unique<ChunkManager>(block_db_)),
+      chunk_manager_(std::make_unique<ChunkManager>(block_db_, Renderer::Get())),
       player_(*chunk_manager_, block_db_),
       directory_path_(directory_path) {
   ZoneScoped;
@@ -59,36 +77,13 @@ WorldScene::WorldScene(SceneManager& scene_manager, const std::string& directory
   player_.SetMovementSpeed(data.value("player_movement_speed", 10.f));
   player_.GetFPSCamera().SetOrientation(pitch, yaw);
 
+  // terrain starts generating now, light and meshing wait for the block textures
+  chunk_manager_->Init(player_.Position());
+  AddLoadStages();
+
   cross_hair_mat_ =
       MaterialManager::Get().LoadTextureMaterial({.filepath = GET_TEXTURE_PATH("crosshair.png")});
 
-  {
-    ZoneScopedN("Load block mesh data");
-    std::unordered_map<std::string, uint32_t> tex_name_to_idx;
-    Image image;
-    int tex_idx = 0;
-    std::vector<Image> images;
-    for (const auto& tex_name : block_db_.GetTextureNamesInUse()) {
-      util::LoadImage(image, GET_PATH("resources/textures/" + tex_name + ".png"), 4, true);
-      // TODO: handle other sizes/animations
-      if (image.width != 32 || image.height != 32) continue;
-      tex_name_to_idx[tex_name] = tex_idx++;
-      images.emplace_back(image);
-    }
-    chunk_tex_array_ = TextureManager::Get().Load({.images = images,
-                                                   .generate_mipmaps = true,
-                                                   .internal_format = GL_RGBA8,
-                                                   .format = GL_RGBA,
-                                                   .filter_mode_min = GL_NEAREST_MIPMAP_LINEAR,
-                                                   .filter_mode_max = GL_NEAREST,
-                                                   .texture_wrap = GL_REPEAT});
-    Renderer::Get().chunk_tex_array = chunk_tex_array_;
-    block_db_.LoadMeshData(tex_name_to_idx, images);
-    for (auto const& p : images) {
-      util::FreeImage(p.pixels);
-    }
-  }
-
   std::vector<Vertex> cube_vertices;
   for (size_t i = 0; i < kCubeVertices.size(); i += 5) {
     cube_vertices.emplace_back(
@@ -117,21 +112,116 @@ WorldScene::WorldScene(SceneManager& scene_manager, const std::string& directory
     skybox_shader.SetFloat("u_time", curr_time * 0.5);
   });
 
-  chunk_manager_->Init(player_.Position());
+  player_.held_item_id = block_db_.GetBlockData("stone")->id;
+  player_.SetBlockEditCallback([this](const BlockEdit& edit) { replay_recorder_.AddEdit(edit); });
+}
 
-  icon_texture_atlas_ =
-      util::renderer::LoadIconTextureAtlas("world_scene_icons", block_db_, *chunk_tex_array_);
+void WorldScene::AddLoadStages() {
+  load_state_ = std::make_unique<LoadState>();
+  const auto& names_in_use = block_db_.GetTextureNamesInUse();
+  load_state_->tex_names = {names_in_use.begin(), names_in_use.end()};
 
-  player_.held_item_id = block_db_.GetBlockData("stone")->id;
+  load_pipeline_.AddStage(
+      "block_textures",
+      [this] {
+        load_state_->block_textures = util::renderer::DecodeBlockTextures(load_state_->tex_names);
+      },
+      [this] {
+        auto& textures = load_state_->block_textures;
+        if (!chunk_tex_array_) {
+          chunk_tex_array_ = util::renderer::CreateBlockTextureArray(textures);
+          return false;
+        }
+        size_t end = std::min(load_state_->layers_uploaded + kTextureLayersPerStep,
+                              textures.images.size());
+        util::renderer::UploadBlockTextureLayers(*chunk_tex_array_, textures,
+                                                 load_state_->layers_uploaded, end);
+        load_state_->layers_uploaded = end;
+        if (end < textures.images.size()) return false;
+        // meshing starts once the mesh data has texture indices
+        Renderer::Get().chunk_tex_array = chunk_tex_array_;
+        block_db_.LoadMeshData(textures.tex_name_to_idx, textures.avg_colors);
+        textures = {};
+        return true;
+      });
+  load_pipeline_.AddStage("render_icons", {}, [this] {
+    // only renders icons missing on disk, usually none
+    load_state_->icon_sources = util::renderer::PrepareIcons(block_db_, *chunk_tex_array_);
+    return true;
+  });
+  load_pipeline_.AddStage(
+      "icon_atlas",
+      [this] { load_state_->icons = util::renderer::DecodeIcons(load_state_->icon_sources); },
+      [this] {
+        icon_texture_atlas_ =
+            util::renderer::CreateIconTextureAtlas("world_scene_icons", load_state_->icons);
+        load_state_ = nullptr;
+        return true;
+      });
 }
 
 void WorldScene::Update(double dt) {
   ZoneScoped;
+  if (!load_pipeline_.Done()) load_pipeline_.Update(kLoadBudgetMS);
+  if (replay_driver_) {
+    // one replay frame per frame, the replay's fixed dt replaces the real one
+    if (!replay_driver_->Step()) {
+      FinishReplay();
+      return;
+    }
+    const ReplayFrame& frame = replay_driver_->CurrentFrame();
+    player_.SetPosition(frame.position);
+    player_.GetFPSCamera().SetOrientation(frame.pitch, frame.yaw);
+    return;
+  }
   chunk_manager_->SetCenter(player_.Position());
+  chunk_manager_->SetHeading(player_.GetCamera().GetFront());
   chunk_manager_->Update(dt);
-  loaded_ = loaded_ || chunk_manager_->IsLoaded();
+  loaded_ = loaded_ || (load_pipeline_.Done() && chunk_manager_->IsLoaded());
   if (!loaded_) time_ += dt;
   player_.Update(dt);
+  replay_recorder_.Update(dt, player_.Position(), player_.GetCamera().GetPitch(),
+                          player_.GetCamera().GetYaw());
+}
+
+void WorldScene::StartReplay() {
+  if (!replay_.Load(directory_path_ + "/replay.json")) return;
+  if (replay_.seed != seed_) {
+    spdlog::warn("replay was recorded with seed {}, world seed is {}", replay_.seed, seed_);
+  }
+  replay_driver_ = std::make_unique<ReplayDriver>(replay_, *chunk_manager_);
+  replay_driver_->fov_degrees = SettingsManager::Get().fov_degrees;
+  replay_driver_->aspect_ratio = window_.GetAspectRatio();
+}
+
+void WorldScene::FinishReplay() {
+  auto report = replay_driver_->GetReport();
+  std::string path = directory_path_ + "/replay_report.json";
+  util::json::WriteJson(report, path);
+  spdlog::info("replay finished, {} frames, report written to {}", replay_driver_->NumFramesRun(),
+               path);
+  replay_driver_ = nullptr;
+}
+
+void WorldScene::DrawReplayImGui() {
+  if (!ImGui::CollapsingHeader("Replay")) return;
+  if (replay_driver_) {
+    ImGui::Text("Playing: %zu / %zu", replay_driver_->NumFramesRun(), replay_driver_->NumFrames());
+    if (ImGui::Button("Stop Replay")) FinishReplay();
+    return;
+  }
+  if (replay_recorder_.IsRecording()) {
+    ImGui::Text("Recording: %zu frames", replay_recorder_.NumFrames());
+    if (ImGui::Button("Stop Recording")) {
+      replay_recorder_.Stop().Write(directory_path_ + "/replay.json");
+    }
+    return;
+  }
+  if (ImGui::Button("Record")) replay_recorder_.Start(seed_);
+  ImGui::SameLine();
+  ImGui::BeginDisabled(!std::filesystem::exists(directory_path_ + "/replay.json"));
+  if (ImGui::Button("Play")) StartReplay();
+  ImGui::EndDisabled();
 }
 
 bool WorldScene::OnEvent(const SDL_Event& event) {
@@ -146,8 +236,11 @@ bool WorldScene::OnEvent(const SDL_Event& event) {
     }
     if (event.key.keysym.sym == SDLK_r && event.key.keysym.mod & KMOD_CTRL &&
         event.key.keysym.mod & KMOD_SHIFT) {
-      chunk_manager_ = std::make_unique<ChunkManager>(block_db_);
+      // the driver holds the old chunk manager
+      if (replay_driver_) FinishReplay();
+      chunk_manager_ = std::make_unique<ChunkManager>(block_db_, Renderer::Get());
       chunk_manager_->SetSeed(seed_);
+      chunk_manager_->Init(player_.Position());
       return true;
     }
   } else if (event.type == SDL_MOUSEBUTTONDOWN) {
@@ -229,7 +322,9 @@ WorldScene::~WorldScene() {
 void WorldScene::OnImGui() {
   ZoneScoped;
 
+  load_pipeline_.OnImGui();
   chunk_manager_->OnImGui();
+  ImGui::BeginDisabled(!load_pipeline_.Done());
   if (ImGui::Button("Reload Icons")) {
     util::renderer::RenderAndWriteIcons(block_db_.GetBlockData(), block_db_.GetMeshData(),
                                         *chunk_tex_array_, false);
@@ -237,7 +332,9 @@ void WorldScene::OnImGui() {
     icon_texture_atlas_ =
         util::renderer::LoadIconTextureAtlas("world_scene_icons", block_db_, *chunk_tex_array_);
   }
+  ImGui::EndDisabled();
   player_.OnImGui();
+  DrawReplayImGui();
   ImGui::Text("time: %f", time_);
   ImGui::SliderInt("Chunk State Y", &chunk_map_display_y_level_, 0, kNumVerticalChunks);
   ImGui::Checkbox("Show Chunk Map", &show_chunk_map_);
@@ -252,6 +349,7 @@ void WorldScene::OnImGui() {
 }
 
 void WorldScene::DrawInventory() {
+  if (!icon_texture_atlas_.material) return;
   ImGuiStyle& style = ImGui::GetStyle();
   ImGuiWindowFlags flags =
       ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoScrollbar;
@@ -1,7 +1,9 @@
 #pragma once
 
+#include "application/LoadPipeline.hpp"
 #include "application/Scene.hpp"
 #include "gameplay/GamePlayer.hpp"
+#include "gameplay/replay/Replay.hpp"
 #include "gameplay/world/BlockDB.hpp"
 #include "renderer/Mesh.hpp"
 #include "renderer/TextureAtlas.hpp"
@@ -9,6 +11,7 @@
 class TextureMaterial;
 class Texture;
 class Window;
+class ReplayDriver;
 
 class WorldScene : public Scene {
  public:
@@ -50,5 +53,21 @@ class WorldScene : public Scene {
   SquareTextureAtlas icon_texture_atlas_;
   Mesh cube_mesh_;
   std::shared_ptr<Texture> chunk_tex_array_;
+
+  ReplayRecorder replay_recorder_;
+  Replay replay_;
+  // drives the player and chunk manager instead of input while a replay plays
+  std::unique_ptr<ReplayDriver> replay_driver_;
+  void StartReplay();
+  void FinishReplay();
+  void DrawReplayImGui();
+
   void DrawInventory();
+
+  // block textures and icons load over the first frames while the world streams in
+  struct LoadState;
+  std::unique_ptr<LoadState> load_state_;
+  void AddLoadStages();
+  // last so it's destroyed first, its worker uses the members above
+  LoadPipeline load_pipeline_{"world"};
 };
@@ -0,0 +1,45 @@
+#include "BlockAccessor.hpp"
+
+#include <glm/common.hpp>
+
+void BlockAccessor::GetBlocks(const glm::ivec3& min, const glm::ivec3& max,
+                              std::span<BlockType> out, BlockType unloaded_block) {
+  ZoneScoped;
+  glm::ivec3 dims = max - min + 1;
+  EASSERT_MSG(out.size() >= static_cast<size_t>(dims.x * dims.y * dims.z), "Output too small");
+  for (int y = min.y; y <= max.y; y++) {
+    auto row_begin = out.begin() + (y - min.y) * dims.z * dims.x;
+    std::fill(row_begin, row_begin + dims.z * dims.x,
+              y >= kMaxBlockHeight ? BlockType{0} : unloaded_block);
+  }
+
+  glm::ivec3 min_chunk = util::chunk::WorldToChunkPos(min);
+  glm::ivec3 max_chunk = util::chunk::WorldToChunkPos(max);
+  min_chunk.y = std::max(min_chunk.y, 0);
+  max_chunk.y = std::min(max_chunk.y, kNumVerticalChunks - 1);
+  glm::ivec3 chunk_pos;
+  for (chunk_pos.y = min_chunk.y; chunk_pos.y <= max_chunk.y; chunk_pos.y++) {
+    for (chunk_pos.z = min_chunk.z; chunk_pos.z <= max_chunk.z; chunk_pos.z++) {
+      for (chunk_pos.x = min_chunk.x; chunk_pos.x <= max_chunk.x; chunk_pos.x++) {
+        const Chunk* chunk = Seek(chunk_pos);
+        if (chunk == nullptr) continue;
+        glm::ivec3 origin = chunk_pos * kChunkLength;
+        glm::ivec3 lo = glm::max(min, origin);
+        glm::ivec3 hi = glm::min(max, origin + kChunkLength - 1);
+        int row_len = hi.x - lo.x + 1;
+        const BlockTypeArray* blocks = chunk->data.GetBlocks();
+        for (int y = lo.y; y <= hi.y; y++) {
+          for (int z = lo.z; z <= hi.z; z++) {
+            auto dst = out.begin() + ((y - min.y) * dims.z + (z - min.z)) * dims.x + lo.x - min.x;
+            if (blocks == nullptr) {
+              std::fill_n(dst, row_len, BlockType{0});
+            } else {
+              int src_idx = ChunkData::GetIndex(lo.x - origin.x, y - origin.y, z - origin.z);
+              std::copy_n(blocks->begin() + src_idx, row_len, dst);
+            }
+          }
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "gameplay/world/Chunk.hpp"
+#include "gameplay/world/ChunkGrid.hpp"
+#include "gameplay/world/ChunkUtil.hpp"
+
+using ChunkMap = ChunkGrid;
+
+// Reads blocks through a cached chunk, only looking up the chunk map when crossing a chunk
+// boundary. Holds a reference to the cached chunk and remembers missing chunks, so keep it short
+// lived (one raycast, one physics step) rather than storing it.
+class BlockAccessor {
+ public:
+  explicit BlockAccessor(const ChunkMap& chunk_map) : chunk_map_(chunk_map) {}
+
+  [[nodiscard]] inline bool BlockPosExists(const glm::ivec3& world_pos) {
+    return Seek(util::chunk::WorldToChunkPos(world_pos)) != nullptr;
+  }
+
+  // Returns air if the chunk isn't loaded.
+  [[nodiscard]] inline BlockType GetBlock(const glm::ivec3& world_pos) {
+    const Chunk* chunk = Seek(util::chunk::WorldToChunkPos(world_pos));
+    if (chunk == nullptr) return 0;
+    const BlockTypeArray* blocks = chunk->data.GetBlocks();
+    if (blocks == nullptr) return 0;
+    return (*blocks)[ChunkData::GetIndex(util::chunk::WorldToPosInChunk(world_pos))];
+  }
+
+  // Copies the blocks in the inclusive region [min, max] into out, x fastest then z then y like
+  // ChunkData. Blocks above the world are air, everything else not loaded is unloaded_block.
+  void GetBlocks(const glm::ivec3& min, const glm::ivec3& max, std::span<BlockType> out,
+                 BlockType unloaded_block);
+
+  [[nodiscard]] uint32_t GetLookupCount() const { return lookup_count_; }
+
+ private:
+  const ChunkMap& chunk_map_;
+  std::shared_ptr<Chunk> chunk_{nullptr};
+  glm::ivec3 chunk_pos_{0};
+  bool has_chunk_pos_{false};
+  uint32_t lookup_count_{0};
+
+  inline const Chunk* Seek(const glm::ivec3& chunk_pos) {
+    if (has_chunk_pos_ && chunk_pos == chunk_pos_) return chunk_.get();
+    chunk_pos_ = chunk_pos;
+    has_chunk_pos_ = true;
+    lookup_count_++;
+    chunk_ = nullptr;
+    chunk_map_.find_fn(chunk_pos, [this](const std::shared_ptr<Chunk>& chunk) { chunk_ = chunk; });
+    return chunk_.get();
+  }
+};
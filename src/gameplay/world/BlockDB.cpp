@@ -5,7 +5,7 @@
 
 #include "application/SettingsManager.hpp"
 #include "gameplay/world/ChunkDef.hpp"
-#include "renderer/RendererUtil.hpp"
+#include "gameplay/world/WorldDataBundle.hpp"
 #include "resource/Image.hpp"
 #include "util/JsonUtil.hpp"
 #include "util/LoadFile.hpp"
@@ -15,6 +15,29 @@ using std::vector;
 
 using json = nlohmann::json;
 
+namespace {
+
+TransparencyType LoadImageAndCheckHasTransparency(const std::string& path,
+                                                  int required_channels = 0) {
+  Image img;
+  util::LoadImage(img, path, required_channels);
+  TransparencyType type = TransparencyType::kNone;
+  if (img.channels == 4) {
+    for (int i = 0; i < img.channels * img.width * img.height; i += 4) {
+      if (*(img.pixels + i + 3) < 255) {
+        type = TransparencyType::kAllOrNone;
+        if (*(img.pixels + i + 3) > 0) {
+          type = TransparencyType::kSemi;
+        }
+      }
+    }
+  }
+  util::FreeImage(img.pixels);
+  return type;
+}
+
+}  // namespace
+
 const std::vector<BlockMeshData>& BlockDB::GetMeshData() const { return block_mesh_data_; };
 const std::vector<BlockData>& BlockDB::GetBlockData() const { return block_data_arr_; };
 
@@ -23,23 +46,12 @@ const std::vector<BlockData>& BlockDB::GetBlockData() const { return block_data_
 // with the textures in use, load the texture 2d array, and then update the mesh data
 
 void BlockDB::LoadMeshData(std::unordered_map<std::string, uint32_t>& tex_name_to_idx,
-                           const std::vector<Image>& image_data) {
+                           const std::vector<glm::ivec3>& tex_avg_colors) {
   mesh_data_initialized_ = true;
   block_mesh_data_.clear();
   // reserve 0 index for air
   block_mesh_data_.emplace_back(default_mesh_data_);
 
-  auto get_avg_color = [](const Image& img) -> glm::ivec3 {
-    glm::ivec3 pix_counts{0, 0, 0};
-    for (int i = 0; i < img.width * img.height * 4; i += 4) {
-      pix_counts.x += img.pixels[i];
-      pix_counts.y += img.pixels[i + 1];
-      pix_counts.z += img.pixels[i + 2];
-    }
-    pix_counts /= (img.width * img.height);
-    return pix_counts;
-  };
-
   // load block mesh data array
   for (size_t i = 1; i < block_model_names_.size(); i++) {
     const auto& model_name = block_model_names_[i];
@@ -50,19 +62,15 @@ void BlockDB::LoadMeshData(std::unordered_map<std::string, uint32_t>& tex_name_t
       std::fill(mesh_data.transparency_type.begin(), mesh_data.transparency_type.end(),
                 static_cast<TransparencyType>(data->transparency_type));
       std::fill(mesh_data.texture_indices.begin(), mesh_data.texture_indices.end(), idx);
-      std::fill(mesh_data.avg_colors.begin(), mesh_data.avg_colors.end(),
-                get_avg_color(image_data[idx]));
+      std::fill(mesh_data.avg_colors.begin(), mesh_data.avg_colors.end(), tex_avg_colors[idx]);
     } else if (BlockModelDataTopBot* data = std::get_if<BlockModelDataTopBot>(&data_general)) {
       uint32_t side_idx = tex_name_to_idx[data->tex_side];
       uint32_t top_idx = tex_name_to_idx[data->tex_top];
       uint32_t bot_idx = tex_name_to_idx[data->tex_bottom];
-      glm::ivec3 side_avg_color = get_avg_color(image_data[side_idx]);
-      mesh_data.avg_colors = {side_avg_color,
-                              side_avg_color,
-                              get_avg_color(image_data[top_idx]),
-                              get_avg_color(image_data[bot_idx]),
-                              side_avg_color,
-                              side_avg_color};
+      glm::ivec3 side_avg_color = tex_avg_colors[side_idx];
+      mesh_data.avg_colors = {side_avg_color,          side_avg_color,
+                              tex_avg_colors[top_idx], tex_avg_colors[bot_idx],
+                              side_avg_color,          side_avg_color};
       mesh_data.texture_indices = {side_idx, side_idx, top_idx, bot_idx, side_idx, side_idx};
     } else if (BlockModelDataUnique* data = std::get_if<BlockModelDataUnique>(&data_general)) {
       uint32_t pos_x_idx = tex_name_to_idx[data->tex_pos_x],
@@ -75,9 +83,8 @@ void BlockDB::LoadMeshData(std::unordered_map<std::string, uint32_t>& tex_name_t
           pos_x_idx, neg_x_idx, pos_y_idx, neg_y_idx, pos_z_idx, neg_z_idx,
       };
       mesh_data.avg_colors = {
-          get_avg_color(image_data[pos_x_idx]), get_avg_color(image_data[neg_x_idx]),
-          get_avg_color(image_data[pos_y_idx]), get_avg_color(image_data[neg_y_idx]),
-          get_avg_color(image_data[pos_z_idx]), get_avg_color(image_data[neg_z_idx]),
+          tex_avg_colors[pos_x_idx], tex_avg_colors[neg_x_idx], tex_avg_colors[pos_y_idx],
+          tex_avg_colors[neg_y_idx], tex_avg_colors[pos_z_idx], tex_avg_colors[neg_z_idx],
       };
     }
     block_mesh_data_.emplace_back(mesh_data);
@@ -127,7 +134,27 @@ const BlockData* BlockDB::GetBlockData(const std::string& name) const {
   return &block_data_arr_[it->second];
 }
 
-BlockDB::BlockDB() {
+BlockDB::BlockDB(BlockDBSource source) {
+  ZoneScoped;
+  if (source == BlockDBSource::kJson) {
+    LoadFromJson();
+    return;
+  }
+  auto path = WorldDataBundle::DefaultPath();
+  uint64_t fingerprint = WorldDataBundle::SourceFingerprint();
+  Terrain terrain;
+  if (WorldDataBundle::Read(path, fingerprint, *this, terrain)) {
+    bundled_terrain_ = std::move(terrain);
+    return;
+  }
+  spdlog::info("Building world data bundle {}", path.string());
+  LoadFromJson();
+  terrain.Load(*this);
+  WorldDataBundle::Write(path, fingerprint, *this, terrain);
+  bundled_terrain_ = std::move(terrain);
+}
+
+void BlockDB::LoadFromJson() {
   ZoneScoped;
   {
     // Default data load cannot fail.
@@ -155,7 +182,7 @@ BlockDB::BlockDB() {
       AddBlockModel(block_model_names_[i]);
     }
   }
-};
+}
 
 void BlockDB::AddBlockModel(const std::string& model_name) {
   auto block_model_data = LoadBlockModelData(model_name);
@@ -182,6 +209,8 @@ void BlockDB::LoadBlockData() {
     data.formatted_name = block_data.value("name", block_defaults_.name);
     data.full_file_path = file.path();
     data.id = block_data["id"].get<uint32_t>();
+    data.move_slow_multiplier = block_defaults_.move_slow_multiplier;
+    data.emits_light = block_defaults_.emits_light;
     if (block_data.contains("properties")) {
       auto properties = block_data["properties"];
       data.move_slow_multiplier =
@@ -410,7 +439,7 @@ bool BlockData::operator==(const BlockData& other) const {
 }
 
 void BlockDB::WriteBlockModelTypeAll(const BlockModelDataAll& data, const std::string& path) {
-  TransparencyType type = util::renderer::LoadImageAndCheckHasTransparency(
+  TransparencyType type = LoadImageAndCheckHasTransparency(
       GET_PATH("resources/textures/") + data.tex_all + ".png");
   nlohmann::json j = {
       {"type", "block/all"},
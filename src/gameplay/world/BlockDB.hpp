@@ -3,8 +3,7 @@
 #include <nlohmann/json_fwd.hpp>
 
 #include "gameplay/world/ChunkDef.hpp"
-
-struct Image;
+#include "gameplay/world/Terrain.hpp"
 
 struct BlockMeshData {
   // pos x,neg x, pos y, neg y, pos z, neg z
@@ -50,9 +49,16 @@ struct BlockModelDataUnique {
 
 using BlockModelData = std::variant<BlockModelDataAll, BlockModelDataTopBot, BlockModelDataUnique>;
 
+enum class BlockDBSource {
+  // the compiled world data bundle, rebuilt from the JSON when it changes
+  kBundle,
+  // always parse the JSON, for the editor which writes it
+  kJson
+};
+
 class BlockDB {
  public:
-  BlockDB();
+  explicit BlockDB(BlockDBSource source = BlockDBSource::kBundle);
   [[nodiscard]] const std::vector<BlockMeshData>& GetMeshData() const;
   [[nodiscard]] const std::vector<BlockData>& GetBlockData() const;
   [[nodiscard]] const std::unordered_set<std::string>& GetTextureNamesInUse() const;
@@ -60,8 +66,9 @@ class BlockDB {
 
   // void Init();
   void LoadMeshData(std::unordered_map<std::string, uint32_t>& tex_name_to_idx);
+  // tex_avg_colors is indexed by texture index, computed when the textures are decoded
   void LoadMeshData(std::unordered_map<std::string, uint32_t>& tex_name_to_idx,
-                    const std::vector<Image>& image_data);
+                    const std::vector<glm::ivec3>& tex_avg_colors);
   void WriteBlockData(const BlockData& data, const std::string& model_name) const;
   static void WriteBlockModelTypeAll(const BlockModelDataAll& data, const std::string& path);
   static void WriteBlockModelTypeTopBot(const BlockModelDataTopBot& data, const std::string& path);
@@ -74,10 +81,16 @@ class BlockDB {
   [[nodiscard]] static std::vector<std::string> GetAllTextureNames();
 
   [[nodiscard]] inline bool MeshDataInitialized() const { return mesh_data_initialized_; }
+  // The terrain from the bundle when loaded from one, Terrain::Load copies it instead of parsing.
+  [[nodiscard]] const Terrain* GetBundledTerrain() const {
+    return bundled_terrain_ ? &bundled_terrain_.value() : nullptr;
+  }
 
  private:
   // only the editor has full access to adding and changing data at runtime
   friend class BlockEditorScene;
+  friend class WorldDataBundle;
+  void LoadFromJson();
   void AddBlockModel(const std::string& model_name);
   bool mesh_data_initialized_{false};
 
@@ -105,4 +118,5 @@ class BlockDB {
   std::unordered_set<std::string> block_tex_names_in_use_;
   std::unordered_map<std::string, BlockModelData> model_name_to_model_data_;
   std::unordered_map<std::string, uint32_t> block_name_to_id_;
+  std::optional<Terrain> bundled_terrain_;
 };
@@ -1,5 +1,25 @@
 #include "Chunk.hpp"
 
-Chunk::Chunk(const glm::ivec3& pos) : pos_(pos) {}
+namespace {
+
+std::atomic<uint32_t> next_generation{1};
+
+}  // namespace
+
+Chunk::Chunk(const glm::ivec3& pos)
+    : pos_(pos), generation_(next_generation.fetch_add(1, std::memory_order_relaxed)) {}
+
+Chunk::Chunk(const Chunk& other)
+    : data(other.data),
+      mesh(other.mesh),
+      lod_level(other.lod_level),
+      mesh_state(other.mesh_state.load(std::memory_order_acquire)),
+      pos_(other.pos_),
+      generation_(other.GetGeneration()) {}
 
 const glm::ivec3& Chunk::GetPos() const { return pos_; }
+
+void Chunk::BumpGeneration() {
+  generation_.store(next_generation.fetch_add(1, std::memory_order_relaxed),
+                    std::memory_order_release);
+}
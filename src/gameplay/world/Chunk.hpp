@@ -1,19 +1,43 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <glm/vec2.hpp>
 
 #include "ChunkData.hpp"
+#include "ColumnHeightMap.hpp"
 
 struct LODChunkMeshTask {
   std::vector<ChunkVertex> vertices;
   std::vector<uint32_t> indices;
   glm::ivec2 pos;
   LODLevel lod_level;
+  // chunk map column generation when the task was sent
+  uint32_t generation{};
 };
 
 struct ChunkMeshTask {
   MeshVerticesIndices verts_indices;
   glm::ivec3 pos;
+  // when the mesh was requested, for the queued to uploaded latency
+  std::chrono::steady_clock::time_point queued_time;
+  // the chunk's generation when the mesh was requested
+  uint32_t generation{};
+};
+
+struct ChunkTerrainTask {
+  std::unique_ptr<ColumnHeightMap> heights;
+  glm::ivec2 pos;
+  // chunk map column generation when the task was sent
+  uint32_t generation{};
+};
+
+struct ChunkLightTask {
+  std::array<std::shared_ptr<const LightArray>, kNumVerticalChunks> light;
+  glm::ivec2 pos;
+  uint32_t generation{};
+  // the column's light version when the task was sent
+  uint32_t light_version{};
 };
 
 struct ChunkMesh {
@@ -24,16 +48,27 @@ struct ChunkMesh {
 class Chunk {
  public:
   explicit Chunk(const glm::ivec3& pos);
+  // for meshing a copy outside the chunk map, keeps the generation of the chunk it copies
+  Chunk(const Chunk& other);
   [[nodiscard]] const glm::ivec3& GetPos() const;
 
+  // Changes every time the chunk is remeshed after an edit, so a mesh made from older blocks can be
+  // told apart. Every chunk draws from one counter, so a chunk loaded again at the same position
+  // doesn't repeat a generation of the one it replaced.
+  [[nodiscard]] uint32_t GetGeneration() const {
+    return generation_.load(std::memory_order_acquire);
+  }
+  void BumpGeneration();
+
   ChunkData data;
   ChunkMesh mesh;
   LODLevel lod_level{LODLevel::kNoMesh};
 
   enum class State { kNotFinished, kQueued, kFinished };
-  State terrain_state{State::kNotFinished};
-  State mesh_state{State::kNotFinished};
+  // terrain and light state are per column, see ChunkColumn
+  std::atomic<State> mesh_state{State::kNotFinished};
 
  private:
   glm::ivec3 pos_;
+  std::atomic<uint32_t> generation_;
 };
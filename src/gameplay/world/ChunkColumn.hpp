@@ -0,0 +1,34 @@
+#pragma once
+
+#include "gameplay/world/Chunk.hpp"
+#include "gameplay/world/ChunkPool.hpp"
+#include "gameplay/world/ColumnHeightMap.hpp"
+
+// The kNumVerticalChunks chunks of a column and what belongs to the column as a whole. Terrain,
+// light and LOD meshes are made per column, so the chunk map keeps one of these per resident
+// column and those stages look it up once instead of once per chunk. The chunks are created with
+// the column and never replaced, so a worker holding the column can read them without the map.
+struct ChunkColumn {
+  explicit ChunkColumn(const glm::ivec2& pos) : pos_(pos) {
+    for (int y = 0; y < kNumVerticalChunks; y++) {
+      chunks[y] = ChunkPool::Get().MakeChunk({pos.x, y, pos.y});
+    }
+  }
+
+  [[nodiscard]] const glm::ivec2& GetPos() const { return pos_; }
+
+  ChunkStackArray chunks;
+  // null until the terrain is finished
+  std::shared_ptr<ColumnHeightMap> heights;
+  // the column's LOD 1 mesh, 0 if it has none
+  uint32_t lod_mesh_handle{};
+  Chunk::State terrain_state{Chunk::State::kNotFinished};
+  Chunk::State light_state{Chunk::State::kNotFinished};
+  // bumped for every light task sent, only the latest task's result is used
+  uint32_t light_version{0};
+  // lit while a neighbor column wasn't loaded, so it's relit once that neighbor has terrain
+  bool lit_at_load_edge{false};
+
+ private:
+  glm::ivec2 pos_;
+};
@@ -11,16 +11,21 @@ ChunkData::ChunkData(const ChunkData& other)
       lod_needs_refresh_(other.lod_needs_refresh_),
       has_lod_1_(other.has_lod_1_) {
   if (other.blocks_) {
-    blocks_ = std::make_unique<BlockTypeArray>(*other.blocks_);
+    blocks_ = ChunkPool::Get().AcquireBlocks();
+    *blocks_ = *other.blocks_;
   }
   if (other.blocks_lod_1_) {
-    blocks_lod_1_ = std::make_unique<BlockTypeArrayLOD1>(*other.blocks_lod_1_);
+    blocks_lod_1_ = ChunkPool::Get().AcquireLODBlocks();
+    *blocks_lod_1_ = *other.blocks_lod_1_;
   }
+  // shared, neither copy writes to it
+  SetLightArray(other.GetLightArray());
 }
 
 ChunkData::ChunkData(ChunkData&& other) noexcept
     : blocks_(std::move(other.blocks_)),
       blocks_lod_1_(std::move(other.blocks_lod_1_)),
+      light_(other.light_.exchange(nullptr, std::memory_order_acq_rel)),
       block_count_(other.block_count_),
       lod_needs_refresh_(other.lod_needs_refresh_),
       has_lod_1_(other.has_lod_1_) {}
@@ -30,11 +35,14 @@ ChunkData& ChunkData::operator=(const ChunkData& other) {
   lod_needs_refresh_ = other.lod_needs_refresh_;
   has_lod_1_ = other.has_lod_1_;
   if (other.blocks_) {
-    blocks_ = std::make_unique<BlockTypeArray>(*other.blocks_);
+    blocks_ = ChunkPool::Get().AcquireBlocks();
+    *blocks_ = *other.blocks_;
   }
   if (other.blocks_lod_1_) {
-    blocks_lod_1_ = std::make_unique<BlockTypeArrayLOD1>(*other.blocks_lod_1_);
+    blocks_lod_1_ = ChunkPool::Get().AcquireLODBlocks();
+    *blocks_lod_1_ = *other.blocks_lod_1_;
   }
+  SetLightArray(other.GetLightArray());
   return *this;
 }
 
@@ -44,6 +52,7 @@ ChunkData& ChunkData::operator=(ChunkData&& other) noexcept {
   has_lod_1_ = other.has_lod_1_;
   blocks_ = std::move(other.blocks_);
   blocks_lod_1_ = std::move(other.blocks_lod_1_);
+  SetLightArray(other.light_.exchange(nullptr, std::memory_order_acq_rel));
   return *this;
 }
 
@@ -52,6 +61,12 @@ BlockType ChunkData::GetBlockLOD1(int x, int y, int z) const {
   return (*blocks_lod_1_)[x + z * 16 + y * 256];
 }
 
+uint8_t ChunkData::GetLight(int x, int y, int z) const {
+  std::shared_ptr<const LightArray> light = GetLightArray();
+  if (light == nullptr) return kFullSkyLight;
+  return (*light)[GetIndex(x, y, z)];
+}
+
 BlockType ChunkData::GetBlock(int x, int y, int z) const {
   if (blocks_ == nullptr) return 0;
   return (*blocks_)[GetIndex(x, y, z)];
@@ -63,7 +78,7 @@ BlockType ChunkData::GetBlock(const glm::ivec3& pos) const {
 }
 
 void ChunkData::SetBlock(int x, int y, int z, BlockType block) {
-  if (blocks_ == nullptr) blocks_ = std::make_unique<BlockTypeArray>();
+  if (blocks_ == nullptr) blocks_ = ChunkPool::Get().AcquireBlocks();
   int index = GetIndex(x, y, z);
   BlockType curr = (*blocks_)[index];
   block_count_ += (curr == 0 && block != 0);
@@ -76,15 +91,81 @@ void ChunkData::SetBlock(const glm::ivec3& pos, BlockType block) {
   return SetBlock(pos.x, pos.y, pos.z, block);
 }
 
+void ChunkData::SetBlocks(std::span<const std::pair<int, BlockType>> index_blocks) {
+  if (index_blocks.empty()) return;
+  if (blocks_ == nullptr) blocks_ = ChunkPool::Get().AcquireBlocks();
+  int block_count_delta = 0;
+  for (const auto& [index, block] : index_blocks) {
+    BlockType curr = (*blocks_)[index];
+    block_count_delta += (curr == 0 && block != 0);
+    block_count_delta -= (curr != 0 && block == 0);
+    (*blocks_)[index] = block;
+  }
+  block_count_ += block_count_delta;
+  lod_needs_refresh_ = true;
+}
+
+void ChunkData::FillRow(int y, int z, int x_begin, int x_end, BlockType block) {
+  if (x_begin >= x_end) return;
+  if (blocks_ == nullptr) {
+    if (block == 0) return;
+    blocks_ = ChunkPool::Get().AcquireBlocks();
+  }
+  auto begin = blocks_->begin() + GetIndex(x_begin, y, z);
+  auto end = begin + (x_end - x_begin);
+  int prev_non_air = std::count_if(begin, end, [](BlockType b) { return b != 0; });
+  std::fill(begin, end, block);
+  block_count_ += (block != 0 ? x_end - x_begin : 0) - prev_non_air;
+  lod_needs_refresh_ = true;
+}
+
 int ChunkData::GetBlockCount() const { return block_count_; }
 
+std::vector<uint32_t> ChunkData::EncodeBlocks() const {
+  std::vector<uint32_t> runs;
+  if (blocks_ == nullptr || block_count_ == 0) return runs;
+  BlockType run_block = (*blocks_)[0];
+  uint32_t run_length = 0;
+  for (BlockType block : *blocks_) {
+    if (block != run_block) {
+      runs.emplace_back((run_length - 1) << 16 | run_block);
+      run_block = block;
+      run_length = 0;
+    }
+    run_length++;
+  }
+  runs.emplace_back((run_length - 1) << 16 | run_block);
+  runs.shrink_to_fit();
+  return runs;
+}
+
+void ChunkData::DecodeBlocks(std::span<const uint32_t> runs) {
+  block_count_ = 0;
+  lod_needs_refresh_ = true;
+  if (runs.empty()) {
+    blocks_.reset();
+    return;
+  }
+  if (blocks_ == nullptr) blocks_ = ChunkPool::Get().AcquireBlocks();
+  auto it = blocks_->begin();
+  for (uint32_t run : runs) {
+    auto block = static_cast<BlockType>(run & 0xffff);
+    uint32_t run_length = (run >> 16) + 1;
+    EASSERT(run_length <= static_cast<uint32_t>(blocks_->end() - it));
+    std::fill_n(it, run_length, block);
+    it += run_length;
+    block_count_ += block != 0 ? static_cast<int>(run_length) : 0;
+  }
+  EASSERT(it == blocks_->end());
+}
+
 void ChunkData::DownSample() {
   ZoneScoped;
   if (has_lod_1_ && !lod_needs_refresh_) return;
   has_lod_1_ = true;
   lod_needs_refresh_ = false;
   if (block_count_ == 0) return;
-  if (blocks_lod_1_ == nullptr) blocks_lod_1_ = std::make_unique<BlockTypeArrayLOD1>();
+  if (blocks_lod_1_ == nullptr) blocks_lod_1_ = ChunkPool::Get().AcquireLODBlocks();
   uint32_t f = 2;
   // TODO: templatize downsampling
   uint32_t chunk_length = kChunkLength / f;
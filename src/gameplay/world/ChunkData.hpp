@@ -1,9 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <glm/vec3.hpp>
 #include <memory>
 
 #include "gameplay/world/ChunkDef.hpp"
+#include "gameplay/world/ChunkPool.hpp"
 
 class ChunkData {
  public:
@@ -17,10 +19,24 @@ class ChunkData {
   void SetBlock(const glm::ivec3& pos, BlockType block);
   void SetBlock(int x, int y, int z, BlockType block);
   void SetBlockNoCheck(const glm::ivec3& pos, BlockType block);
+  // Applies (index, block) edits in order and updates the block count once. Sort by index first
+  // for sequential writes.
+  void SetBlocks(std::span<const std::pair<int, BlockType>> index_blocks);
+  // Fills x in [x_begin, x_end) of the row at y, z. Rows are contiguous in the block array.
+  void FillRow(int y, int z, int x_begin, int x_end, BlockType block);
   [[nodiscard]] BlockType GetBlockNoCheck(const glm::ivec3& pos) const;
   [[nodiscard]] BlockType GetBlock(const glm::ivec3& pos) const;
   [[nodiscard]] BlockType GetBlock(int x, int y, int z) const;
   [[nodiscard]] BlockType GetBlockLOD1(int x, int y, int z) const;
+  [[nodiscard]] uint8_t GetLight(int x, int y, int z) const;
+  // Light arrays are never written once set, so a reader keeps the snapshot alive and reads it
+  // while the main thread publishes a new one. Null while fully sky lit.
+  [[nodiscard]] std::shared_ptr<const LightArray> GetLightArray() const {
+    return light_.load(std::memory_order_acquire);
+  }
+  void SetLightArray(std::shared_ptr<const LightArray> light) {
+    light_.store(std::move(light), std::memory_order_release);
+  }
   [[nodiscard]] BlockTypeArray* GetBlocks() const { return blocks_.get(); }
   [[nodiscard]] inline bool HasLOD1() const { return has_lod_1_; }
 
@@ -41,14 +57,22 @@ class ChunkData {
     return (pos.x & 0b1111100000) || (pos.y & 0b1111100000) || (pos.z & 0b1111100000);
   }
 
-  std::unique_ptr<BlockTypeArray> blocks_{nullptr};
-  std::unique_ptr<BlockTypeArrayLOD1> blocks_lod_1_{nullptr};
+  // from the chunk pool, and back to it when freed
+  BlockTypeArrayPtr blocks_{nullptr};
+  BlockTypeArrayLOD1Ptr blocks_lod_1_{nullptr};
   void DownSample();
   [[nodiscard]] int GetBlockCount() const;
+  // Run length encoded blocks, (run length - 1) << 16 | block per run. Empty without blocks.
+  [[nodiscard]] std::vector<uint32_t> EncodeBlocks() const;
+  // Replaces the blocks with encoded ones. DownSample after to refresh the LOD blocks.
+  void DecodeBlocks(std::span<const uint32_t> runs);
 
  private:
   friend class TerrainGenerator;
   friend class SingleChunkTerrainGenerator;
+  // null until the chunk has any light other than kFullSkyLight. Swapped from the main thread
+  // while mesh jobs read it.
+  std::atomic<std::shared_ptr<const LightArray>> light_;
   int block_count_{0};
   bool lod_needs_refresh_{true};
   bool has_lod_1_{false};
@@ -1,6 +1,9 @@
 #pragma once
 
 constexpr const int kChunkLength = 32;
+// world to chunk positions use shifts and masks, which also floor negative coordinates
+constexpr const int kChunkLengthShift = 5;
+static_assert(1 << kChunkLengthShift == kChunkLength);
 constexpr const int kLOD1ChunkLength = 16;
 constexpr const int kChunkLengthM1 = kChunkLength - 1;
 constexpr const int kChunkArea = kChunkLength * kChunkLength;
@@ -16,6 +19,11 @@ class Chunk;
 
 using BlockTypeArray = std::array<BlockType, kChunkVolume>;
 using BlockTypeArrayLOD1 = std::array<BlockType, kChunkVolume / 8>;
+// sky light in the high 4 bits, block light in the low 4 bits
+using LightArray = std::array<uint8_t, kChunkVolume>;
+constexpr const uint8_t kMaxLightLevel = 15;
+// light of a chunk without a light array: open sky and no block light
+constexpr const uint8_t kFullSkyLight = kMaxLightLevel << 4;
 
 using ChunkNeighborArray = std::array<std::shared_ptr<Chunk>, 27>;
 using ChunkStackArray = std::array<std::shared_ptr<Chunk>, kNumVerticalChunks>;
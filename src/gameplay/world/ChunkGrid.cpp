@@ -0,0 +1,46 @@
+#include "ChunkGrid.hpp"
+
+ChunkGrid::ChunkGrid(int radius)
+    : side_(radius * 2 + 1), slots_(std::make_unique<Slot[]>(side_ * side_)) {}
+
+std::shared_ptr<ChunkColumn> ChunkGrid::FindColumn(const glm::ivec2& column_pos) const {
+  std::shared_ptr<ChunkColumn> column =
+      GetSlot(column_pos.x, column_pos.y).column.load(std::memory_order_acquire);
+  // the slot may hold another column that maps to it
+  if (column && column->GetPos() != column_pos) return nullptr;
+  return column;
+}
+
+std::shared_ptr<Chunk> ChunkGrid::find(const glm::ivec3& pos) const {
+  if (pos.y < 0 || pos.y >= kNumVerticalChunks) return nullptr;
+  std::shared_ptr<ChunkColumn> column = FindColumn({pos.x, pos.z});
+  return column ? column->chunks[pos.y] : nullptr;
+}
+
+bool ChunkGrid::InsertColumn(std::shared_ptr<ChunkColumn> column) {
+  const glm::ivec2& pos = column->GetPos();
+  Slot& slot = GetSlot(pos.x, pos.y);
+  if (slot.raw) {
+    EASSERT_MSG(slot.raw->GetPos() == pos, "Chunk grid slot holds another column, unload it first");
+    return false;
+  }
+  slot.raw = column.get();
+  slot.generation++;
+  slot.column.store(std::move(column), std::memory_order_release);
+  size_++;
+  return true;
+}
+
+std::shared_ptr<ChunkColumn> ChunkGrid::EraseColumn(const glm::ivec2& column_pos) {
+  if (!PeekColumn(column_pos)) return nullptr;
+  Slot& slot = GetSlot(column_pos.x, column_pos.y);
+  slot.raw = nullptr;
+  size_--;
+  return slot.column.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+std::optional<glm::ivec2> ChunkGrid::StaleColumn(const glm::ivec2& column_pos) const {
+  const ChunkColumn* column = GetSlot(column_pos.x, column_pos.y).raw;
+  if (!column || column->GetPos() == column_pos) return std::nullopt;
+  return column->GetPos();
+}
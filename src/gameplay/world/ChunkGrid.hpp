@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+
+#include "gameplay/world/ChunkColumn.hpp"
+
+// The resident chunk columns in a toroidal grid. Residency is always a square around the center,
+// so column (x, z) lives in slot (x mod side, z mod side) and a lookup is an index instead of a
+// hash and bucket lock. Moving the center only recycles the slots of the rows and columns that
+// scroll out of range. A slot can still hold a column that left the range until that column is
+// unloaded, and lookups of the position that maps to the same slot miss until then.
+//
+// find, find_fn and FindColumn are safe from any thread and keep what they return alive while
+// it's used. Everything else, including inserting and erasing, is main thread only. The find_fn,
+// find and contains names match the cuckoo map this replaced.
+class ChunkGrid {
+ public:
+  // Holds every column within radius columns of any center.
+  explicit ChunkGrid(int radius);
+  ChunkGrid(const ChunkGrid&) = delete;
+  ChunkGrid& operator=(const ChunkGrid&) = delete;
+
+  // nullptr if not resident
+  [[nodiscard]] std::shared_ptr<ChunkColumn> FindColumn(const glm::ivec2& column_pos) const;
+  [[nodiscard]] std::shared_ptr<Chunk> find(const glm::ivec3& pos) const;
+  // Calls fn with the chunk if it's resident.
+  template <typename Fn>
+  bool find_fn(const glm::ivec3& pos, Fn&& fn) const {
+    std::shared_ptr<Chunk> chunk = find(pos);
+    if (!chunk) return false;
+    fn(chunk);
+    return true;
+  }
+
+  // Main thread, no refcount. Only valid until the column is erased.
+  [[nodiscard]] ChunkColumn* PeekColumn(const glm::ivec2& column_pos) const {
+    ChunkColumn* column = GetSlot(column_pos.x, column_pos.y).raw;
+    if (!column || column->GetPos() != column_pos) return nullptr;
+    return column;
+  }
+  [[nodiscard]] Chunk* Peek(const glm::ivec3& pos) const {
+    if (pos.y < 0 || pos.y >= kNumVerticalChunks) return nullptr;
+    ChunkColumn* column = PeekColumn({pos.x, pos.z});
+    return column ? column->chunks[pos.y].get() : nullptr;
+  }
+  [[nodiscard]] bool contains(const glm::ivec3& pos) const { return Peek(pos) != nullptr; }
+
+  // Fails if a column is already resident at its position. The slot must not hold another column.
+  bool InsertColumn(std::shared_ptr<ChunkColumn> column);
+  // Returns the erased column, nullptr if it wasn't resident. Other threads may still hold it.
+  std::shared_ptr<ChunkColumn> EraseColumn(const glm::ivec2& column_pos);
+  // resident columns
+  [[nodiscard]] size_t size() const { return size_; }
+
+  // The other column still resident in column_pos's slot, if there is one.
+  [[nodiscard]] std::optional<glm::ivec2> StaleColumn(const glm::ivec2& column_pos) const;
+  // Changes every time a column starts being resident in the slot, so work started on a column can
+  // tell if the column was unloaded and loaded again before it finished.
+  [[nodiscard]] uint32_t ColumnGeneration(const glm::ivec2& column_pos) const {
+    return GetSlot(column_pos.x, column_pos.y).generation;
+  }
+
+  template <typename Fn>
+  void ForEachColumn(Fn&& fn) const {
+    for (int i = 0; i < side_ * side_; i++) {
+      if (slots_[i].raw) fn(*slots_[i].raw);
+    }
+  }
+
+  [[nodiscard]] int Side() const { return side_; }
+  [[nodiscard]] size_t MemoryBytes() const {
+    return sizeof(Slot) * static_cast<size_t>(side_) * side_;
+  }
+
+ private:
+  struct Slot {
+    // read from any thread
+    std::atomic<std::shared_ptr<ChunkColumn>> column;
+    // the rest only on the main thread
+    ChunkColumn* raw{nullptr};
+    uint32_t generation{0};
+  };
+
+  [[nodiscard]] inline int Wrap(int v) const {
+    int m = v % side_;
+    return m < 0 ? m + side_ : m;
+  }
+  [[nodiscard]] inline const Slot& GetSlot(int x, int z) const {
+    return slots_[Wrap(z) * side_ + Wrap(x)];
+  }
+  [[nodiscard]] inline Slot& GetSlot(int x, int z) { return slots_[Wrap(z) * side_ + Wrap(x)]; }
+
+  int side_;
+  std::unique_ptr<Slot[]> slots_;
+  size_t size_{0};
+};
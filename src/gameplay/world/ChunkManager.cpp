@@ -2,22 +2,25 @@
 
 #include <imgui.h>
 
+#include <glm/common.hpp>
+
+#include "application/Metrics.hpp"
 #include "application/SettingsManager.hpp"
 #include "gameplay/world/BlockDB.hpp"
 #include "gameplay/world/Chunk.hpp"
 #include "gameplay/world/ChunkData.hpp"
 #include "gameplay/world/ChunkDef.hpp"
 #include "gameplay/world/ChunkHelpers.hpp"
+#include "gameplay/world/ChunkPool.hpp"
 #include "gameplay/world/ChunkUtil.hpp"
 #include "gameplay/world/TerrainGenerator.hpp"
 #include "renderer/ChunkMesher.hpp"
 #include "renderer/Constants.hpp"
-#include "renderer/Renderer.hpp"
 #include "util/Timer.hpp"
 
 namespace {
 
-// dp::thread_pool thread_pool(std::thread::hardware_concurrency() - 2);
+constexpr const int kMaxLoadDistance = 64;
 
 constexpr const int kChunkNeighborOffsets[27][3] = {
     {-1, -1, -1}, {-1, -1, 0}, {-1, -1, 1}, {-1, 0, -1}, {-1, 0, 0},  {-1, 0, 1}, {-1, 1, -1},
@@ -27,117 +30,532 @@ constexpr const int kChunkNeighborOffsets[27][3] = {
 
 };
 
+size_t MeshBytes(const MeshVerticesIndices& mesh) {
+  return sizeof(ChunkVertex) * (mesh.opaque_vertices.capacity() +
+                                mesh.transparent_vertices.capacity()) +
+         sizeof(uint32_t) * (mesh.opaque_indices.capacity() + mesh.transparent_indices.capacity());
+}
+
+size_t MeshBytes(const std::vector<ChunkVertex>& vertices, const std::vector<uint32_t>& indices) {
+  return sizeof(ChunkVertex) * vertices.capacity() + sizeof(uint32_t) * indices.capacity();
+}
+
+// Moves the front of a finished queue the workers push to into out, false if it's empty. Locks
+// per task so workers aren't held up while the main thread handles the results.
+template <typename T>
+bool PopFinished(std::mutex& mtx, std::queue<T>& queue, T& out) {
+  std::lock_guard<std::mutex> lock(mtx);
+  if (queue.empty()) return false;
+  out = std::move(queue.front());
+  queue.pop();
+  return true;
+}
+
+// Bounds within a chunk of the light that differs between two of its light arrays, null being all
+// sky light. Returns false if nothing differs.
+bool LightDiffBounds(const LightArray* a, const LightArray* b, glm::ivec3& min, glm::ivec3& max) {
+  if (a == b) return false;
+  min = glm::ivec3{kChunkLength};
+  max = glm::ivec3{-1};
+  for (int i = 0; i < kChunkVolume; i++) {
+    uint8_t light_a = a ? (*a)[i] : kFullSkyLight;
+    uint8_t light_b = b ? (*b)[i] : kFullSkyLight;
+    if (light_a == light_b) continue;
+    glm::ivec3 pos{i % kChunkLength, i / kChunkArea, (i / kChunkLength) % kChunkLength};
+    min = glm::min(min, pos);
+    max = glm::max(max, pos);
+  }
+  return max.x >= 0;
+}
+
+void ImGuiBytes(const char* label, size_t bytes) {
+  ImGui::Text("%s: %.2f MB", label, static_cast<double>(bytes) / (1024.0 * 1024.0));
+}
+
 }  // namespace
 
 // TODO: find the best meshing memory pool size
-ChunkManager::ChunkManager(BlockDB& block_db) : block_db_(block_db) {
+ChunkManager::ChunkManager(BlockDB& block_db, ChunkMeshSink& mesh_sink)
+    : block_db_(block_db), mesh_sink_(mesh_sink), chunk_map_(kMaxLoadDistance) {
   auto settings = SettingsManager::Get().LoadSetting("chunk_manager");
   load_distance_ = settings.value("load_distance", 16);
   lod_1_load_distance_ = std::min(
       settings.value("lod_1_load_distance", std::max(0, load_distance_ - 3)), load_distance_);
   frequency_ = settings.value("frequency", 1.0);
-  if (load_distance_ >= 64) load_distance_ = 64;
+  lighting_enabled_ = settings.value("lighting", true);
+  unload_band_ = std::max(0, settings.value("unload_band", unload_band_));
+  if (load_distance_ >= kMaxLoadDistance) load_distance_ = kMaxLoadDistance;
   if (load_distance_ <= 0) load_distance_ = 1;
   terrain_.Load(block_db);
+  memory_budget_.LoadSettings(SettingsManager::Get().LoadSetting("memory_budget"));
+  ChunkPool::Get().LoadSettings(SettingsManager::Get().LoadSetting("chunk_pool"));
+  memory_budget_.SetTargets(load_distance_, lod_1_load_distance_);
+  stream_predictor_.LoadSettings(SettingsManager::Get().LoadSetting("stream_predictor"));
+  evicted_columns_.LoadSettings(SettingsManager::Get().LoadSetting("evicted_columns"));
+  frame_budget_.LoadSettings(SettingsManager::Get().LoadSetting("frame_budget"));
+  job_system_.LoadSettings(SettingsManager::Get().LoadSetting("job_system"));
+  job_system_.Start();
 }
 
 void ChunkManager::SetBlock(const glm::ivec3& pos, BlockType block) {
   auto chunk_pos = util::chunk::WorldToChunkPos(pos);
   EASSERT_MSG(chunk_map_.contains(chunk_pos), "Set block in non existent chunk");
-  chunk_map_.find_fn(chunk_pos,
-                     [this, &chunk_pos, &pos, block](const std::shared_ptr<Chunk>& chunk) {
-                       glm::ivec3 block_pos_in_chunk = util::chunk::WorldToPosInChunk(pos);
-                       chunk->data.SetBlock(block_pos_in_chunk, block);
-                       AddRelatedChunks(block_pos_in_chunk, chunk_pos, chunk_mesh_queue_immediate_);
-                     });
+  BlockType old_block{0};
+  if (!chunk_map_.find_fn(chunk_pos,
+                          [this, &chunk_pos, &pos, &old_block,
+                           block](const std::shared_ptr<Chunk>& chunk) {
+                            glm::ivec3 block_pos_in_chunk = util::chunk::WorldToPosInChunk(pos);
+                            old_block = chunk->data.GetBlock(block_pos_in_chunk);
+                            chunk->data.SetBlock(block_pos_in_chunk, block);
+                            AddRelatedChunks(block_pos_in_chunk, chunk_pos,
+                                             chunk_mesh_queue_immediate_);
+                          })) {
+    return;
+  }
+  // outside find_fn, these look up other chunks and the map's locks aren't reentrant
+  UpdateHeights(pos, pos);
+  // nothing is lit before the light props are set
+  if (!lighting_enabled_ || !light_props_set_) return;
+  Timer timer;
+  light_changes_.clear();
+  light_engine_.UpdateBlock(chunk_map_, pos, old_block, light_changes_);
+  for (const auto& change : light_changes_) {
+    AddRelatedChunks(change.min, change.max, change.chunk_pos, chunk_mesh_queue_immediate_);
+  }
+  last_light_update_ms_ = timer.ElapsedMS();
+}
+
+void ChunkManager::SetBlocks(std::span<const BlockEdit> edits) {
+  ZoneScoped;
+  // group by chunk so each chunk is looked up and queued for remeshing once
+  std::unordered_map<glm::ivec3, std::vector<std::pair<int, BlockType>>> chunk_edits;
+  for (const auto& edit : edits) {
+    glm::ivec3 chunk_pos = util::chunk::WorldToChunkPos(edit.pos);
+    chunk_edits[chunk_pos].emplace_back(
+        ChunkData::GetIndex(util::chunk::WorldToPosInChunk(edit.pos)), edit.block);
+  }
+
+  for (auto& [chunk_pos, index_blocks] : chunk_edits) {
+    // stable so that the last edit to a position wins
+    std::stable_sort(index_blocks.begin(), index_blocks.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    chunk_map_.find_fn(chunk_pos, [this, &chunk_pos,
+                                   &index_blocks](const std::shared_ptr<Chunk>& chunk) {
+      chunk->data.SetBlocks(index_blocks);
+      glm::ivec3 min{kChunkLength};
+      glm::ivec3 max{-1};
+      for (const auto& index_block : index_blocks) {
+        int idx = index_block.first;
+        glm::ivec3 pos_in_chunk{idx % kChunkLength, idx / kChunkArea,
+                                (idx / kChunkLength) % kChunkLength};
+        min = glm::min(min, pos_in_chunk);
+        max = glm::max(max, pos_in_chunk);
+      }
+      AddRelatedChunks(min, max, chunk_pos, chunk_mesh_queue_immediate_);
+    });
+  }
+
+  if (!edits.empty()) {
+    glm::ivec3 min = edits[0].pos;
+    glm::ivec3 max = edits[0].pos;
+    for (const auto& edit : edits) {
+      min = glm::min(min, edit.pos);
+      max = glm::max(max, edit.pos);
+    }
+    UpdateHeights(min, max);
+    RelightEdit(min, max);
+  }
+}
+
+void ChunkManager::FillBox(const glm::ivec3& min, const glm::ivec3& max, BlockType block) {
+  ZoneScoped;
+  FillRows(min, max, block, [&min, &max](int, int, int& x_begin, int& x_end) {
+    x_begin = min.x;
+    x_end = max.x;
+    return true;
+  });
+}
+
+void ChunkManager::FillSphere(const glm::ivec3& center, int radius, BlockType block) {
+  ZoneScoped;
+  if (radius < 0) return;
+  int radius_sq = radius * radius;
+  FillRows(center - radius, center + radius, block,
+           [&center, radius_sq](int y, int z, int& x_begin, int& x_end) {
+             int dy = y - center.y;
+             int dz = z - center.z;
+             int rem = radius_sq - dy * dy - dz * dz;
+             if (rem < 0) return false;
+             int half_width = static_cast<int>(std::sqrt(static_cast<float>(rem)));
+             x_begin = center.x - half_width;
+             x_end = center.x + half_width;
+             return true;
+           });
+}
+
+void ChunkManager::FillRows(const glm::ivec3& min, const glm::ivec3& max, BlockType block,
+                            const RowSpanFunc& row_span) {
+  glm::ivec3 min_chunk = util::chunk::WorldToChunkPos(min);
+  glm::ivec3 max_chunk = util::chunk::WorldToChunkPos(max);
+  min_chunk.y = std::max(min_chunk.y, 0);
+  max_chunk.y = std::min(max_chunk.y, kNumVerticalChunks - 1);
+  glm::ivec3 chunk_pos;
+  for (chunk_pos.y = min_chunk.y; chunk_pos.y <= max_chunk.y; chunk_pos.y++) {
+    for (chunk_pos.z = min_chunk.z; chunk_pos.z <= max_chunk.z; chunk_pos.z++) {
+      for (chunk_pos.x = min_chunk.x; chunk_pos.x <= max_chunk.x; chunk_pos.x++) {
+        chunk_map_.find_fn(chunk_pos, [&, this](const std::shared_ptr<Chunk>& chunk) {
+          glm::ivec3 origin = chunk_pos * kChunkLength;
+          glm::ivec3 lo = glm::max(min, origin) - origin;
+          glm::ivec3 hi = glm::min(max, origin + kChunkLength - 1) - origin;
+          // bounds of what was actually written, for remeshing neighbors
+          glm::ivec3 written_min{kChunkLength};
+          glm::ivec3 written_max{-1};
+          int x_begin;
+          int x_end;
+          for (int y = lo.y; y <= hi.y; y++) {
+            for (int z = lo.z; z <= hi.z; z++) {
+              if (!row_span(origin.y + y, origin.z + z, x_begin, x_end)) continue;
+              x_begin = std::max(x_begin - origin.x, lo.x);
+              x_end = std::min(x_end - origin.x, hi.x);
+              if (x_begin > x_end) continue;
+              chunk->data.FillRow(y, z, x_begin, x_end + 1, block);
+              written_min = glm::min(written_min, glm::ivec3{x_begin, y, z});
+              written_max = glm::max(written_max, glm::ivec3{x_end, y, z});
+            }
+          }
+          if (written_max.x >= 0) {
+            AddRelatedChunks(written_min, written_max, chunk_pos, chunk_mesh_queue_immediate_);
+          }
+        });
+      }
+    }
+  }
+  UpdateHeights(min, max);
+  RelightEdit(min, max);
+}
+
+void ChunkManager::UpdateHeights(const glm::ivec3& min, const glm::ivec3& max) {
+  ZoneScoped;
+  BlockAccessor accessor = GetBlockAccessor();
+  glm::ivec2 min_column{min.x >> kChunkLengthShift, min.z >> kChunkLengthShift};
+  glm::ivec2 max_column{max.x >> kChunkLengthShift, max.z >> kChunkLengthShift};
+  int top = std::min(max.y, kMaxBlockHeight - 1);
+  glm::ivec2 column;
+  for (column.y = min_column.y; column.y <= max_column.y; column.y++) {
+    for (column.x = min_column.x; column.x <= max_column.x; column.x++) {
+      const ChunkColumn* chunk_column = chunk_map_.PeekColumn(column);
+      if (!chunk_column || !chunk_column->heights) continue;
+      ColumnHeightMap& heights = *chunk_column->heights;
+      glm::ivec2 origin = column * kChunkLength;
+      int x_begin = std::max(min.x, origin.x) - origin.x;
+      int x_end = std::min(max.x, origin.x + kChunkLengthM1) - origin.x;
+      int z_begin = std::max(min.z, origin.y) - origin.y;
+      int z_end = std::min(max.z, origin.y + kChunkLengthM1) - origin.y;
+      for (int z = z_begin; z <= z_end; z++) {
+        for (int x = x_begin; x <= x_end; x++) {
+          // an edit below the top block can't change the height
+          if (heights.Get(x, z) > max.y) continue;
+          int y = top;
+          while (y >= 0 && accessor.GetBlock({origin.x + x, y, origin.y + z}) == 0) y--;
+          heights.Set(x, z, y);
+        }
+      }
+    }
+  }
+}
+
+int ChunkManager::GetHeight(int x, int z) const {
+  const ChunkColumn* column =
+      chunk_map_.PeekColumn({x >> kChunkLengthShift, z >> kChunkLengthShift});
+  if (!column || !column->heights) return ColumnHeightMap::kEmpty;
+  return column->heights->Get(x & kChunkLengthM1, z & kChunkLengthM1);
+}
+
+int ChunkManager::GetMaxHeight(const glm::ivec2& min, const glm::ivec2& max) const {
+  int height = ColumnHeightMap::kEmpty;
+  glm::ivec2 column;
+  for (column.y = min.y >> kChunkLengthShift; column.y <= max.y >> kChunkLengthShift; column.y++) {
+    for (column.x = min.x >> kChunkLengthShift; column.x <= max.x >> kChunkLengthShift;
+         column.x++) {
+      const ChunkColumn* chunk_column = chunk_map_.PeekColumn(column);
+      if (chunk_column && chunk_column->heights) {
+        height = std::max(height, chunk_column->heights->GetMax());
+      }
+    }
+  }
+  return height;
+}
+
+std::shared_ptr<const ColumnHeightMap> ChunkManager::GetColumnHeightMap(
+    const glm::ivec2& column_pos) const {
+  const ChunkColumn* column = chunk_map_.PeekColumn(column_pos);
+  return column ? column->heights : nullptr;
+}
+
+void ChunkManager::RelightEdit(const glm::ivec3& min, const glm::ivec3& max) {
+  if (!lighting_enabled_ || !light_props_set_) return;
+  ZoneScoped;
+  Timer timer;
+  glm::ivec3 min_chunk = util::chunk::WorldToChunkPos(min - static_cast<int>(kMaxLightLevel));
+  glm::ivec3 max_chunk = util::chunk::WorldToChunkPos(max + static_cast<int>(kMaxLightLevel));
+  std::vector<ChunkColumn*> columns;
+  for (int z = min_chunk.z; z <= max_chunk.z; z++) {
+    for (int x = min_chunk.x; x <= max_chunk.x; x++) {
+      ChunkColumn* column = chunk_map_.PeekColumn({x, z});
+      if (!column) continue;
+      if (column->light_state == Chunk::State::kFinished) {
+        columns.emplace_back(column);
+      } else if (column->light_state == Chunk::State::kQueued) {
+        // its light job may have read the blocks from before the edit, light it again. Not meshed
+        // until it's lit, so nothing is meshed twice.
+        chunk_light_queue_.emplace_back(x, z);
+      }
+      // not lit yet, the light pipeline sees the edited blocks when it gets to it
+    }
+  }
+
+  struct Relight {
+    ColumnLightArrays light;
+    JobSystem::Handle job;
+  };
+  // sized once, the jobs write into it
+  std::vector<Relight> relights(columns.size());
+  for (size_t i = 0; i < columns.size(); i++) {
+    relights[i].job = job_system_.Submit(
+        JobSystem::Priority::kEdit, [this, pos = columns[i]->GetPos(), &light = relights[i].light] {
+          light_engine_.LightColumn(chunk_map_, pos, light);
+        });
+  }
+  for (size_t i = 0; i < columns.size(); i++) {
+    job_system_.Wait(relights[i].job);
+    for (int y = 0; y < kNumVerticalChunks; y++) {
+      Chunk& chunk = *columns[i]->chunks[y];
+      glm::ivec3 change_min;
+      glm::ivec3 change_max;
+      if (LightDiffBounds(chunk.data.GetLightArray().get(), relights[i].light[y].get(), change_min,
+                          change_max)) {
+        AddRelatedChunks(change_min, change_max, chunk.GetPos(), chunk_mesh_queue_immediate_);
+      }
+      chunk.data.SetLightArray(std::move(relights[i].light[y]));
+    }
+  }
+  last_light_update_ms_ = timer.ElapsedMS();
+}
+
+bool ChunkManager::NeighborColumnsReady(
+    const glm::ivec2& pos, const std::function<bool(const ChunkColumn&)>& ready_fn) const {
+  for (int z = pos.y - 1; z <= pos.y + 1; z++) {
+    for (int x = pos.x - 1; x <= pos.x + 1; x++) {
+      if (!ChunkPosWithinDistance(x, z, load_distance_)) continue;
+      const ChunkColumn* column = chunk_map_.PeekColumn({x, z});
+      // not queued yet, AddNewChunks will get to it
+      if (!column || !ready_fn(*column)) return false;
+    }
+  }
+  return true;
 }
 
 BlockType ChunkManager::GetBlock(const glm::ivec3& pos) const {
+  const Chunk* chunk = chunk_map_.Peek(util::chunk::WorldToChunkPos(pos));
   // debug only
-  EASSERT_MSG(chunk_map_.contains(util::chunk::WorldToChunkPos(pos)),
-              "Get block in non existent chunk");
-  BlockType block{0};
-  chunk_map_.find_fn(util::chunk::WorldToChunkPos(pos),
-                     [&block, &pos](const std::shared_ptr<Chunk>& chunk) {
-                       block = chunk->data.GetBlock(util::chunk::WorldToPosInChunk(pos));
-                     });
-  return block;
+  EASSERT_MSG(chunk, "Get block in non existent chunk");
+  if (!chunk) return 0;
+  return chunk->data.GetBlock(util::chunk::WorldToPosInChunk(pos));
+}
+
+void ChunkManager::GetBlocks(const glm::ivec3& min, const glm::ivec3& max,
+                             std::span<BlockType> out, BlockType unloaded_block) const {
+  GetBlockAccessor().GetBlocks(min, max, out, unloaded_block);
 }
 
 Chunk* ChunkManager::GetChunk(const glm::ivec3& pos) {
-  Chunk* ret = nullptr;
-  chunk_map_.find_fn(util::chunk::WorldToChunkPos(pos),
-                     [&ret](const std::shared_ptr<Chunk>& chunk) { ret = chunk.get(); });
-  return ret;
+  return chunk_map_.Peek(util::chunk::WorldToChunkPos(pos));
 }
 
-void ChunkManager::Update(double /*dt*/) {
+void ChunkManager::Update(double dt) {
   bool pos_changed = center_ != prev_center_;
   ZoneScoped;
+  frame_budget_.BeginFrame();
+  stream_predictor_.Update(center_world_pos_, dt);
+  static auto& update_us = MetricsRegistry::Get().GetHistogram("chunk_manager.update_us");
+  ScopedMetricTimer update_timer{update_us};
   // TODO: implement better tick system
   static uint32_t tick_count = 0;
   tick_count = (tick_count + 1) % UINT32_MAX;
 
   {
     ZoneScopedN("Process chunk terrain");
-    while (!chunk_terrain_queue_.empty()) {
+    frame_budget_.BeginPhase(FrameBudget::Phase::kTerrain);
+    while (!chunk_terrain_queue_.empty() && frame_budget_.HasTime()) {
       auto pos = chunk_terrain_queue_.front();
       chunk_terrain_queue_.pop();
-      // Chunk already exists at this point so no check
-      std::array<std::shared_ptr<Chunk>, kNumVerticalChunks> data;
-      glm::ivec3 p;
-      p.x = pos.x;
-      p.z = pos.y;
-      bool valid = true;
-      for (p.y = 0; p.y < kNumVerticalChunks; p.y++) {
-        if (!chunk_map_.find_fn(
-                p, [&p, &data](const std::shared_ptr<Chunk>& chunk) { data[p.y] = chunk; })) {
-          spdlog::error("uh oh no chunk, {} {} {}", pos.x, p.y, pos.y);
-          valid = false;
-          break;
-        }
-      }
-      if (!valid) continue;
-      thread_pool_.detach_task([this, data, pos] {
+      std::shared_ptr<ChunkColumn> column = chunk_map_.FindColumn(pos);
+      // unloaded while queued
+      if (!column) continue;
+      uint32_t generation = chunk_map_.ColumnGeneration(pos);
+      // unloaded recently, decode it instead of generating it again
+      std::shared_ptr<EvictedColumnCache::Entry> cached = evicted_columns_.Take(pos);
+      auto terrain_job = [this, column = std::move(column), cached, pos, generation] {
         ZoneScopedN("chunk terrain task");
-        if (!ChunkPosWithinDistance(pos.x, pos.y, load_distance_)) return;
-
-        TerrainGenerator gen{data, pos * kChunkLength, seed_, terrain_};
-        // gen.GenerateYLayer(0, 3);
-        // gen.GenerateSolid(3);
-        gen.GenerateBiome();
-        for (int i = 0; i < kNumVerticalChunks; i++) {
-          data[i]->data.DownSample();
-          // TODO: see if race condition somewhere?
-          data[i]->terrain_state = Chunk::State::kFinished;
+        if (!ChunkPosWithinDistance(pos.x, pos.y, load_distance_)) {
+          if (cached) evicted_columns_.Insert(pos, cached);
+          return;
         }
+        static auto& terrain_us = MetricsRegistry::Get().GetHistogram("chunk.terrain_us");
+        ScopedMetricTimer timer{terrain_us};
+
+        ChunkTerrainTask task;
+        task.pos = pos;
+        task.generation = generation;
+        if (cached) {
+          task.heights = EvictedColumnCache::Decode(*cached, *column);
+        }
+        if (!task.heights) {
+          task.heights = std::make_unique<ColumnHeightMap>();
+          TerrainGenerator gen{column->chunks, pos * kChunkLength, seed_, terrain_};
+          // gen.GenerateYLayer(0, 3);
+          // gen.GenerateSolid(3);
+          gen.GenerateBiome(*task.heights);
+        }
+        for (const auto& chunk : column->chunks) chunk->data.DownSample();
         {
           std::lock_guard<std::mutex> lock(chunk_terrain_finish_mtx_);
           // for (int i = 0; i < NumVerticalChunks; i++) {
           // }
           // state_stats_.loaded_chunks += NumVerticalChunks;
           // chunk_mesh_queue_.emplace(pos);
-          finished_chunk_terrain_queue_.emplace_back(pos);
+          finished_chunk_terrain_queue_.emplace(std::move(task));
         }
-      });
+      };
+      terrain_jobs_[pos] = job_system_.Submit(JobSystem::Priority::kBackground,
+                                              std::move(terrain_job));
     }
   }
 
   {
     ZoneScopedN("Process finished chunk terrain tasks");
-    while (!finished_chunk_terrain_queue_.empty()) {
-      auto pos = finished_chunk_terrain_queue_.front();
-      glm::ivec3 p;
-      p.x = pos.x;
-      p.z = pos.y;
-      for (p.y = 0; p.y < kNumVerticalChunks; p.y++) {
-        chunk_map_.find_fn(p, [this](const std::shared_ptr<Chunk>& chunk) {
-          chunk->terrain_state = Chunk::State::kFinished;
-          state_stats_.loaded_chunks++;
-        });
+    frame_budget_.BeginPhase(FrameBudget::Phase::kTerrainFinished);
+    ChunkTerrainTask task;
+    while (frame_budget_.HasTime() &&
+           PopFinished(chunk_terrain_finish_mtx_, finished_chunk_terrain_queue_, task)) {
+      glm::ivec2 pos = task.pos;
+      ChunkColumn* column = chunk_map_.PeekColumn(pos);
+      // the column was unloaded since, and maybe loaded again with its own task
+      if (!column || chunk_map_.ColumnGeneration(pos) != task.generation) continue;
+      terrain_jobs_.erase(pos);
+      column->terrain_state = Chunk::State::kFinished;
+      column->heights = std::move(task.heights);
+      state_stats_.loaded_chunks += kNumVerticalChunks;
+      if (lighting_enabled_) {
+        chunk_light_queue_.emplace_back(pos);
+        // neighbors lit while this column was past the load distance read it as unloaded blocks
+        for (int z = pos.y - 1; z <= pos.y + 1; z++) {
+          for (int x = pos.x - 1; x <= pos.x + 1; x++) {
+            const ChunkColumn* neighbor = chunk_map_.PeekColumn({x, z});
+            if (neighbor && neighbor->lit_at_load_edge &&
+                neighbor->light_state != Chunk::State::kNotFinished) {
+              chunk_light_queue_.emplace_back(x, z);
+            }
+          }
+        }
+      } else {
+        chunk_mesh_queue_.emplace(pos);
+      }
+    }
+  }
+
+  {
+    ZoneScopedN("Process chunk light");
+    frame_budget_.BeginPhase(FrameBudget::Phase::kLight);
+    // which blocks pass light comes from the mesh data, columns wait here until it's loaded
+    bool can_light = block_db_.MeshDataInitialized();
+    if (can_light && !light_props_set_) {
+      light_engine_.SetBlockProps(LightEngine::PropsFromBlockDB(block_db_));
+      light_props_set_ = true;
+    }
+    // columns not ready yet go to the back and are checked again next frame
+    for (size_t i = 0, size = can_light ? chunk_light_queue_.size() : 0;
+         i < size && frame_budget_.HasTime(); i++) {
+      glm::ivec2 pos = chunk_light_queue_.front();
+      chunk_light_queue_.pop_front();
+      ChunkColumn* column = chunk_map_.PeekColumn(pos);
+      if (!column) continue;
+      if (!NeighborColumnsReady(pos, [this](const ChunkColumn& c) {
+            return c.terrain_state == Chunk::State::kFinished || terrain_jobs_.contains(c.GetPos());
+          })) {
+        chunk_light_queue_.emplace_back(pos);
+        continue;
+      }
+      // the light job runs once the neighbor terrain jobs still running finish
+      std::array<JobSystem::Handle, 9> neighbor_terrain;
+      size_t num_neighbor_terrain = 0;
+      column->lit_at_load_edge = false;
+      for (int z = pos.y - 1; z <= pos.y + 1; z++) {
+        for (int x = pos.x - 1; x <= pos.x + 1; x++) {
+          if (auto it = terrain_jobs_.find({x, z}); it != terrain_jobs_.end()) {
+            neighbor_terrain[num_neighbor_terrain++] = it->second;
+          } else if (!chunk_map_.PeekColumn({x, z})) {
+            column->lit_at_load_edge = true;
+          }
+        }
+      }
+      column->light_state = Chunk::State::kQueued;
+      uint32_t generation = chunk_map_.ColumnGeneration(pos);
+      uint32_t light_version = ++column->light_version;
+      auto light_job = [this, pos, generation, light_version] {
+        ZoneScopedN("chunk light task");
+        ChunkLightTask task;
+        task.pos = pos;
+        task.generation = generation;
+        task.light_version = light_version;
+        {
+          static auto& light_us = MetricsRegistry::Get().GetHistogram("chunk.light_us");
+          ScopedMetricTimer timer{light_us};
+          light_engine_.LightColumn(chunk_map_, pos, task.light);
+        }
+        std::lock_guard<std::mutex> lock(chunk_light_finish_mtx_);
+        chunk_light_finished_queue_.emplace(std::move(task));
+      };
+      job_system_.Submit(JobSystem::Priority::kBackground, std::move(light_job),
+                         std::span(neighbor_terrain.data(), num_neighbor_terrain));
+    }
+  }
+
+  {
+    ZoneScopedN("Process finished chunk light tasks");
+    frame_budget_.BeginPhase(FrameBudget::Phase::kLightFinished);
+    std::lock_guard<std::mutex> lock(chunk_light_finish_mtx_);
+    while (!chunk_light_finished_queue_.empty() && frame_budget_.HasTime()) {
+      auto& task = chunk_light_finished_queue_.front();
+      ChunkColumn* column = chunk_map_.PeekColumn(task.pos);
+      // a relight was submitted after this task, its result is newer even if it finishes first
+      if (column && chunk_map_.ColumnGeneration(task.pos) == task.generation &&
+          column->light_version == task.light_version) {
+        for (int y = 0; y < kNumVerticalChunks; y++) {
+          column->chunks[y]->data.SetLightArray(std::move(task.light[y]));
+        }
+        column->light_state = Chunk::State::kFinished;
+        chunk_lit_queue_.emplace_back(task.pos);
+      }
+      chunk_light_finished_queue_.pop();
+    }
+  }
+
+  {
+    ZoneScopedN("Process lit chunks");
+    frame_budget_.BeginPhase(FrameBudget::Phase::kLit);
+    // border faces take light from neighbor columns, so wait for those to be lit before meshing
+    for (size_t i = 0, size = chunk_lit_queue_.size(); i < size && frame_budget_.HasTime(); i++) {
+      glm::ivec2 pos = chunk_lit_queue_.front();
+      chunk_lit_queue_.pop_front();
+      if (!chunk_map_.PeekColumn(pos)) continue;
+      if (NeighborColumnsReady(pos, [](const ChunkColumn& c) {
+            return c.light_state == Chunk::State::kFinished;
+          })) {
+        chunk_mesh_queue_.emplace(pos);
+      } else {
+        chunk_lit_queue_.emplace_back(pos);
       }
-      finished_chunk_terrain_queue_.pop_front();
-      chunk_mesh_queue_.emplace(pos);
     }
   }
 
@@ -145,26 +563,23 @@ void ChunkManager::Update(double /*dt*/) {
       (load_distance_ * 2 + 1) * (load_distance_ * 2 + 1) * kNumVerticalChunks;
   if (state_stats_.loaded_chunks >= state_stats_.max_chunks) first_load_completed_ = true;
 
+  // terrain runs while the world is still loading, columns wait in the light and mesh queues until
+  // the block data the light and meshes need is loaded
+  bool can_mesh = block_db_.MeshDataInitialized();
   {
     ZoneScopedN("Process mesh chunks");
+    frame_budget_.BeginPhase(FrameBudget::Phase::kMesh);
     // process remesh chunks
-    while (!chunk_mesh_queue_.empty()) {
+    while (can_mesh && !chunk_mesh_queue_.empty() && frame_budget_.HasTime()) {
       glm::ivec2 pos = chunk_mesh_queue_.front();
       glm::ivec3 p;
       p.x = pos.x;
       p.z = pos.y;
       chunk_mesh_queue_.pop();
+      ChunkColumn* column = chunk_map_.PeekColumn(pos);
+      if (!column) continue;
       // TODO: make queued state before the queue itself
-      bool valid = true;
-      for (p.y = 0; p.y < kNumVerticalChunks; p.y++) {
-        if (!chunk_map_.find_fn(p, [](const std::shared_ptr<Chunk>& chunk) {
-              chunk->mesh_state = Chunk::State::kQueued;
-            })) {
-          valid = false;
-          break;
-        }
-      }
-      if (!valid) continue;
+      for (const auto& chunk : column->chunks) chunk->mesh_state = Chunk::State::kQueued;
 
       if (p.x < center_.x - lod_1_load_distance_ || p.x > center_.x + lod_1_load_distance_ ||
           p.z < center_.z - lod_1_load_distance_ || p.z > center_.z + lod_1_load_distance_) {
@@ -177,7 +592,7 @@ void ChunkManager::Update(double /*dt*/) {
     }
   }
 
-  if (pos_changed && first_load_completed_ && update_chunks_on_move_) {
+  if (can_mesh && pos_changed && first_load_completed_ && update_chunks_on_move_) {
     ZoneScopedN("Pos Changed");
     glm::ivec3 diff = center_ - prev_center_;
     if (diff.z != 0) {
@@ -207,87 +622,142 @@ void ChunkManager::Update(double /*dt*/) {
 
   {
     ZoneScopedN("Process finished mesh chunks");
-    static Timer timer;
-    timer.Reset();
-    while (!chunk_mesh_finished_queue_.empty()) {
-      if (timer.ElapsedMS() > 5) break;
-      auto& task = chunk_mesh_finished_queue_.front();
-      chunk_map_.find_fn(task.pos, [this, &task](const std::shared_ptr<Chunk>& chunk) {
-        FreeChunkMesh(chunk->mesh);
-        lod_chunk_handle_map_.find_fn(glm::ivec2{task.pos.x, task.pos.z},
-                                      [this](uint32_t& handle) { FreeOpaqueChunkMesh(handle); });
-
-        if (!task.verts_indices.opaque_indices.empty()) {
-          chunk->mesh.opaque_mesh_handle = Renderer::Get().AllocateStaticChunk(
-              task.verts_indices.opaque_vertices, task.verts_indices.opaque_indices,
-              task.pos * kChunkLength, LODLevel::kRegular);
-        }
-        if (!task.verts_indices.transparent_indices.empty()) {
-          chunk->mesh.transparent_mesh_handle = Renderer::Get().AllocateStaticChunkTransparent(
-              task.verts_indices.transparent_vertices, task.verts_indices.transparent_indices,
-              task.pos);
-        }
-        // TODO: get rid of lod level here since it's in a diff queue now
-        chunk->lod_level = LODLevel::kRegular;
+    static auto& mesh_latency_us = MetricsRegistry::Get().GetHistogram("chunk.mesh_latency_us");
+    static auto& meshes_uploaded = MetricsRegistry::Get().GetCounter("chunk.meshes_uploaded");
+    static auto& stale_meshes = MetricsRegistry::Get().GetCounter("chunk.stale_mesh_results");
+    frame_budget_.BeginPhase(FrameBudget::Phase::kMeshFinished);
+    auto now = std::chrono::steady_clock::now();
+    ChunkMeshTask task;
+    while (frame_budget_.HasTime() &&
+           PopFinished(chunk_mesh_finish_mtx_, chunk_mesh_finished_queue_, task)) {
+      mesh_latency_us.Record(
+          std::chrono::duration_cast<std::chrono::microseconds>(now - task.queued_time).count());
+      mesh_bytes_in_flight_ -= MeshBytes(task.verts_indices);
+      // the LOD 1 ring moved past the chunk since the task was sent, its LOD mesh is on the way
+      if (!ChunkPosWithinDistance(task.pos.x, task.pos.z, lod_1_load_distance_)) continue;
+      ChunkColumn* column = chunk_map_.PeekColumn({task.pos.x, task.pos.z});
+      if (!column) continue;
+      Chunk* chunk = column->chunks[task.pos.y].get();
+      // remeshed after an edit or loaded again since the task was sent, the mesh is out of date
+      if (chunk->GetGeneration() != task.generation) {
+        stale_meshes.Add();
+        state_stats_.stale_mesh_results++;
+        continue;
+      }
+      meshes_uploaded.Add();
+      FreeChunkMesh(chunk->mesh);
+      FreeOpaqueChunkMesh(column->lod_mesh_handle);
+
+      bool failed = false;
+      if (!task.verts_indices.opaque_indices.empty()) {
+        chunk->mesh.opaque_mesh_handle = mesh_sink_.AllocateStaticChunk(
+            task.verts_indices.opaque_vertices, task.verts_indices.opaque_indices,
+            task.pos * kChunkLength, LODLevel::kRegular);
+        failed = chunk->mesh.opaque_mesh_handle == 0;
+      }
+      if (!task.verts_indices.transparent_indices.empty()) {
+        chunk->mesh.transparent_mesh_handle = mesh_sink_.AllocateStaticChunkTransparent(
+            task.verts_indices.transparent_vertices, task.verts_indices.transparent_indices,
+            task.pos);
+        failed = failed || chunk->mesh.transparent_mesh_handle == 0;
+      }
+      // TODO: get rid of lod level here since it's in a diff queue now
+      chunk->lod_level = LODLevel::kRegular;
+      if (failed) {
+        chunk->mesh_state = Chunk::State::kNotFinished;
+        OnMeshAllocFailed(task.pos);
+      } else {
         chunk->mesh_state = Chunk::State::kFinished;
         state_stats_.meshed_chunks++;
-      });
-      chunk_mesh_finished_queue_.pop();
+      }
     }
 
-    while (!lod_chunk_mesh_finished_queue_.empty()) {
-      auto& task = lod_chunk_mesh_finished_queue_.front();
-      if (!lod_chunk_handle_map_.find_fn(task.pos, [this, &task](uint32_t& handle) {
-            FreeOpaqueChunkMesh(handle);
-            handle = Renderer::Get().AllocateStaticChunk(
-                task.vertices, task.indices,
-                glm::ivec3{task.pos.x * kChunkLength, 0, task.pos.y * kChunkLength},
-                task.lod_level);
-          })) {
-        lod_chunk_handle_map_.insert(
-            task.pos, Renderer::Get().AllocateStaticChunk(
-                          task.vertices, task.indices,
-                          glm::ivec3{task.pos.x * kChunkLength, 0, task.pos.y * kChunkLength},
-                          task.lod_level));
+    LODChunkMeshTask lod_task;
+    while (frame_budget_.HasTime() &&
+           PopFinished(lod_chunk_mesh_finish_mtx_, lod_chunk_mesh_finished_queue_, lod_task)) {
+      mesh_bytes_in_flight_ -= MeshBytes(lod_task.vertices, lod_task.indices);
+      // the LOD 1 ring grew past the column since the task was sent, its regular meshes are on the
+      // way
+      if (ChunkPosWithinDistance(lod_task.pos.x, lod_task.pos.y, lod_1_load_distance_)) continue;
+      ChunkColumn* column = chunk_map_.PeekColumn(lod_task.pos);
+      if (!column || chunk_map_.ColumnGeneration(lod_task.pos) != lod_task.generation) {
+        // unloaded, and maybe loaded again with its own task
+        if (column) {
+          stale_meshes.Add();
+          state_stats_.stale_mesh_results++;
+        }
+        continue;
       }
-      glm::ivec3 p{task.pos.x, 0, task.pos.y};
-      for (p.y = 0; p.y < kNumVerticalChunks; p.y++) {
-        chunk_map_.find_fn(p, [this](const std::shared_ptr<Chunk>& chunk) {
+      meshes_uploaded.Add();
+      FreeOpaqueChunkMesh(column->lod_mesh_handle);
+      column->lod_mesh_handle = mesh_sink_.AllocateStaticChunk(
+          lod_task.vertices, lod_task.indices,
+          glm::ivec3{lod_task.pos.x * kChunkLength, 0, lod_task.pos.y * kChunkLength},
+          lod_task.lod_level);
+      if (column->lod_mesh_handle == 0 && !lod_task.indices.empty()) {
+        // keep the regular meshes the column still has until the retry
+        OnLODMeshAllocFailed(lod_task.pos);
+      } else {
+        for (const auto& chunk : column->chunks) {
           FreeChunkMesh(chunk->mesh);
           chunk->mesh_state = Chunk::State::kFinished;
           chunk->lod_level = LODLevel::kOne;
-        });
+        }
       }
-      lod_chunk_mesh_finished_queue_.pop();
     }
   }
 
-  {
+  if (can_mesh) {
     ZoneScopedN("Immediate chunk remesh");
+    // not cut short, the chunks of one edit show up in the same frame. Other phases yield for it.
+    frame_budget_.BeginPhase(FrameBudget::Phase::kImmediateRemesh);
+    immediate_remeshes_.clear();
     for (const auto& pos : chunk_mesh_queue_immediate_) {
-      if (!chunk_map_.contains(pos)) continue;
-      auto chunk = chunk_map_.find(pos);
+      Chunk* chunk = chunk_map_.Peek(pos);
+      if (!chunk) continue;
+      // meshes of the chunk still on a worker were made before the edit
+      chunk->BumpGeneration();
       if (chunk->data.GetBlockCount() == 0) continue;
-
-      ChunkNeighborArray a;
-      PopulateChunkNeighbors(a, pos);
-      ChunkMesher mesher{block_db_.GetBlockData(), block_db_.GetMeshData()};
-      MeshVerticesIndices verts_indices;
-      mesher.GenerateGreedy(a, verts_indices);
+      immediate_remeshes_.push_back({pos, chunk, {}, {}});
+    }
+    // ahead of all streaming work, the main thread meshes too while it waits. Nothing is unloaded
+    // until they're done, so the chunks and their neighbors stay put.
+    for (ImmediateRemesh& remesh : immediate_remeshes_) {
+      remesh.job = job_system_.Submit(JobSystem::Priority::kEdit, [this, &remesh] {
+        ChunkNeighborArray a;
+        PopulateChunkNeighbors(a, remesh.pos);
+        ChunkMesher mesher{block_db_.GetBlockData(), block_db_.GetMeshData()};
+        mesher.GenerateGreedy(a, remesh.verts_indices);
+      });
+    }
+    for (ImmediateRemesh& remesh : immediate_remeshes_) {
+      job_system_.Wait(remesh.job);
+      const glm::ivec3& pos = remesh.pos;
+      Chunk* chunk = remesh.chunk;
+      MeshVerticesIndices& verts_indices = remesh.verts_indices;
 
       FreeChunkMesh(chunk->mesh);
+      bool failed = false;
       if (!verts_indices.opaque_vertices.empty()) {
-        chunk->mesh.opaque_mesh_handle = Renderer::Get().AllocateStaticChunk(
+        chunk->mesh.opaque_mesh_handle = mesh_sink_.AllocateStaticChunk(
             verts_indices.opaque_vertices, verts_indices.opaque_indices, pos * kChunkLength,
             LODLevel::kRegular);
+        failed = chunk->mesh.opaque_mesh_handle == 0;
       }
       if (!verts_indices.transparent_indices.empty()) {
-        chunk->mesh.transparent_mesh_handle = Renderer::Get().AllocateStaticChunkTransparent(
+        chunk->mesh.transparent_mesh_handle = mesh_sink_.AllocateStaticChunkTransparent(
             verts_indices.transparent_vertices, verts_indices.transparent_indices,
             pos * kChunkLength);
+        failed = failed || chunk->mesh.transparent_mesh_handle == 0;
+      }
+      if (failed) {
+        chunk->mesh_state = Chunk::State::kNotFinished;
+        OnMeshAllocFailed(pos);
+      } else {
+        chunk->mesh_state = Chunk::State::kFinished;
       }
-      chunk->mesh_state = Chunk::State::kFinished;
     }
+    immediate_remeshes_.clear();
     chunk_mesh_queue_immediate_.clear();
   }
 
@@ -296,59 +766,163 @@ void ChunkManager::Update(double /*dt*/) {
   }
   if (pos_changed && update_chunks_on_move_) {
     UnloadChunksOutOfRange(center_ - prev_center_);
-    AddNewChunks(true);
+    // unloaded unfinished columns that came back into range are queued again here
+    AddFrontierChunks();
   }
+  memory_budget_.Update(*this, mesh_sink_);
+  ReleaseRetiredColumns();
+  UpdateQueueDepthGauges();
+  frame_budget_.EndFrame();
 }
 
-void ChunkManager::UnloadChunksOutOfRange(int old_load_distance) {
+void ChunkManager::SetLoadDistance(int load_distance) {
   ZoneScoped;
-  IterateChunks(old_load_distance, [this](const glm::ivec2& pos) {
-    if (abs(pos.x - center_.x) > load_distance_ || abs(pos.y - center_.z) > load_distance_) {
-      glm::ivec3 p;
-      p.x = pos.x;
-      p.z = pos.y;
-      for (p.y = 0; p.y < kNumVerticalChunks; p.y++) {
-        if (chunk_map_.find_fn(
-                p, [this](const std::shared_ptr<Chunk>& c) { FreeChunkMesh(c->mesh); })) {
-          chunk_map_.erase(p);
-        }
+  load_distance = std::clamp(load_distance, 1, kMaxLoadDistance);
+  if (load_distance == load_distance_) return;
+  int old_load_distance = load_distance_;
+  load_distance_ = load_distance;
+  lod_1_load_distance_ = std::min(lod_1_load_distance_, load_distance_);
+  if (load_distance_ < old_load_distance) {
+    UnloadChunksOutOfRange(old_load_distance);
+  } else {
+    AddNewChunks(false);
+  }
+}
+
+void ChunkManager::SetLOD1LoadDistance(int lod_1_load_distance) {
+  ZoneScoped;
+  lod_1_load_distance = std::clamp(lod_1_load_distance, 0, load_distance_);
+  if (lod_1_load_distance == lod_1_load_distance_) return;
+  int old_lod_1_load_distance = lod_1_load_distance_;
+  lod_1_load_distance_ = lod_1_load_distance;
+  if (old_lod_1_load_distance < lod_1_load_distance_) {
+    // LOD columns now inside the ring get regular meshes
+    IterateChunksVertical(lod_1_load_distance_, [this](const glm::ivec3& pos) {
+      bool is_lod = false;
+      chunk_map_.find_fn(pos, [&is_lod](const std::shared_ptr<Chunk>& chunk) {
+        is_lod = chunk->lod_level == LODLevel::kOne;
+      });
+      if (is_lod) SendChunkMeshTaskNoLOD(pos);
+    });
+  } else {
+    IterateChunks(lod_1_load_distance_, old_lod_1_load_distance,
+                  [this](const glm::ivec2& pos) { SendChunkMeshTaskLOD1(pos); });
+  }
+}
+
+void ChunkManager::OnMeshAllocFailed(const glm::ivec3& pos) {
+  static auto& failures = MetricsRegistry::Get().GetCounter("mesh.alloc_failures");
+  failures.Add();
+  failed_mesh_allocs_.emplace_back(pos);
+}
+
+void ChunkManager::OnLODMeshAllocFailed(const glm::ivec2& pos) {
+  static auto& failures = MetricsRegistry::Get().GetCounter("mesh.alloc_failures");
+  failures.Add();
+  failed_lod_mesh_allocs_.emplace_back(pos);
+  // the LOD task skips columns already at LOD 1, which this one no longer has a mesh for
+  ChunkColumn* column = chunk_map_.PeekColumn(pos);
+  if (!column) return;
+  for (const auto& chunk : column->chunks) {
+    if (chunk->lod_level == LODLevel::kOne) chunk->lod_level = LODLevel::kNoMesh;
+  }
+}
+
+void ChunkManager::RetryFailedMeshAllocs() {
+  ZoneScoped;
+  if (!failed_mesh_allocs_.empty() || !failed_lod_mesh_allocs_.empty()) {
+    spdlog::info("retrying {} chunk and {} LOD mesh uploads", failed_mesh_allocs_.size(),
+                 failed_lod_mesh_allocs_.size());
+  }
+  for (const auto& pos : failed_mesh_allocs_) {
+    if (ChunkPosWithinDistance(pos.x, pos.z, lod_1_load_distance_)) SendChunkMeshTaskNoLOD(pos);
+  }
+  failed_mesh_allocs_.clear();
+  for (const auto& pos : failed_lod_mesh_allocs_) {
+    if (ChunkPosWithinDistance(pos.x, pos.y, load_distance_) &&
+        !ChunkPosWithinDistance(pos.x, pos.y, lod_1_load_distance_)) {
+      SendChunkMeshTaskLOD1(pos);
+    }
+  }
+  failed_lod_mesh_allocs_.clear();
+}
+
+void ChunkManager::UnloadColumn(const glm::ivec2& pos) {
+  ChunkColumn* column = chunk_map_.PeekColumn(pos);
+  if (!column) return;
+  terrain_jobs_.erase(pos);
+  FreeOpaqueChunkMesh(column->lod_mesh_handle);
+  for (const auto& chunk : column->chunks) FreeChunkMesh(chunk->mesh);
+  uint64_t eviction_sequence = 0;
+  if (column->terrain_state == Chunk::State::kFinished && evicted_columns_.Enabled()) {
+    eviction_sequence = ++eviction_sequence_;
+  }
+  retired_columns_.push_back({chunk_map_.EraseColumn(pos), eviction_sequence});
+}
+
+void ChunkManager::ReleaseRetiredColumns() {
+  if (retired_columns_.empty()) return;
+  static auto& released = MetricsRegistry::Get().GetCounter("chunk.columns_released");
+  released.Add(retired_columns_.size());
+  // shared so the job stays copyable for std::function
+  auto retired = std::make_shared<std::vector<RetiredColumn>>(std::move(retired_columns_));
+  retired_columns_.clear();
+  job_system_.Submit(JobSystem::Priority::kBackground, [this, retired] {
+    ZoneScopedN("release retired columns");
+    for (RetiredColumn& r : *retired) {
+      if (r.eviction_sequence != 0) {
+        evicted_columns_.Insert(r.column->GetPos(),
+                                EvictedColumnCache::Encode(*r.column, r.eviction_sequence));
       }
+      // tasks still running on the column keep it alive, the last one frees it
+      r.column.reset();
     }
   });
 }
 
+bool ChunkManager::ColumnComplete(const ChunkColumn& column) {
+  if (column.terrain_state != Chunk::State::kFinished) return false;
+  return std::ranges::all_of(column.chunks, [](const std::shared_ptr<Chunk>& chunk) {
+    return chunk->mesh_state == Chunk::State::kFinished;
+  });
+}
+
+int ChunkManager::GetUnloadDistance() const {
+  return load_distance_ + std::clamp(unload_band_, 0, kMaxLoadDistance - load_distance_);
+}
+
+void ChunkManager::UnloadChunksOutOfRange(int old_load_distance) {
+  ZoneScoped;
+  int unload_distance = GetUnloadDistance();
+  // only the rings past the new load distance
+  IterateChunks(load_distance_, std::min(old_load_distance + unload_band_, kMaxLoadDistance),
+                [this, unload_distance](const glm::ivec2& pos) {
+                  ChunkColumn* column = chunk_map_.PeekColumn(pos);
+                  if (!column) return;
+                  if (!ChunkPosWithinDistance(pos.x, pos.y, unload_distance) ||
+                      !ColumnComplete(*column)) {
+                    UnloadColumn(pos);
+                  }
+                });
+}
+
 void ChunkManager::UnloadChunksOutOfRange(const glm::ivec3& diff) {
   ZoneScoped;
-  auto erase_fn = [this](const glm::ivec2& pos) {
-    if (lod_chunk_handle_map_.find_fn(pos,
-                                      [this](uint32_t& handle) { FreeOpaqueChunkMesh(handle); })) {
-      lod_chunk_handle_map_.erase(pos);
-    }
-    glm::ivec3 p{pos.x, 0, pos.y};
-    for (p.y = 0; p.y < kNumVerticalChunks; p.y++) {
-      if (chunk_map_.find_fn(p,
-                             [this](const std::shared_ptr<Chunk>& c) { FreeChunkMesh(c->mesh); })) {
-        chunk_map_.erase(p);
-      }
-    }
+  if (diff.x == 0 && diff.z == 0) return;
+  static auto& unload_us = MetricsRegistry::Get().GetHistogram("chunk_manager.unload_us");
+  ScopedMetricTimer timer{unload_us};
+  glm::ivec2 center{center_.x, center_.z};
+  glm::ivec2 prev_center{prev_center_.x, prev_center_.z};
+  util::spiral::ForEachFrontier(prev_center, center, GetUnloadDistance(),
+                                [this](const glm::ivec2& pos) { UnloadColumn(pos); });
+  // unfinished columns don't stay in the band, their queued work would skip them anyway
+  auto unload_unfinished = [this](const glm::ivec2& pos) {
+    ChunkColumn* column = chunk_map_.PeekColumn(pos);
+    if (column && !ColumnComplete(*column)) UnloadColumn(pos);
   };
-
-  if (diff.z != 0) {
-    glm::ivec3 pos;
-    pos.z = prev_center_.z - load_distance_ * diff.z;
-    for (pos.x = prev_center_.x - load_distance_; pos.x <= prev_center_.x + load_distance_;
-         pos.x++) {
-      erase_fn(glm::ivec2{pos.x, pos.z});
-    }
-  }
-  if (diff.x != 0) {
-    glm::ivec3 pos;
-    pos.x = prev_center_.x - load_distance_ * diff.x;
-    for (pos.z = prev_center_.z - load_distance_; pos.z <= prev_center_.z + load_distance_;
-         pos.z++) {
-      erase_fn(glm::ivec2{pos.x, pos.z});
-    }
-  }
+  util::spiral::ForEachFrontier(prev_center, center, load_distance_, unload_unfinished);
+  // and ones that became unfinished while in the band are loaded again from scratch
+  util::spiral::ForEachFrontier(center, prev_center, load_distance_, unload_unfinished);
 }
 
 void ChunkManager::PopulateChunkStatePixels(std::vector<uint8_t>& pixels, glm::ivec2& out_dims,
@@ -377,27 +951,26 @@ void ChunkManager::PopulateChunkStatePixels(std::vector<uint8_t>& pixels, glm::i
         if (iter.x == center_.x && iter.z == center_.z) {
           add_color(color::kWhite);
         } else {
-          if (!chunk_map_.find_fn(iter, [this, &add_color](const std::shared_ptr<Chunk>& chunk) {
-                bool has_mesh_handle =
-                    chunk->mesh.opaque_mesh_handle != 0 || chunk->mesh.transparent_mesh_handle != 0;
-                if (chunk->lod_level > LODLevel::kRegular) {
-                  lod_chunk_handle_map_.find_fn(glm::ivec2{chunk->GetPos().x, chunk->GetPos().z},
-                                                [&has_mesh_handle](const uint32_t handle) {
-                                                  has_mesh_handle = has_mesh_handle || handle != 0;
-                                                });
-                }
-                if (has_mesh_handle) {
-                  EASSERT(chunk->mesh_state == Chunk::State::kFinished);
-                  add_color(color::kBlue);
-                } else if (chunk->mesh_state == Chunk::State::kFinished) {
-                  add_color(color::kGreen);
-                } else if (chunk->terrain_state == Chunk::State::kFinished) {
-                  add_color(color::kRed);
-                } else {
-                  add_color(color::kCyan);
-                }
-              })) {
+          const Chunk* chunk = chunk_map_.Peek(iter);
+          const ChunkColumn* column = chunk_map_.PeekColumn({iter.x, iter.z});
+          if (!chunk) {
             add_color(color::kBlack);
+          } else {
+            bool has_mesh_handle =
+                chunk->mesh.opaque_mesh_handle != 0 || chunk->mesh.transparent_mesh_handle != 0;
+            if (chunk->lod_level > LODLevel::kRegular) {
+              has_mesh_handle = has_mesh_handle || column->lod_mesh_handle != 0;
+            }
+            if (has_mesh_handle) {
+              EASSERT(chunk->mesh_state == Chunk::State::kFinished);
+              add_color(color::kBlue);
+            } else if (chunk->mesh_state == Chunk::State::kFinished) {
+              add_color(color::kGreen);
+            } else if (column->terrain_state == Chunk::State::kFinished) {
+              add_color(color::kRed);
+            } else {
+              add_color(color::kCyan);
+            }
           }
         }
       }
@@ -427,141 +1000,100 @@ void ChunkManager::PopulateChunkStatePixels(std::vector<uint8_t>& pixels, glm::i
   }
 }
 
-void ChunkManager::IterateChunks(int start_distance, int load_distance,
-                                 const PositionIteratorFunc& func) const {
-  int start_idx = (start_distance * 2 + 1) * (start_distance * 2 + 1);
-  IterateChunks(load_distance, [&func, start_idx](const glm::ivec2& pos, int i) {
-    if (i >= start_idx) {
-      func(pos);
-    }
-  });
-}
-
-void ChunkManager::IterateChunks(int load_distance, const PositionIteratorFuncIdx& func) const {
-  // Clockwise Spiral iterator starting from center
-  constexpr static int kDx[] = {1, 0, -1, 0};
-  constexpr static int kDy[] = {0, 1, 0, -1};
-  int direction = 0;
-  int step_radius = 1;
-  int direction_steps_counter = 0;
-  int turn_counter = 0;
-  int load_len = (load_distance) * 2 + 1;
-  int num_chunk_positions = load_len * load_len;
-  glm::ivec2 pos{center_.x, center_.z};
-
-  for (int chunk_pos_idx = 0; chunk_pos_idx < num_chunk_positions; chunk_pos_idx++) {
-    func(pos, chunk_pos_idx);
-    // branchless iterate
-    direction_steps_counter++;
-    pos.x += kDx[direction];
-    pos.y += kDy[direction];
-    bool change_dir = direction_steps_counter == step_radius;
-    direction = (direction + change_dir) % 4;
-    direction_steps_counter *= !change_dir;
-    turn_counter += change_dir;
-    step_radius += change_dir * (1 - (turn_counter % 2));
-  }
-}
-
-void ChunkManager::IterateChunks(int load_distance, const PositionIteratorFunc& func) const {
-  // Clockwise Spiral iterator starting from center
-  constexpr static int kDx[] = {1, 0, -1, 0};
-  constexpr static int kDy[] = {0, 1, 0, -1};
-  int direction = 0;
-  int step_radius = 1;
-  int direction_steps_counter = 0;
-  int turn_counter = 0;
-  int load_len = (load_distance) * 2 + 1;
-  int num_chunk_positions = load_len * load_len;
-  glm::ivec2 pos{center_.x, center_.z};
-
-  for (int chunk_pos_idx = 0; chunk_pos_idx < num_chunk_positions; chunk_pos_idx++) {
-    func(pos);
-    // branchless iterate
-    direction_steps_counter++;
-    pos.x += kDx[direction];
-    pos.y += kDy[direction];
-    bool change_dir = direction_steps_counter == step_radius;
-    direction = (direction + change_dir) % 4;
-    direction_steps_counter *= !change_dir;
-    turn_counter += change_dir;
-    step_radius += change_dir * (1 - (turn_counter % 2));
-  }
-}
-
-void ChunkManager::IterateChunksVertical(int load_distance,
-                                         const VerticalPositionIteratorFunc& func) const {
-  IterateChunks(load_distance, [&func](const glm::ivec2& pos) {
-    glm::ivec3 p{pos.x, 0, pos.y};
-    for (p.y = 0; p.y < kNumVerticalChunks; p.y++) {
-      func(p);
-    }
-  });
-}
-
 ChunkManager::~ChunkManager() {
-  thread_pool_.wait();
-  IterateChunks(load_distance_, [this](const glm::ivec2& pos) {
-    glm::ivec3 p{pos.x, 0, pos.y};
-    for (p.y = 0; p.y < kNumVerticalChunks; p.y++) {
-      chunk_map_.find_fn(
-          p, [this](const std::shared_ptr<Chunk>& chunk) { FreeChunkMesh(chunk->mesh); });
-    }
-    lod_chunk_handle_map_.find_fn(pos, [this](uint32_t& handle) { FreeOpaqueChunkMesh(handle); });
+  job_system_.WaitAll();
+  chunk_map_.ForEachColumn([this](ChunkColumn& column) {
+    for (const auto& chunk : column.chunks) FreeChunkMesh(chunk->mesh);
+    FreeOpaqueChunkMesh(column.lod_mesh_handle);
   });
 
-  nlohmann::json j = {{"load_distance", load_distance_},
-                      {"lod_1_load_distance", lod_1_load_distance_},
-                      {"frequency", frequency_}};
+  // the configured distances, not what the budget trimmed them to
+  nlohmann::json j = {{"load_distance", memory_budget_.GetTargetLoadDistance()},
+                      {"lod_1_load_distance", memory_budget_.GetTargetLOD1LoadDistance()},
+                      {"frequency", frequency_},
+                      {"lighting", lighting_enabled_},
+                      {"unload_band", unload_band_}};
   SettingsManager::Get().SaveSetting(j, "chunk_manager");
+  auto budget_settings = memory_budget_.SaveSettings();
+  SettingsManager::Get().SaveSetting(budget_settings, "memory_budget");
+  auto pool_settings = ChunkPool::Get().SaveSettings();
+  SettingsManager::Get().SaveSetting(pool_settings, "chunk_pool");
+  auto predictor_settings = stream_predictor_.SaveSettings();
+  SettingsManager::Get().SaveSetting(predictor_settings, "stream_predictor");
+  auto evicted_settings = evicted_columns_.SaveSettings();
+  SettingsManager::Get().SaveSetting(evicted_settings, "evicted_columns");
+  auto frame_budget_settings = frame_budget_.SaveSettings();
+  SettingsManager::Get().SaveSetting(frame_budget_settings, "frame_budget");
+  auto job_system_settings = job_system_.SaveSettings();
+  SettingsManager::Get().SaveSetting(job_system_settings, "job_system");
 }
 
 void ChunkManager::OnImGui() {
   if (ImGui::CollapsingHeader("Chunk Manager", ImGuiTreeNodeFlags_DefaultOpen)) {
-    int old_load_distance = load_distance_;
-    if (ImGui::SliderInt("Load Distance", &load_distance_, 1, 72)) {
-      UnloadChunksOutOfRange(old_load_distance);
-      AddNewChunks(false);
+    int load_distance = load_distance_;
+    if (ImGui::SliderInt("Load Distance", &load_distance, 1, kMaxLoadDistance)) {
+      SetLoadDistance(load_distance);
+      memory_budget_.SetTargets(load_distance_, lod_1_load_distance_);
+    }
+    int old_unload_band = unload_band_;
+    if (ImGui::SliderInt("Unload Band", &unload_band_, 0, 8)) {
+      // covers the columns of the wider old band too
+      UnloadChunksOutOfRange(load_distance_ + std::max(0, old_unload_band - unload_band_));
     }
     ImGui::Checkbox("Update Chunks On Move", &update_chunks_on_move_);
     ImGui::SliderFloat("Frequency", &frequency_, 0.1, 10);
-    int old_lod1_distance = lod_1_load_distance_;
-    ImGui::BeginDisabled(thread_pool_.get_tasks_running() > 0 ||
-                         !chunk_mesh_finished_queue_.empty() ||
-                         !lod_chunk_mesh_finished_queue_.empty());
-    if (ImGui::SliderInt("LOD 1 Distance", &lod_1_load_distance_, std::min(5, load_distance_ - 1),
+    ImGui::Checkbox("Lighting", &lighting_enabled_);
+    QueueDepths depths = GetQueueDepths();
+    ImGui::BeginDisabled(!job_system_.Idle() || depths.mesh_finished > 0 ||
+                         depths.lod_mesh_finished > 0);
+    int lod_1_load_distance = lod_1_load_distance_;
+    if (ImGui::SliderInt("LOD 1 Distance", &lod_1_load_distance, std::min(5, load_distance_ - 1),
                          load_distance_ - 1)) {
-      // if greater, need to change old lod chunks into regular chunks
-      // if less, need to change regular chunks into lod chunks
-      if (old_lod1_distance < lod_1_load_distance_) {
-        // change to regular chunks
-        IterateChunksVertical(lod_1_load_distance_, [this](const glm::ivec3& pos) {
-          auto chunk = chunk_map_.find(pos);
-          if (chunk->lod_level != LODLevel::kRegular) {
-            SendChunkMeshTaskNoLOD(pos);
-          }
-        });
-      } else {
-        // change to lod chunks
-        IterateChunks(lod_1_load_distance_, old_lod1_distance,
-                      [this](const glm::ivec2& pos) { SendChunkMeshTaskLOD1(pos); });
-      }
+      SetLOD1LoadDistance(lod_1_load_distance);
+      memory_budget_.SetTargets(load_distance_, lod_1_load_distance_);
     }
     ImGui::EndDisabled();
     if (ImGui::CollapsingHeader("Stats##chunk_manager_stats", ImGuiTreeNodeFlags_DefaultOpen)) {
       ImGui::Text("Center: %i %i %i", center_.x, center_.y, center_.z);
       ImGui::Text("Prev Center: %i %i %i", prev_center_.x, prev_center_.y, prev_center_.z);
-      ImGui::Text("Chunk Map: %zu", chunk_map_.size());
-      ImGui::Text("LOD Handle Map: %zu", lod_chunk_handle_map_.size());
+      ImGui::Text("Chunk Map: %zu columns", chunk_map_.size());
       ImGui::Text("Chunk Mesh Queue:  %zu", chunk_mesh_queue_.size());
       ImGui::Text("Chunk Mesh Queue Imm:  %zu", chunk_mesh_queue_immediate_.size());
-      ImGui::Text("Chunk Mesh Finish Queue:  %zu", chunk_mesh_finished_queue_.size());
-      ImGui::Text("LOD Chunk Mesh Finish Queue:  %zu", lod_chunk_mesh_finished_queue_.size());
+      ImGui::Text("Chunk Mesh Finish Queue:  %zu", depths.mesh_finished);
+      ImGui::Text("LOD Chunk Mesh Finish Queue:  %zu", depths.lod_mesh_finished);
       ImGui::Text("Chunk Terrain Queue:  %zu", chunk_terrain_queue_.size());
-      ImGui::Text("Chunk Terrain Finish Queue:  %zu", finished_chunk_terrain_queue_.size());
+      ImGui::Text("Chunk Terrain Finish Queue:  %zu", depths.terrain_finished);
+      ImGui::Text("Chunk Light Queue:  %zu", chunk_light_queue_.size());
+      ImGui::Text("Chunk Lit Queue:  %zu", chunk_lit_queue_.size());
+      ImGui::Text("Last Light Update: %.3f ms", last_light_update_ms_);
       ImGui::Text("Chunks:  Loaded: %i, Meshed: %i Max: %i", state_stats_.loaded_chunks,
                   state_stats_.meshed_chunks, state_stats_.max_chunks);
+      ImGui::Text("Stale Mesh Results: %i", state_stats_.stale_mesh_results);
+    }
+    if (ImGui::CollapsingHeader("Memory##chunk_manager_memory")) {
+      // walking the chunk map locks it, so only refresh once a second
+      if (memory_usage_timer_.ElapsedSeconds() > 1 || memory_usage_.num_chunks == 0) {
+        memory_usage_ = GetMemoryUsage();
+        memory_usage_timer_.Reset();
+      }
+      ImGui::Text("Chunks: %zu", memory_usage_.num_chunks);
+      ImGuiBytes("Total", memory_usage_.Total());
+      ImGuiBytes("Chunk objects", memory_usage_.chunk_objects);
+      ImGuiBytes("Block arrays", memory_usage_.block_arrays);
+      ImGuiBytes("LOD arrays", memory_usage_.lod_arrays);
+      ImGuiBytes("Light arrays", memory_usage_.light_arrays);
+      ImGuiBytes("Height maps", memory_usage_.height_maps);
+      ImGuiBytes("Meshes in flight", memory_usage_.meshes_in_flight);
+      ImGuiBytes("Chunk map overhead", memory_usage_.chunk_map_overhead);
+      ImGuiBytes("Pooled for reuse", memory_usage_.pooled);
+      ImGuiBytes("Evicted columns", memory_usage_.evicted_columns);
     }
+    ChunkPool::Get().OnImGui();
+    memory_budget_.OnImGui();
+    stream_predictor_.OnImGui();
+    evicted_columns_.OnImGui();
+    frame_budget_.OnImGui();
+    job_system_.OnImGui();
   }
 }
 
@@ -583,8 +1115,15 @@ void ChunkManager::PopulateChunkNeighbors(ChunkNeighborArray& neighbor_array,
 void ChunkManager::AddRelatedChunks(const glm::ivec3& block_pos_in_chunk,
                                     const glm::ivec3& chunk_pos,
                                     std::unordered_set<glm::ivec3>& chunk_set) {
+  AddRelatedChunks(block_pos_in_chunk, block_pos_in_chunk, chunk_pos, chunk_set);
+}
+
+void ChunkManager::AddRelatedChunks(const glm::ivec3& min_pos_in_chunk,
+                                    const glm::ivec3& max_pos_in_chunk,
+                                    const glm::ivec3& chunk_pos,
+                                    std::unordered_set<glm::ivec3>& chunk_set) {
   ZoneScoped;
-  glm::ivec3 chunks_to_add[8];  // at most 8 chunks are related to a block
+  glm::ivec3 chunks_to_add[27];  // at most 27 chunks are related to a box of blocks
   glm::ivec3 temp;  // temp variable to store the chunk to add (calculate offset from chunk pos)
   int num_chunks_to_add = 1;  // always add the chunk the block is in
   int size;
@@ -592,9 +1131,10 @@ void ChunkManager::AddRelatedChunks(const glm::ivec3& block_pos_in_chunk,
 
   // iterate over each axis
   for (int axis = 0; axis < 3; axis++) {
-    // if block is on edge of the axis, add the chunks on the other side of the edge
-    if (block_pos_in_chunk[axis] == 0) {
-      size = num_chunks_to_add;
+    // only offset the chunks added before this axis, otherwise the -1 and +1 sides would combine
+    size = num_chunks_to_add;
+    // if the box touches an edge of the axis, add the chunks on the other side of the edge
+    if (min_pos_in_chunk[axis] == 0) {
       for (int i = 0; i < size; i++) {
         temp = chunks_to_add[i];  // works since only doing one axis at a time
         temp[axis]--;             // decrement chunk pos on the axis
@@ -602,8 +1142,7 @@ void ChunkManager::AddRelatedChunks(const glm::ivec3& block_pos_in_chunk,
       }
     }
 
-    if (block_pos_in_chunk[axis] == kChunkLength - 1) {
-      size = num_chunks_to_add;
+    if (max_pos_in_chunk[axis] == kChunkLength - 1) {
       for (int i = 0; i < size; i++) {
         temp = chunks_to_add[i];
         temp[axis]++;
@@ -621,17 +1160,22 @@ void ChunkManager::AddRelatedChunks(const glm::ivec3& block_pos_in_chunk,
 void ChunkManager::SetCenter(const glm::vec3& world_pos) {
   prev_center_ = center_;
   center_ = util::chunk::WorldToChunkPos(world_pos);
+  center_world_pos_ = world_pos;
 }
 
-void ChunkManager::SetSeed(int seed) { seed_ = seed; }
+void ChunkManager::SetSeed(int seed) {
+  seed_ = seed;
+  // generated with the old seed
+  evicted_columns_.Clear();
+}
 
 void ChunkManager::FreeOpaqueChunkMesh(uint32_t& handle) {
-  Renderer::Get().FreeStaticChunkMesh(handle);
+  mesh_sink_.FreeStaticChunkMesh(handle);
 }
 
 void ChunkManager::FreeChunkMesh(ChunkMesh& mesh) {
-  Renderer::Get().FreeStaticChunkMesh(mesh.opaque_mesh_handle);
-  Renderer::Get().FreeStaticChunkMeshTransparent(mesh.transparent_mesh_handle);
+  mesh_sink_.FreeStaticChunkMesh(mesh.opaque_mesh_handle);
+  mesh_sink_.FreeStaticChunkMeshTransparent(mesh.transparent_mesh_handle);
 }
 
 bool ChunkManager::ChunkPosWithinDistance(int x, int z, int distance) const {
@@ -640,38 +1184,36 @@ bool ChunkManager::ChunkPosWithinDistance(int x, int z, int distance) const {
 }
 
 void ChunkManager::SendChunkMeshTaskLOD1(const glm::ivec2& pos) {
-  thread_pool_.detach_task([this, pos] {
+  uint32_t generation = chunk_map_.ColumnGeneration(pos);
+  job_system_.Submit(JobSystem::Priority::kBackground, [this, pos, generation] {
     if (!ChunkPosWithinDistance(pos.x, pos.y, load_distance_)) return;
     if (ChunkPosWithinDistance(pos.x, pos.y, lod_1_load_distance_)) return;
-    ChunkStackArray arr{};
-    glm::ivec3 p;
-    p.x = pos.x;
-    p.z = pos.y;
-    bool done = false;
-    for (p.y = 0; p.y < kNumVerticalChunks; p.y++) {
-      chunk_map_.find_fn(p, [&p, &arr, &done](const std::shared_ptr<Chunk>& chunk) {
-        if (chunk->lod_level == LODLevel::kOne) {
-          done = true;
-          return;
-        }
-        arr[p.y] = chunk;
-      });
+    std::shared_ptr<ChunkColumn> column = chunk_map_.FindColumn(pos);
+    if (!column) return;
+    for (const auto& chunk : column->chunks) {
+      if (chunk->lod_level == LODLevel::kOne) return;
     }
-    if (done) return;
     std::vector<ChunkVertex> vertices;
     std::vector<uint32_t> indices;
-    ChunkMesher mesher{block_db_.GetBlockData(), block_db_.GetMeshData()};
-    mesher.GenerateLODGreedy2(arr, vertices, indices);
+    {
+      static auto& lod_mesh_us = MetricsRegistry::Get().GetHistogram("chunk.lod_mesh_us");
+      ScopedMetricTimer timer{lod_mesh_us};
+      ChunkMesher mesher{block_db_.GetBlockData(), block_db_.GetMeshData()};
+      mesher.GenerateLODGreedy2(column->chunks, vertices, indices);
+    }
+    mesh_bytes_in_flight_ += MeshBytes(vertices, indices);
     std::lock_guard<std::mutex> lock(lod_chunk_mesh_finish_mtx_);
     lod_chunk_mesh_finished_queue_.emplace(std::move(vertices), std::move(indices), pos,
-                                           LODLevel::kOne);
+                                           LODLevel::kOne, generation);
   });
 }
 
 void ChunkManager::SendChunkMeshTaskNoLOD(const glm::ivec3& pos) {
   int num_blocks = 0;
-  if (!chunk_map_.find_fn(pos, [&num_blocks](const std::shared_ptr<Chunk>& chunk) {
+  uint32_t generation = 0;
+  if (!chunk_map_.find_fn(pos, [&num_blocks, &generation](const std::shared_ptr<Chunk>& chunk) {
         num_blocks = chunk->data.GetBlockCount();
+        generation = chunk->GetGeneration();
         if (!num_blocks) {
           chunk->lod_level = LODLevel::kRegular;
           chunk->mesh_state = Chunk::State::kFinished;
@@ -683,67 +1225,153 @@ void ChunkManager::SendChunkMeshTaskNoLOD(const glm::ivec3& pos) {
     return;
   }
 
-  thread_pool_.detach_task([this, pos] {
+  auto queued_time = std::chrono::steady_clock::now();
+  job_system_.Submit(JobSystem::Priority::kVisible, [this, pos, queued_time, generation] {
     if (!ChunkPosWithinDistance(pos.x, pos.z, lod_1_load_distance_)) return;
-    ChunkNeighborArray a;
-    PopulateChunkNeighbors(a, pos);
-    ChunkMesher mesher{block_db_.GetBlockData(), block_db_.GetMeshData()};
     MeshVerticesIndices verts_indices;
-    mesher.GenerateGreedy(a, verts_indices);
+    {
+      static auto& mesh_us = MetricsRegistry::Get().GetHistogram("chunk.mesh_us");
+      ScopedMetricTimer timer{mesh_us};
+      ChunkNeighborArray a;
+      PopulateChunkNeighbors(a, pos);
+      ChunkMesher mesher{block_db_.GetBlockData(), block_db_.GetMeshData()};
+      mesher.GenerateGreedy(a, verts_indices);
+    }
+    mesh_bytes_in_flight_ += MeshBytes(verts_indices);
     std::lock_guard<std::mutex> lock(chunk_mesh_finish_mtx_);
-    chunk_mesh_finished_queue_.emplace(std::move(verts_indices), pos);
+    chunk_mesh_finished_queue_.emplace(std::move(verts_indices), pos, queued_time, generation);
   });
 }
 
 void ChunkManager::AddNewChunks(bool throttle) {
-  // Clockwise Spiral iterator starting from center
-  constexpr static int kDx[] = {1, 0, -1, 0};
-  constexpr static int kDy[] = {0, 1, 0, -1};
-  int direction = 0;
-  int step_radius = 1;
-  int direction_steps_counter = 0;
-  int turn_counter = 0;
-  int load_len = (load_distance_) * 2 + 1;
-  int num_chunk_positions = load_len * load_len;
-  glm::ivec3 pos = center_;
-  pos.y = 0;
+  // spiral from where the player is predicted to be, far enough to cover the load square
+  glm::ivec2 center{center_.x, center_.z};
+  glm::ivec2 start = stream_predictor_.GetPredictedColumn(center, load_distance_);
+  glm::ivec2 offset = glm::abs(start - center);
+  int radius = load_distance_ + std::max(offset.x, offset.y);
 
   int max_per_call = SettingsManager::Get().CoreCount() * 3;
   int curr = 0;
-  for (int chunk_pos_idx = 0; chunk_pos_idx < num_chunk_positions; chunk_pos_idx++) {
-    bool new_chunk_column = false;
+  for (const glm::i16vec2& spiral_offset : util::spiral::Offsets(radius)) {
     if (throttle && curr > max_per_call) break;
-    for (pos.y = 0; pos.y < kNumVerticalChunks; pos.y++) {
-      if (!chunk_map_.contains(pos)) {
-        new_chunk_column = true;
-        auto chunk = std::make_shared<Chunk>(pos);
-        chunk->terrain_state = Chunk::State::kQueued;
-        chunk_map_.insert(pos, chunk);
-      }
+    glm::ivec2 pos = start + glm::ivec2(spiral_offset);
+    if (ChunkPosWithinDistance(pos.x, pos.y, load_distance_) && !chunk_map_.PeekColumn(pos)) {
+      QueueNewColumn(pos);
     }
-    if (new_chunk_column) {
-      chunk_terrain_queue_.emplace(pos.x, pos.z);
-    }
-
-    // branchless iterate
-    direction_steps_counter++;
-    pos.x += kDx[direction];
-    pos.z += kDy[direction];
-    bool change_dir = direction_steps_counter == step_radius;
-    direction = (direction + change_dir) % 4;
-    direction_steps_counter *= !change_dir;
-    turn_counter += change_dir;
-    step_radius += change_dir * (1 - (turn_counter % 2));
   }
 }
 
+void ChunkManager::AddFrontierChunks() {
+  ZoneScoped;
+  glm::ivec2 center{center_.x, center_.z};
+  glm::ivec2 start = stream_predictor_.GetPredictedColumn(center, load_distance_);
+  frontier_.clear();
+  util::spiral::ForEachFrontier(center, {prev_center_.x, prev_center_.z}, load_distance_,
+                                [this](const glm::ivec2& pos) {
+                                  if (!chunk_map_.PeekColumn(pos)) frontier_.emplace_back(pos);
+                                });
+  // rings around the predicted column like AddNewChunks, a strip is a few hundred at most
+  auto ring = [&start](const glm::ivec2& pos) {
+    glm::ivec2 d = glm::abs(pos - start);
+    return std::max(d.x, d.y);
+  };
+  std::ranges::sort(frontier_, [&ring](const glm::ivec2& a, const glm::ivec2& b) {
+    return ring(a) < ring(b);
+  });
+  for (const glm::ivec2& pos : frontier_) QueueNewColumn(pos);
+}
+
+void ChunkManager::QueueNewColumn(const glm::ivec2& pos) {
+  // a column that left the range long ago can still be in the slot after a teleport
+  if (auto stale = chunk_map_.StaleColumn(pos)) UnloadColumn(stale.value());
+  auto column = std::make_shared<ChunkColumn>(pos);
+  column->terrain_state = Chunk::State::kQueued;
+  chunk_map_.InsertColumn(std::move(column));
+  chunk_terrain_queue_.emplace(pos);
+}
+
 void ChunkManager::Init(const glm::ivec3& start_pos) {
   ZoneScoped;
   SetCenter(start_pos);
 }
 
+ChunkManager::QueueDepths ChunkManager::GetQueueDepths() const {
+  QueueDepths depths;
+  depths.terrain = chunk_terrain_queue_.size();
+  depths.light = chunk_light_queue_.size();
+  depths.lit = chunk_lit_queue_.size();
+  depths.mesh = chunk_mesh_queue_.size();
+  depths.mesh_immediate = chunk_mesh_queue_immediate_.size();
+  {
+    std::lock_guard<std::mutex> lock(chunk_terrain_finish_mtx_);
+    depths.terrain_finished = finished_chunk_terrain_queue_.size();
+  }
+  {
+    std::lock_guard<std::mutex> lock(chunk_light_finish_mtx_);
+    depths.light_finished = chunk_light_finished_queue_.size();
+  }
+  {
+    std::lock_guard<std::mutex> lock(chunk_mesh_finish_mtx_);
+    depths.mesh_finished = chunk_mesh_finished_queue_.size();
+  }
+  {
+    std::lock_guard<std::mutex> lock(lod_chunk_mesh_finish_mtx_);
+    depths.lod_mesh_finished = lod_chunk_mesh_finished_queue_.size();
+  }
+  depths.tasks_queued = job_system_.NumQueued();
+  depths.tasks_running = job_system_.NumRunning();
+  return depths;
+}
+
+ChunkManager::MemoryUsage ChunkManager::GetMemoryUsage() {
+  ZoneScoped;
+  MemoryUsage usage;
+  chunk_map_.ForEachColumn([&usage](const ChunkColumn& column) {
+    for (const auto& chunk : column.chunks) {
+      usage.num_chunks++;
+      usage.chunk_objects += sizeof(Chunk);
+      if (chunk->data.blocks_) usage.block_arrays += sizeof(BlockTypeArray);
+      if (chunk->data.blocks_lod_1_) usage.lod_arrays += sizeof(BlockTypeArrayLOD1);
+      if (chunk->data.GetLightArray()) usage.light_arrays += sizeof(LightArray);
+    }
+    if (column.heights) usage.height_maps += sizeof(ColumnHeightMap);
+    usage.chunk_map_overhead += sizeof(ChunkColumn);
+  });
+  usage.meshes_in_flight = mesh_bytes_in_flight_;
+  usage.chunk_map_overhead += chunk_map_.MemoryBytes();
+  usage.pooled = ChunkPool::Get().FreeBytes();
+  usage.evicted_columns = evicted_columns_.GetStats().bytes;
+  return usage;
+}
+
+void ChunkManager::UpdateQueueDepthGauges() {
+  auto& registry = MetricsRegistry::Get();
+  static auto& terrain = registry.GetGauge("queue.terrain");
+  static auto& terrain_finished = registry.GetGauge("queue.terrain_finished");
+  static auto& light = registry.GetGauge("queue.light");
+  static auto& light_finished = registry.GetGauge("queue.light_finished");
+  static auto& lit = registry.GetGauge("queue.lit");
+  static auto& mesh = registry.GetGauge("queue.mesh");
+  static auto& mesh_finished = registry.GetGauge("queue.mesh_finished");
+  static auto& lod_mesh_finished = registry.GetGauge("queue.lod_mesh_finished");
+  static auto& tasks_queued = registry.GetGauge("queue.tasks_queued");
+  static auto& tasks_running = registry.GetGauge("queue.tasks_running");
+  QueueDepths depths = GetQueueDepths();
+  terrain.Set(static_cast<double>(depths.terrain));
+  terrain_finished.Set(static_cast<double>(depths.terrain_finished));
+  light.Set(static_cast<double>(depths.light));
+  light_finished.Set(static_cast<double>(depths.light_finished));
+  lit.Set(static_cast<double>(depths.lit));
+  mesh.Set(static_cast<double>(depths.mesh));
+  mesh_finished.Set(static_cast<double>(depths.mesh_finished));
+  lod_mesh_finished.Set(static_cast<double>(depths.lod_mesh_finished));
+  tasks_queued.Set(static_cast<double>(depths.tasks_queued));
+  tasks_running.Set(static_cast<double>(depths.tasks_running));
+}
+
 bool ChunkManager::IsLoaded() const {
-  return chunk_mesh_queue_.empty() && chunk_mesh_finished_queue_.empty() &&
-         chunk_terrain_queue_.empty() && chunk_mesh_finished_queue_.empty() &&
-         thread_pool_.get_tasks_running() == 0;
+  QueueDepths depths = GetQueueDepths();
+  return depths.terrain == 0 && depths.terrain_finished == 0 && depths.light == 0 &&
+         depths.light_finished == 0 && depths.lit == 0 && depths.mesh == 0 &&
+         depths.mesh_finished == 0 && depths.lod_mesh_finished == 0 && job_system_.Idle();
 }
@@ -1,11 +1,21 @@
 #pragma once
 
-#include <BS_thread_pool.hpp>
+#include <atomic>
 #include <deque>
-#include <libcuckoo/cuckoohash_map.hh>
+#include <queue>
 
+#include "application/JobSystem.hpp"
+#include "gameplay/world/BlockAccessor.hpp"
 #include "gameplay/world/Chunk.hpp"
+#include "gameplay/world/ChunkMeshSink.hpp"
+#include "gameplay/world/EvictedColumnCache.hpp"
+#include "gameplay/world/FrameBudget.hpp"
+#include "gameplay/world/LightEngine.hpp"
+#include "gameplay/world/MemoryBudget.hpp"
+#include "gameplay/world/SpiralOrder.hpp"
+#include "gameplay/world/StreamPredictor.hpp"
 #include "gameplay/world/Terrain.hpp"
+#include "util/Timer.hpp"
 
 #define GLM_ENABLE_EXPERIMENTAL
 
@@ -14,9 +24,10 @@
 
 class BlockDB;
 
-using ChunkMap = libcuckoo::cuckoohash_map<glm::ivec3, std::shared_ptr<Chunk>>;
-using LODChunkMap = libcuckoo::cuckoohash_map<glm::ivec2, uint32_t>;
-// using ChunkMap = std::unordered_map<glm::ivec3, std::shared_ptr<Chunk>>;
+struct BlockEdit {
+  glm::ivec3 pos;
+  BlockType block;
+};
 
 struct ChunkStateData {
   std::vector<ChunkState> data;
@@ -26,9 +37,11 @@ struct ChunkStateData {
 
 class ChunkManager {
  public:
-  explicit ChunkManager(BlockDB& block_db);
+  ChunkManager(BlockDB& block_db, ChunkMeshSink& mesh_sink);
   ~ChunkManager();
 
+  // Queues every missing column within the load distance, walking the whole square. Update only
+  // queues the frontier after a move.
   void AddNewChunks(bool throttle);
   void Init(const glm::ivec3& start_pos);
   void Update(double dt);
@@ -36,11 +49,37 @@ class ChunkManager {
   void SetSeed(int seed);
   const ChunkMap& GetVisibleChunks() const { return chunk_map_; }
   void SetBlock(const glm::ivec3& pos, BlockType block);
+  // Edits are grouped by chunk so each chunk is looked up and remeshed once. Edits in chunks that
+  // aren't loaded are skipped.
+  void SetBlocks(std::span<const BlockEdit> edits);
+  // min and max are inclusive.
+  void FillBox(const glm::ivec3& min, const glm::ivec3& max, BlockType block);
+  void FillSphere(const glm::ivec3& center, int radius, BlockType block);
   BlockType GetBlock(const glm::ivec3& pos) const;
+  // Copies the blocks in the inclusive region [min, max] into out, x fastest then z then y like
+  // ChunkData. Blocks above the world are air, everything else not loaded is unloaded_block.
+  void GetBlocks(const glm::ivec3& min, const glm::ivec3& max, std::span<BlockType> out,
+                 BlockType unloaded_block) const;
   Chunk* GetChunk(const glm::ivec3& pos);
+  // nullptr if the column isn't loaded
+  [[nodiscard]] const ChunkColumn* GetColumn(const glm::ivec2& column_pos) const {
+    return chunk_map_.PeekColumn(column_pos);
+  }
+  // Prefer over GetBlock/BlockPosExists when reading many nearby blocks.
+  [[nodiscard]] BlockAccessor GetBlockAccessor() const { return BlockAccessor(chunk_map_); }
   bool BlockPosExists(const glm::ivec3& world_pos) const;
+  // Highest non-air y at world x, z, or ColumnHeightMap::kEmpty if the column has no terrain yet.
+  [[nodiscard]] int GetHeight(int x, int z) const;
+  // Highest non-air y of the columns overlapping the inclusive world x, z region, skipping columns
+  // without terrain. May be higher than the region itself.
+  [[nodiscard]] int GetMaxHeight(const glm::ivec2& min, const glm::ivec2& max) const;
+  // Null until the column's terrain is finished. Kept up to date by block edits.
+  [[nodiscard]] std::shared_ptr<const ColumnHeightMap> GetColumnHeightMap(
+      const glm::ivec2& column_pos) const;
   void OnImGui();
   void SetCenter(const glm::vec3& world_pos);
+  // The camera front, new columns ahead of where the player is heading load first.
+  void SetHeading(const glm::vec3& front) { stream_predictor_.SetHeading(front); }
 
   void PopulateChunkStatePixels(std::vector<uint8_t>& pixels, glm::ivec2& out_dims, int y_level,
                                 float opacity, ChunkMapMode mode);
@@ -51,43 +90,163 @@ class ChunkManager {
     uint32_t max_chunks{};
     uint32_t loaded_chunks{};
     uint32_t meshed_chunks{};
+    // finished meshes dropped because the chunk was remeshed or reloaded since they were sent
+    uint32_t stale_mesh_results{};
   };
 
   const StateStats& GetStateStats() const { return state_stats_; }
   bool IsLoaded() const;
+  [[nodiscard]] int GetLoadDistance() const { return load_distance_; }
+  [[nodiscard]] int GetLOD1LoadDistance() const { return lod_1_load_distance_; }
+  // Finished columns stay loaded until they're this far, so walking back and forth over the edge
+  // of the load distance doesn't unload and remesh the same columns.
+  [[nodiscard]] int GetUnloadDistance() const;
+  // Shrinking unloads the columns outside the new distance, growing queues the new ones.
+  void SetLoadDistance(int load_distance);
+  // Remeshes the columns crossing the ring at the other level of detail.
+  void SetLOD1LoadDistance(int lod_1_load_distance);
+  // Sends the meshes the sink failed to allocate again, if they're still in range.
+  void RetryFailedMeshAllocs();
+  [[nodiscard]] size_t NumFailedMeshAllocs() const {
+    return failed_mesh_allocs_.size() + failed_lod_mesh_allocs_.size();
+  }
+
+  struct QueueDepths {
+    size_t terrain{};
+    size_t terrain_finished{};
+    size_t light{};
+    size_t light_finished{};
+    size_t lit{};
+    size_t mesh{};
+    size_t mesh_immediate{};
+    size_t mesh_finished{};
+    size_t lod_mesh_finished{};
+    size_t tasks_queued{};
+    size_t tasks_running{};
+  };
+  // Locks the finished queues, call from the thread that calls Update.
+  [[nodiscard]] QueueDepths GetQueueDepths() const;
+
+  // Bytes held by the world data. Walks every chunk, so not per frame.
+  struct MemoryUsage {
+    size_t num_chunks{};
+    size_t chunk_objects{};
+    size_t block_arrays{};
+    size_t lod_arrays{};
+    size_t light_arrays{};
+    size_t height_maps{};
+    // meshes done on a worker and not yet handed to the mesh sink
+    size_t meshes_in_flight{};
+    // the chunk grid's slots and the column records
+    size_t chunk_map_overhead{};
+    // free arrays and chunk objects the chunk pool keeps for the next chunks
+    size_t pooled{};
+    // encoded columns unloaded recently, in case they're loaded again
+    size_t evicted_columns{};
+    [[nodiscard]] size_t Total() const {
+      return chunk_objects + block_arrays + lod_arrays + light_arrays + height_maps +
+             meshes_in_flight + chunk_map_overhead + pooled + evicted_columns;
+    }
+  };
+  [[nodiscard]] MemoryUsage GetMemoryUsage();
+  // Drops the cached evicted columns, returns the bytes freed.
+  size_t TrimEvictedColumns() { return evicted_columns_.Clear(); }
+
+  // Visits the chunk columns within load_distance of the center in a clockwise spiral outward.
+  template <typename Fn>
+  void IterateChunks(int load_distance, Fn&& func) const {
+    util::spiral::ForEach({center_.x, center_.z}, load_distance, func);
+  }
 
  private:
   BlockDB& block_db_;
+  ChunkMeshSink& mesh_sink_;
   ChunkMap chunk_map_;
-  LODChunkMap lod_chunk_handle_map_;
   Terrain terrain_;
   int seed_{};
   int load_distance_{};
+  // columns past the load distance kept loaded, see GetUnloadDistance
+  int unload_band_{2};
   glm::ivec3 center_{};
   glm::ivec3 prev_center_{};
+  glm::vec3 center_world_pos_{};
   std::queue<glm::ivec2> chunk_mesh_queue_;
   std::unordered_set<glm::ivec3> chunk_mesh_queue_immediate_;
-  std::mutex lod_chunk_mesh_finish_mtx_;
-  std::mutex chunk_mesh_finish_mtx_;
+  struct ImmediateRemesh {
+    glm::ivec3 pos;
+    Chunk* chunk;
+    MeshVerticesIndices verts_indices;
+    JobSystem::Handle job;
+  };
+  // the chunks of this frame's edits, meshed on the workers at edit priority and uploaded before
+  // Update returns
+  std::vector<ImmediateRemesh> immediate_remeshes_;
+  // the finished queues are pushed to by the workers, only touch them under their mutex
+  mutable std::mutex lod_chunk_mesh_finish_mtx_;
+  mutable std::mutex chunk_mesh_finish_mtx_;
   std::queue<ChunkMeshTask> chunk_mesh_finished_queue_;
   std::queue<LODChunkMeshTask> lod_chunk_mesh_finished_queue_;
-  using PositionIteratorFunc = std::function<void(const glm::ivec2&)>;
-  using PositionIteratorFuncIdx = std::function<void(const glm::ivec2&, int)>;
-  using VerticalPositionIteratorFunc = std::function<void(const glm::ivec3&)>;
-  void IterateChunks(int load_distance, const PositionIteratorFunc& func) const;
-  void IterateChunks(int load_distance, const PositionIteratorFuncIdx& func) const;
-  void IterateChunks(int start_distance, int load_distance, const PositionIteratorFunc& func) const;
-  void IterateChunks(int start_distance, int load_distance,
-                     const PositionIteratorFuncIdx& func) const;
-  void IterateChunksVertical(int load_distance, const VerticalPositionIteratorFunc& func) const;
+  // vertex and index bytes in both finished mesh queues
+  std::atomic<size_t> mesh_bytes_in_flight_{0};
+  MemoryUsage memory_usage_;
+  Timer memory_usage_timer_;
+  // the rings from start_distance + 1 out to load_distance
+  template <typename Fn>
+  void IterateChunks(int start_distance, int load_distance, Fn&& func) const {
+    glm::ivec2 center{center_.x, center_.z};
+    for (int r = start_distance + 1; r <= load_distance; r++) {
+      for (const glm::i16vec2& offset : util::spiral::Ring(r)) func(center + glm::ivec2(offset));
+    }
+  }
+  template <typename Fn>
+  void IterateChunksVertical(int load_distance, Fn&& func) const {
+    IterateChunks(load_distance, [&func](const glm::ivec2& pos) {
+      glm::ivec3 p{pos.x, 0, pos.y};
+      for (p.y = 0; p.y < kNumVerticalChunks; p.y++) func(p);
+    });
+  }
 
   std::queue<glm::ivec2> chunk_terrain_queue_;
-  std::mutex chunk_terrain_finish_mtx_;
-  std::deque<glm::ivec2> finished_chunk_terrain_queue_;
+  mutable std::mutex chunk_terrain_finish_mtx_;
+  std::queue<ChunkTerrainTask> finished_chunk_terrain_queue_;
+  // terrain jobs sent and not yet finished on the main thread, light jobs of the columns around
+  // them wait on them
+  std::unordered_map<glm::ivec2, JobSystem::Handle> terrain_jobs_;
+  // rescans the heights of the cells of [min, max] after an edit there
+  void UpdateHeights(const glm::ivec3& min, const glm::ivec3& max);
+
+  // columns wait here until the neighbor columns have terrain or a terrain job, then are lit on
+  // the workers once those jobs finish
+  std::deque<glm::ivec2> chunk_light_queue_;
+  mutable std::mutex chunk_light_finish_mtx_;
+  std::queue<ChunkLightTask> chunk_light_finished_queue_;
+  // lit columns wait here until the neighbor columns are lit, then are meshed
+  std::deque<glm::ivec2> chunk_lit_queue_;
+  LightEngine light_engine_;
+  std::vector<LightChangeBounds> light_changes_;
+  bool lighting_enabled_{true};
+  // set from the block DB once its mesh data is loaded
+  bool light_props_set_{false};
+  double last_light_update_ms_{0};
+  // True if every neighbor column of pos within the load distance is loaded and satisfies
+  // ready_fn. Columns past the load distance are the edge of the loaded world and don't count.
+  bool NeighborColumnsReady(const glm::ivec2& pos,
+                            const std::function<bool(const ChunkColumn&)>& ready_fn) const;
+  // Relights the lit columns whose light an edit of [min, max] can change on the workers at edit
+  // priority, waiting for them, and queues the chunks whose light changed for the immediate
+  // remesh along with the edited ones. Columns still being lit are queued to be lit again.
+  void RelightEdit(const glm::ivec3& min, const glm::ivec3& max);
 
   void PopulateChunkNeighbors(ChunkNeighborArray& neighbor_array, const glm::ivec3& pos);
   static void AddRelatedChunks(const glm::ivec3& block_pos_in_chunk, const glm::ivec3& chunk_pos,
                                std::unordered_set<glm::ivec3>& chunk_set);
+  static void AddRelatedChunks(const glm::ivec3& min_pos_in_chunk,
+                               const glm::ivec3& max_pos_in_chunk, const glm::ivec3& chunk_pos,
+                               std::unordered_set<glm::ivec3>& chunk_set);
+  // Gives the inclusive world x range of the row at world y, z. Returns false if the row is empty.
+  using RowSpanFunc = std::function<bool(int y, int z, int& x_begin, int& x_end)>;
+  void FillRows(const glm::ivec3& min, const glm::ivec3& max, BlockType block,
+                const RowSpanFunc& row_span);
   bool ChunkPosOutsideHorizontalRange(int x, int z, int dist, const glm::ivec2& pos);
   bool ChunkPosWithinDistance(int x, int z, int distance) const;
 
@@ -97,11 +256,43 @@ class ChunkManager {
   bool first_load_completed_{false};
   bool update_chunks_on_move_{true};
 
-  BS::thread_pool thread_pool_;
+  JobSystem job_system_;
 
   void FreeChunkMesh(ChunkMesh& mesh);
   void FreeOpaqueChunkMesh(uint32_t& handle);
+  // frees the column's meshes and removes it from the chunk map, its memory is released later
+  void UnloadColumn(const glm::ivec2& pos);
+  struct RetiredColumn {
+    std::shared_ptr<ChunkColumn> column;
+    // 0 if it doesn't go in the evicted column cache
+    uint64_t eviction_sequence;
+  };
+  // unloaded this frame, released on a worker by ReleaseRetiredColumns so freeing the arrays and
+  // encoding the column for the cache stay off the main thread
+  std::vector<RetiredColumn> retired_columns_;
+  void ReleaseRetiredColumns();
+  // terrain and every chunk mesh finished, so nothing is left to redo if it comes back into range
+  static bool ColumnComplete(const ChunkColumn& column);
+  // inserts an empty column and queues its terrain
+  void QueueNewColumn(const glm::ivec2& pos);
+  // queues the columns the last center move brought into range, nearest the predicted column first
+  void AddFrontierChunks();
+  std::vector<glm::ivec2> frontier_;
   void SendChunkMeshTaskNoLOD(const glm::ivec3& pos);
   void SendChunkMeshTaskLOD1(const glm::ivec2& pos);
   void AllocateChunkMesh();
+  // publishes GetQueueDepths to the "queue.*" metrics gauges
+  void UpdateQueueDepthGauges();
+
+  // chunks and LOD columns whose mesh the sink couldn't allocate, waiting for RetryFailedMeshAllocs
+  std::vector<glm::ivec3> failed_mesh_allocs_;
+  std::vector<glm::ivec2> failed_lod_mesh_allocs_;
+  // OnLODMeshAllocFailed looks up the column's chunks, don't call it inside a chunk map lambda
+  void OnMeshAllocFailed(const glm::ivec3& pos);
+  void OnLODMeshAllocFailed(const glm::ivec2& pos);
+  MemoryBudget memory_budget_;
+  StreamPredictor stream_predictor_;
+  EvictedColumnCache evicted_columns_;
+  FrameBudget frame_budget_;
+  uint64_t eviction_sequence_{};
 };
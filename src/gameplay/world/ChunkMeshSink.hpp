@@ -0,0 +1,32 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include "gameplay/world/ChunkDef.hpp"
+
+// Receives the finished meshes of ChunkManager. The renderer uploads them to the GPU, headless
+// runs just account for them. Handles are opaque to ChunkManager, 0 means no mesh. Only called
+// from the thread that calls ChunkManager::Update.
+class ChunkMeshSink {
+ public:
+  virtual ~ChunkMeshSink() = default;
+  [[nodiscard]] virtual uint32_t AllocateStaticChunk(std::vector<ChunkVertex>& vertices,
+                                                     std::vector<uint32_t>& indices,
+                                                     const glm::ivec3& pos, LODLevel level) = 0;
+  [[nodiscard]] virtual uint32_t AllocateStaticChunkTransparent(
+      std::vector<ChunkVertex>& vertices, std::vector<uint32_t>& indices,
+      const glm::ivec3& pos) = 0;
+  // Sets handle to 0.
+  virtual void FreeStaticChunkMesh(uint32_t& handle) = 0;
+  virtual void FreeStaticChunkMeshTransparent(uint32_t& handle) = 0;
+
+  struct MeshBufferUsage {
+    // fraction of the fullest buffer that can't take an allocation, counting fragmented free
+    // space as used. 0 for sinks without a capacity.
+    float occupancy{};
+    // allocations that returned 0 despite having vertices
+    uint64_t failed_allocs{};
+  };
+  // May walk every allocation, don't call every frame.
+  [[nodiscard]] virtual MeshBufferUsage GetMeshBufferUsage() const = 0;
+};
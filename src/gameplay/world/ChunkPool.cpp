@@ -0,0 +1,180 @@
+#include "ChunkPool.hpp"
+
+#include <imgui.h>
+
+#include <cstring>
+#include <nlohmann/json.hpp>
+
+#include "gameplay/world/Chunk.hpp"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+constexpr size_t kSlabSize = size_t{2} << 20;
+
+}  // namespace
+
+void ChunkArrayDeleter::operator()(BlockTypeArray* blocks) const {
+  ChunkPool::Get().blocks_.Deallocate(blocks, sizeof(BlockTypeArray));
+}
+
+void ChunkArrayDeleter::operator()(BlockTypeArrayLOD1* blocks) const {
+  ChunkPool::Get().lod_blocks_.Deallocate(blocks, sizeof(BlockTypeArrayLOD1));
+}
+
+ChunkPool::ChunkPool() { LoadSettings(nlohmann::json::object()); }
+
+ChunkPool& ChunkPool::Get() {
+  static ChunkPool pool;
+  return pool;
+}
+
+void ChunkPool::LoadSettings(const nlohmann::json& j) {
+  huge_pages_ = j.value("huge_pages", huge_pages_);
+  max_free_bytes_ = j.value("max_free_mb", max_free_bytes_ >> 20) << 20;
+  // one free LOD array per free block array, and a column of chunk objects for each
+  size_t max_free_arrays =
+      max_free_bytes_ / (sizeof(BlockTypeArray) + sizeof(BlockTypeArrayLOD1));
+  blocks_.Configure(huge_pages_, max_free_arrays);
+  lod_blocks_.Configure(huge_pages_, max_free_arrays);
+  chunks_.Configure(false, max_free_arrays * kNumVerticalChunks);
+}
+
+nlohmann::json ChunkPool::SaveSettings() const {
+  return {{"huge_pages", huge_pages_}, {"max_free_mb", max_free_bytes_ >> 20}};
+}
+
+BlockTypeArrayPtr ChunkPool::AcquireBlocks() {
+  auto* blocks = static_cast<BlockTypeArray*>(blocks_.Allocate(sizeof(BlockTypeArray)));
+  std::memset(blocks, 0, sizeof(BlockTypeArray));
+  return BlockTypeArrayPtr{blocks};
+}
+
+BlockTypeArrayLOD1Ptr ChunkPool::AcquireLODBlocks() {
+  auto* blocks =
+      static_cast<BlockTypeArrayLOD1*>(lod_blocks_.Allocate(sizeof(BlockTypeArrayLOD1)));
+  std::memset(blocks, 0, sizeof(BlockTypeArrayLOD1));
+  return BlockTypeArrayLOD1Ptr{blocks};
+}
+
+std::shared_ptr<Chunk> ChunkPool::MakeChunk(const glm::ivec3& pos) {
+  return std::allocate_shared<Chunk>(ChunkAllocator<Chunk>{}, pos);
+}
+
+size_t ChunkPool::Trim() { return blocks_.Trim() + lod_blocks_.Trim() + chunks_.Trim(); }
+
+size_t ChunkPool::FreeBytes() const {
+  return blocks_.FreeBytes() + lod_blocks_.FreeBytes() + chunks_.FreeBytes();
+}
+
+void ChunkPool::OnImGui() const {
+  if (!ImGui::CollapsingHeader("Chunk Pool##chunk_pool")) return;
+  ImGui::Text("Huge pages: %s, max free: %zu MB", huge_pages_ ? "on" : "off",
+              max_free_bytes_ >> 20);
+  ImGui::Text("Free: %.2f MB", static_cast<double>(FreeBytes()) / (1024.0 * 1024.0));
+  auto stats_text = [](const char* label, const Stats& stats) {
+    ImGui::Text("%s: %zu in use, %zu free, high water %zu, hits %lu, misses %lu", label,
+                stats.in_use, stats.free, stats.high_water, static_cast<unsigned long>(stats.hits),
+                static_cast<unsigned long>(stats.misses));
+  };
+  stats_text("Block arrays", GetBlockStats());
+  stats_text("LOD arrays", GetLODBlockStats());
+  stats_text("Chunks", GetChunkStats());
+}
+
+ChunkPool::BlockPool::~BlockPool() {
+  if (slabs_.empty()) {
+    for (void* p : free_) ::operator delete(p);
+  }
+  for (void* slab : slabs_) ::operator delete(slab, std::align_val_t{kSlabSize});
+}
+
+void ChunkPool::BlockPool::Configure(bool huge_pages, size_t max_free) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  max_free_ = max_free;
+  // slab blocks can't be freed one at a time, so only switch while nothing is allocated
+  if (stats_.misses == 0) huge_pages_ = huge_pages;
+}
+
+void ChunkPool::BlockPool::AllocateSlab() {
+  void* slab = ::operator new(kSlabSize, std::align_val_t{kSlabSize});
+  // transparent huge pages, elsewhere the slabs still cut down on allocations
+#ifdef __linux__
+  madvise(slab, kSlabSize, MADV_HUGEPAGE);
+#endif
+  slabs_.push_back(slab);
+  auto* bytes = static_cast<uint8_t*>(slab);
+  for (size_t offset = 0; offset + block_size_ <= kSlabSize; offset += block_size_) {
+    free_.push_back(bytes + offset);
+  }
+  stats_.free = free_.size();
+}
+
+void* ChunkPool::BlockPool::Allocate(size_t size) {
+  std::unique_lock<std::mutex> lock(mtx_);
+  if (block_size_ == 0) block_size_ = size;
+  if (size != block_size_) {
+    lock.unlock();
+    return ::operator new(size);
+  }
+  stats_.in_use++;
+  stats_.high_water = std::max(stats_.high_water, stats_.in_use);
+  if (free_.empty()) {
+    stats_.misses++;
+    if (!huge_pages_) {
+      lock.unlock();
+      return ::operator new(size);
+    }
+    AllocateSlab();
+  } else {
+    stats_.hits++;
+  }
+  void* p = free_.back();
+  free_.pop_back();
+  stats_.free = free_.size();
+  return p;
+}
+
+void ChunkPool::BlockPool::Deallocate(void* p, size_t size) {
+  std::unique_lock<std::mutex> lock(mtx_);
+  if (size != block_size_) {
+    lock.unlock();
+    ::operator delete(p);
+    return;
+  }
+  stats_.in_use--;
+  if (!huge_pages_ && free_.size() >= max_free_) {
+    lock.unlock();
+    ::operator delete(p);
+    return;
+  }
+  free_.push_back(p);
+  stats_.free = free_.size();
+}
+
+size_t ChunkPool::BlockPool::Trim() {
+  std::vector<void*> to_free;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (huge_pages_) return 0;
+    to_free.swap(free_);
+    stats_.free = 0;
+  }
+  for (void* p : to_free) ::operator delete(p);
+  return to_free.size() * block_size_;
+}
+
+ChunkPool::Stats ChunkPool::BlockPool::GetStats() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  Stats stats = stats_;
+  stats.block_size = block_size_;
+  return stats;
+}
+
+size_t ChunkPool::BlockPool::FreeBytes() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return free_.size() * block_size_;
+}
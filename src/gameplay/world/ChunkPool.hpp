@@ -0,0 +1,108 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json_fwd.hpp>
+
+#include "gameplay/world/ChunkDef.hpp"
+
+// Gives block arrays back to the chunk pool instead of freeing them.
+struct ChunkArrayDeleter {
+  void operator()(BlockTypeArray* blocks) const;
+  void operator()(BlockTypeArrayLOD1* blocks) const;
+};
+using BlockTypeArrayPtr = std::unique_ptr<BlockTypeArray, ChunkArrayDeleter>;
+using BlockTypeArrayLOD1Ptr = std::unique_ptr<BlockTypeArrayLOD1, ChunkArrayDeleter>;
+
+// Recycles chunk objects and block arrays. Moving loads and unloads thousands of chunks a second,
+// each with a 64 KiB block array and a LOD array, so unloaded ones wait here for the next chunks
+// instead of going back to malloc. Arrays are handed out zeroed. With huge pages on, arrays are
+// carved out of 2 MiB slabs advised as transparent huge pages on Linux, and the slabs are kept
+// until exit. Safe from any thread.
+class ChunkPool {
+ public:
+  static ChunkPool& Get();
+
+  // Only applies before the first allocation.
+  void LoadSettings(const nlohmann::json& j);
+  [[nodiscard]] nlohmann::json SaveSettings() const;
+
+  [[nodiscard]] BlockTypeArrayPtr AcquireBlocks();
+  [[nodiscard]] BlockTypeArrayLOD1Ptr AcquireLODBlocks();
+  // The chunk and its shared_ptr control block come from the pool.
+  [[nodiscard]] std::shared_ptr<Chunk> MakeChunk(const glm::ivec3& pos);
+
+  // Frees the free arrays and chunks that aren't in a slab. Returns the bytes freed.
+  size_t Trim();
+
+  struct Stats {
+    uint64_t hits{};
+    // allocations from the system, one per slab with huge pages
+    uint64_t misses{};
+    size_t in_use{};
+    size_t free{};
+    // most in use at once
+    size_t high_water{};
+    size_t block_size{};
+  };
+  [[nodiscard]] Stats GetBlockStats() const { return blocks_.GetStats(); }
+  [[nodiscard]] Stats GetLODBlockStats() const { return lod_blocks_.GetStats(); }
+  [[nodiscard]] Stats GetChunkStats() const { return chunks_.GetStats(); }
+  // bytes of the free blocks kept for reuse
+  [[nodiscard]] size_t FreeBytes() const;
+  void OnImGui() const;
+
+  // Allocates for std::allocate_shared from the chunk object pool.
+  template <typename T>
+  struct ChunkAllocator {
+    using value_type = T;
+    ChunkAllocator() = default;
+    template <typename U>
+    explicit ChunkAllocator(const ChunkAllocator<U>& /*other*/) {}
+    T* allocate(size_t n) { return static_cast<T*>(Get().chunks_.Allocate(n * sizeof(T))); }
+    void deallocate(T* p, size_t n) { Get().chunks_.Deallocate(p, n * sizeof(T)); }
+    template <typename U>
+    bool operator==(const ChunkAllocator<U>& /*other*/) const {
+      return true;
+    }
+  };
+
+ private:
+  friend struct ChunkArrayDeleter;
+  ChunkPool();
+
+  // Free list of fixed size blocks. The first allocation picks the block size when it isn't given,
+  // other sizes bypass the pool.
+  class BlockPool {
+   public:
+    explicit BlockPool(size_t block_size) : block_size_(block_size) {}
+    ~BlockPool();
+    BlockPool(const BlockPool&) = delete;
+    BlockPool& operator=(const BlockPool&) = delete;
+
+    void Configure(bool huge_pages, size_t max_free);
+    [[nodiscard]] void* Allocate(size_t size);
+    void Deallocate(void* p, size_t size);
+    size_t Trim();
+    [[nodiscard]] Stats GetStats() const;
+    [[nodiscard]] size_t FreeBytes() const;
+
+   private:
+    void AllocateSlab();
+    mutable std::mutex mtx_;
+    std::vector<void*> free_;
+    std::vector<void*> slabs_;
+    size_t block_size_;
+    size_t max_free_{0};
+    bool huge_pages_{false};
+    bool configured_{false};
+    Stats stats_;
+  };
+
+  BlockPool blocks_{sizeof(BlockTypeArray)};
+  BlockPool lod_blocks_{sizeof(BlockTypeArrayLOD1)};
+  BlockPool chunks_{0};
+  bool huge_pages_{false};
+  size_t max_free_bytes_{size_t{64} << 20};
+};
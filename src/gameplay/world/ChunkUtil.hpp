@@ -1,10 +1,19 @@
 #pragma once
 
-#include <glm/fwd.hpp>
+#include <glm/vec3.hpp>
+
+#include "gameplay/world/ChunkDef.hpp"
 
 namespace util::chunk {
 
-glm::ivec3 WorldToChunkPos(const glm::ivec3& world_pos);
-glm::ivec3 WorldToPosInChunk(const glm::ivec3& world_pos);
+inline glm::ivec3 WorldToChunkPos(const glm::ivec3& world_pos) {
+  return glm::ivec3{world_pos.x >> kChunkLengthShift, world_pos.y >> kChunkLengthShift,
+                    world_pos.z >> kChunkLengthShift};
+}
+
+inline glm::ivec3 WorldToPosInChunk(const glm::ivec3& world_pos) {
+  return glm::ivec3{world_pos.x & kChunkLengthM1, world_pos.y & kChunkLengthM1,
+                    world_pos.z & kChunkLengthM1};
+}
 
 }  // namespace util::chunk
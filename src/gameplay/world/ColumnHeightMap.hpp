@@ -0,0 +1,26 @@
+#pragma once
+
+#include "gameplay/world/ChunkDef.hpp"
+
+// Highest non-air y of each x, z cell of a chunk column, so sky light, raycasts and spawning
+// don't have to scan up to kMaxBlockHeight voxels per cell.
+class ColumnHeightMap {
+ public:
+  // height of a cell with no blocks
+  static constexpr int kEmpty = -1;
+
+  ColumnHeightMap() { heights_.fill(kEmpty); }
+
+  [[nodiscard]] inline int Get(int x, int z) const { return heights_[z * kChunkLength + x]; }
+  // Highest height of any cell. Can be higher than every cell after blocks are removed.
+  [[nodiscard]] inline int GetMax() const { return max_height_; }
+
+  inline void Set(int x, int z, int height) {
+    heights_[z * kChunkLength + x] = static_cast<int16_t>(height);
+    max_height_ = std::max(max_height_, height);
+  }
+
+ private:
+  std::array<int16_t, kChunkArea> heights_;
+  int max_height_{kEmpty};
+};
@@ -0,0 +1,127 @@
+#include "EvictedColumnCache.hpp"
+
+#include <imgui.h>
+
+#include <nlohmann/json.hpp>
+
+#include "application/Metrics.hpp"
+
+void EvictedColumnCache::LoadSettings(const nlohmann::json& j) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  max_columns_ = j.value("max_columns", max_columns_);
+}
+
+nlohmann::json EvictedColumnCache::SaveSettings() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return {{"max_columns", max_columns_}};
+}
+
+bool EvictedColumnCache::Enabled() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return max_columns_ > 0;
+}
+
+std::shared_ptr<EvictedColumnCache::Entry> EvictedColumnCache::Encode(const ChunkColumn& column,
+                                                                      uint64_t sequence) {
+  ZoneScoped;
+  auto entry = std::make_shared<Entry>();
+  for (int y = 0; y < kNumVerticalChunks; y++) {
+    entry->blocks[y] = column.chunks[y]->data.EncodeBlocks();
+  }
+  if (column.heights) entry->heights = std::make_unique<ColumnHeightMap>(*column.heights);
+  entry->sequence = sequence;
+  return entry;
+}
+
+std::unique_ptr<ColumnHeightMap> EvictedColumnCache::Decode(Entry& entry, ChunkColumn& column) {
+  ZoneScoped;
+  for (int y = 0; y < kNumVerticalChunks; y++) {
+    column.chunks[y]->data.DecodeBlocks(entry.blocks[y]);
+  }
+  return std::move(entry.heights);
+}
+
+void EvictedColumnCache::Insert(const glm::ivec2& pos, std::shared_ptr<Entry> entry) {
+  size_t bytes = sizeof(Node) + sizeof(Entry) + (entry->heights ? sizeof(ColumnHeightMap) : 0);
+  for (const auto& runs : entry->blocks) bytes += runs.capacity() * sizeof(uint32_t);
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (max_columns_ == 0) return;
+  if (auto it = index_.find(pos); it != index_.end()) {
+    if (it->second->entry->sequence > entry->sequence) return;
+    Remove(it->second);
+  }
+  lru_.push_front({pos, std::move(entry), bytes});
+  index_.emplace(pos, lru_.begin());
+  stats_.bytes += bytes;
+  while (lru_.size() > max_columns_) {
+    Remove(std::prev(lru_.end()));
+    stats_.evictions++;
+  }
+  stats_.columns = lru_.size();
+}
+
+std::shared_ptr<EvictedColumnCache::Entry> EvictedColumnCache::Take(const glm::ivec2& pos) {
+  auto& registry = MetricsRegistry::Get();
+  static auto& hits = registry.GetCounter("evicted_columns.hits");
+  static auto& misses = registry.GetCounter("evicted_columns.misses");
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (max_columns_ == 0) return nullptr;
+  auto it = index_.find(pos);
+  if (it == index_.end()) {
+    stats_.misses++;
+    misses.Add();
+    return nullptr;
+  }
+  stats_.hits++;
+  hits.Add();
+  std::shared_ptr<Entry> entry = std::move(it->second->entry);
+  Remove(it->second);
+  stats_.columns = lru_.size();
+  return entry;
+}
+
+size_t EvictedColumnCache::Clear() {
+  std::list<Node> to_free;
+  size_t bytes;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    to_free.swap(lru_);
+    index_.clear();
+    bytes = stats_.bytes;
+    stats_.bytes = 0;
+    stats_.columns = 0;
+  }
+  return bytes;
+}
+
+void EvictedColumnCache::Remove(std::list<Node>::iterator it) {
+  stats_.bytes -= it->bytes;
+  index_.erase(it->pos);
+  lru_.erase(it);
+}
+
+EvictedColumnCache::Stats EvictedColumnCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mtx_);
+  return stats_;
+}
+
+void EvictedColumnCache::OnImGui() {
+  if (!ImGui::CollapsingHeader("Evicted Columns##chunk_manager_evicted_columns")) return;
+  int max_columns;
+  {
+    std::lock_guard<std::mutex> lock(mtx_);
+    max_columns = static_cast<int>(max_columns_);
+  }
+  if (ImGui::SliderInt("Max Columns##evicted_columns", &max_columns, 0, 4096)) {
+    std::lock_guard<std::mutex> lock(mtx_);
+    max_columns_ = max_columns;
+  }
+  Stats stats = GetStats();
+  uint64_t lookups = stats.hits + stats.misses;
+  double hit_rate =
+      lookups ? 100.0 * static_cast<double>(stats.hits) / static_cast<double>(lookups) : 0.0;
+  ImGui::Text("Columns: %zu, %.2f MB", stats.columns,
+              static_cast<double>(stats.bytes) / (1024.0 * 1024.0));
+  ImGui::Text("Hit Rate: %.0f%% of %lu, Evictions: %lu", hit_rate,
+              static_cast<unsigned long>(lookups), static_cast<unsigned long>(stats.evictions));
+}
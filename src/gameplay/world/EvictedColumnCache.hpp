@@ -0,0 +1,68 @@
+#pragma once
+
+#include <list>
+#include <mutex>
+#include <nlohmann/json_fwd.hpp>
+
+#include "gameplay/world/ChunkColumn.hpp"
+
+#define GLM_ENABLE_EXPERIMENTAL
+
+#include <glm/gtx/hash.hpp>
+
+// Recently unloaded columns with their blocks run length encoded, so a column the player comes
+// back to skips terrain generation. Its light and meshes are still made again: the light depends on
+// the neighbors, and the renderer keeps no CPU copy of a mesh to restore. The column unloaded
+// longest ago is dropped first. Safe from any thread.
+class EvictedColumnCache {
+ public:
+  struct Entry {
+    std::array<std::vector<uint32_t>, kNumVerticalChunks> blocks;
+    std::unique_ptr<ColumnHeightMap> heights;
+    // order of the unloads, entries of the same column can be encoded out of order
+    uint64_t sequence{};
+  };
+
+  void LoadSettings(const nlohmann::json& j);
+  [[nodiscard]] nlohmann::json SaveSettings() const;
+  [[nodiscard]] bool Enabled() const;
+
+  // Encodes an unloaded column whose terrain is finished, off the main thread.
+  [[nodiscard]] static std::shared_ptr<Entry> Encode(const ChunkColumn& column, uint64_t sequence);
+  // Fills a new column's chunks and returns its heights, off the main thread. Moves out of entry.
+  [[nodiscard]] static std::unique_ptr<ColumnHeightMap> Decode(Entry& entry, ChunkColumn& column);
+
+  // Keeps whichever of entry and the column's current entry was unloaded last.
+  void Insert(const glm::ivec2& pos, std::shared_ptr<Entry> entry);
+  // Removes the column's entry and returns it, nullptr on a miss.
+  [[nodiscard]] std::shared_ptr<Entry> Take(const glm::ivec2& pos);
+  // Returns the bytes freed.
+  size_t Clear();
+
+  struct Stats {
+    uint64_t hits{};
+    uint64_t misses{};
+    // dropped to make room
+    uint64_t evictions{};
+    size_t columns{};
+    size_t bytes{};
+  };
+  [[nodiscard]] Stats GetStats() const;
+  void OnImGui();
+
+ private:
+  struct Node {
+    glm::ivec2 pos;
+    std::shared_ptr<Entry> entry;
+    size_t bytes;
+  };
+  void Remove(std::list<Node>::iterator it);
+
+  mutable std::mutex mtx_;
+  // most recently unloaded first
+  std::list<Node> lru_;
+  std::unordered_map<glm::ivec2, std::list<Node>::iterator> index_;
+  // 0 turns the cache off
+  size_t max_columns_{256};
+  Stats stats_;
+};
@@ -0,0 +1,123 @@
+#include "FrameBudget.hpp"
+
+#include <imgui.h>
+
+#include <nlohmann/json.hpp>
+
+#include "application/Metrics.hpp"
+
+namespace {
+
+constexpr const char* kPhaseNames[FrameBudget::kNumPhases] = {
+    "terrain", "terrain_finished", "light",         "light_finished",
+    "lit",     "mesh",             "mesh_finished", "immediate_remesh",
+};
+
+double ToMs(std::chrono::steady_clock::duration d) {
+  return std::chrono::duration<double, std::milli>(d).count();
+}
+
+}  // namespace
+
+void FrameBudget::LoadSettings(const nlohmann::json& j) {
+  settings.enabled = j.value("enabled", settings.enabled);
+  settings.target_frame_ms = j.value("target_frame_ms", settings.target_frame_ms);
+  settings.min_budget_ms = std::max(0.0, j.value("min_budget_ms", settings.min_budget_ms));
+  settings.max_budget_ms =
+      std::max(settings.min_budget_ms, j.value("max_budget_ms", settings.max_budget_ms));
+}
+
+nlohmann::json FrameBudget::SaveSettings() const {
+  return {{"enabled", settings.enabled},
+          {"target_frame_ms", settings.target_frame_ms},
+          {"min_budget_ms", settings.min_budget_ms},
+          {"max_budget_ms", settings.max_budget_ms}};
+}
+
+void FrameBudget::BeginFrame() {
+  Clock::time_point now = Clock::now();
+  if (last_frame_start_ != Clock::time_point{}) {
+    double other_ms = std::max(0.0, ToMs(now - last_frame_start_) - used_ms_);
+    // smoothed so one slow frame doesn't starve streaming for the next
+    other_ms_ += (other_ms - other_ms_) * 0.1;
+  }
+  last_frame_start_ = now;
+  frame_start_ = now;
+  budget_ms_ = std::clamp(settings.target_frame_ms - other_ms_, settings.min_budget_ms,
+                          settings.max_budget_ms);
+  phase_ = Phase::kCount;
+}
+
+void FrameBudget::BeginPhase(Phase phase) {
+  Clock::time_point now = Clock::now();
+  EndPhase(now);
+  phase_ = phase;
+  phase_start_ = now;
+  phase_items_ = 0;
+  double share = budget_ms_ / kNumPhases;
+  double remaining = budget_ms_ - ToMs(now - frame_start_);
+  // leave the phases after this one their share
+  auto later = static_cast<double>(kNumPhases - 1 - static_cast<size_t>(phase));
+  double allowance = std::max(share, remaining - share * later);
+  phase_deadline_ = now + std::chrono::duration_cast<Clock::duration>(
+                              std::chrono::duration<double, std::milli>(allowance));
+}
+
+void FrameBudget::EndPhase(Clock::time_point now) {
+  if (phase_ == Phase::kCount) return;
+  PhaseStats& stats = phase_stats_[static_cast<size_t>(phase_)];
+  stats.last_ms = ToMs(now - phase_start_);
+  stats.avg_ms += (stats.last_ms - stats.avg_ms) * 0.05;
+  phase_ = Phase::kCount;
+}
+
+void FrameBudget::EndFrame() {
+  Clock::time_point now = Clock::now();
+  EndPhase(now);
+  used_ms_ = ToMs(now - frame_start_);
+  if (used_ms_ > budget_ms_) frames_over_budget_++;
+
+  auto& registry = MetricsRegistry::Get();
+  static auto& budget_gauge = registry.GetGauge("frame_budget.budget_ms");
+  static auto& used_gauge = registry.GetGauge("frame_budget.used_ms");
+  static std::array<MetricGauge*, kNumPhases> phase_gauges = [&registry] {
+    std::array<MetricGauge*, kNumPhases> gauges{};
+    for (size_t i = 0; i < kNumPhases; i++) {
+      gauges[i] = &registry.GetGauge(std::string("frame_budget.") + kPhaseNames[i] + "_ms");
+    }
+    return gauges;
+  }();
+  budget_gauge.Set(budget_ms_);
+  used_gauge.Set(used_ms_);
+  for (size_t i = 0; i < kNumPhases; i++) phase_gauges[i]->Set(phase_stats_[i].last_ms);
+}
+
+bool FrameBudget::HasTime() {
+  if (!settings.enabled || phase_items_++ == 0) return true;
+  if (Clock::now() < phase_deadline_) return true;
+  // the caller stops here
+  if (phase_ != Phase::kCount) phase_stats_[static_cast<size_t>(phase_)].deferred++;
+  return false;
+}
+
+void FrameBudget::OnImGui() {
+  if (!ImGui::CollapsingHeader("Frame Budget##chunk_manager_frame_budget")) return;
+  ImGui::Checkbox("Enabled##frame_budget", &settings.enabled);
+  auto target_ms = static_cast<float>(settings.target_frame_ms);
+  if (ImGui::SliderFloat("Target Frame ms", &target_ms, 4.f, 50.f)) {
+    settings.target_frame_ms = target_ms;
+  }
+  auto max_ms = static_cast<float>(settings.max_budget_ms);
+  if (ImGui::SliderFloat("Max Budget ms", &max_ms, static_cast<float>(settings.min_budget_ms),
+                         20.f)) {
+    settings.max_budget_ms = max_ms;
+  }
+  ImGui::Text("Budget: %.2f ms, Used: %.2f ms, Rest of Frame: %.2f ms", budget_ms_, used_ms_,
+              other_ms_);
+  ImGui::Text("Frames Over Budget: %lu", static_cast<unsigned long>(frames_over_budget_));
+  for (size_t i = 0; i < kNumPhases; i++) {
+    const PhaseStats& stats = phase_stats_[i];
+    ImGui::Text("%s: %.3f ms (avg %.3f), deferred %lu", kPhaseNames[i], stats.last_ms,
+                stats.avg_ms, static_cast<unsigned long>(stats.deferred));
+  }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <nlohmann/json_fwd.hpp>
+
+// Bounds the main thread time of ChunkManager::Update. The budget is what's left of the target
+// frame time after the rest of the last frames, clamped to [min, max]. Update's phases run in
+// pipeline order and stop once their allowance runs out, leaving the rest queued for the next
+// frame. Each phase still to run keeps a fair share of the budget, so an early phase with a long
+// queue can't starve the later ones, and every phase handles at least one item a frame.
+class FrameBudget {
+ public:
+  enum class Phase : uint8_t {
+    kTerrain,
+    kTerrainFinished,
+    kLight,
+    kLightFinished,
+    kLit,
+    kMesh,
+    kMeshFinished,
+    kImmediateRemesh,
+    kCount,
+  };
+  static constexpr size_t kNumPhases = static_cast<size_t>(Phase::kCount);
+
+  struct Settings {
+    bool enabled{true};
+    double target_frame_ms{1000.0 / 60.0};
+    double min_budget_ms{1};
+    double max_budget_ms{8};
+  };
+  Settings settings;
+
+  void LoadSettings(const nlohmann::json& j);
+  [[nodiscard]] nlohmann::json SaveSettings() const;
+  // Call at the start of ChunkManager::Update. Measures the frame since the last call.
+  void BeginFrame();
+  // Ends the previous phase. Phases must begin in enum order.
+  void BeginPhase(Phase phase);
+  void EndFrame();
+  // True while the current phase may handle another item. Always true for its first item.
+  [[nodiscard]] bool HasTime();
+  [[nodiscard]] double GetBudgetMs() const { return budget_ms_; }
+  void OnImGui();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  void EndPhase(Clock::time_point now);
+
+  Clock::time_point frame_start_{};
+  Clock::time_point last_frame_start_{};
+  Clock::time_point phase_start_{};
+  Clock::time_point phase_deadline_{};
+  Phase phase_{Phase::kCount};
+  uint32_t phase_items_{};
+  double budget_ms_{};
+  double used_ms_{};
+  // the rest of the frame, smoothed
+  double other_ms_{};
+
+  struct PhaseStats {
+    double last_ms{};
+    double avg_ms{};
+    // frames the phase stopped with work left
+    uint64_t deferred{};
+  };
+  std::array<PhaseStats, kNumPhases> phase_stats_{};
+  uint64_t frames_over_budget_{};
+};
@@ -0,0 +1,354 @@
+#include "LightEngine.hpp"
+
+#include <glm/common.hpp>
+
+#include "gameplay/world/BlockDB.hpp"
+
+namespace {
+
+// light can't reach a column from further than this
+constexpr int kPadding = kMaxLightLevel;
+constexpr int kPaddedLength = kChunkLength + kPadding * 2;
+constexpr int kPaddedArea = kPaddedLength * kPaddedLength;
+constexpr int kPaddedVolume = kPaddedArea * kMaxBlockHeight;
+
+constexpr const int kFaceOffsets[6][3] = {{1, 0, 0},  {-1, 0, 0}, {0, 1, 0},
+                                          {0, -1, 0}, {0, 0, 1},  {0, 0, -1}};
+constexpr const int kDownFace = 3;
+
+enum class Channel { kSky, kBlock };
+
+inline uint8_t GetLevel(uint8_t light, Channel channel) {
+  return channel == Channel::kSky ? light::GetSky(light) : light::GetBlock(light);
+}
+
+inline uint8_t SetLevel(uint8_t light, uint8_t level, Channel channel) {
+  return channel == Channel::kSky ? light::Pack(level, light::GetBlock(light))
+                                  : light::Pack(light::GetSky(light), level);
+}
+
+// The loaded chunks of the 3x3 columns around an edit. Light from one block can't change
+// anything further away horizontally, and sky light can change the whole height of a column.
+class LightNeighborhood {
+ public:
+  LightNeighborhood(const ChunkMap& chunk_map, const glm::ivec3& center_world_pos)
+      : center_column_(center_world_pos.x >> kChunkLengthShift,
+                       center_world_pos.z >> kChunkLengthShift) {
+    min_.fill(glm::ivec3{kChunkLength});
+    max_.fill(glm::ivec3{-1});
+    glm::ivec3 chunk_pos;
+    for (chunk_pos.y = 0; chunk_pos.y < kNumVerticalChunks; chunk_pos.y++) {
+      for (int dz = 0; dz < 3; dz++) {
+        for (int dx = 0; dx < 3; dx++) {
+          chunk_pos.x = center_column_.x + dx - 1;
+          chunk_pos.z = center_column_.y + dz - 1;
+          chunk_map.find_fn(chunk_pos, [this, &chunk_pos, dx, dz](const std::shared_ptr<Chunk>& c) {
+            int slot = (chunk_pos.y * 3 + dz) * 3 + dx;
+            chunks_[slot] = c;
+            light_[slot] = c->data.GetLightArray();
+          });
+        }
+      }
+    }
+  }
+
+  // Returns -1 if the position isn't in a loaded chunk of the neighborhood.
+  [[nodiscard]] inline int Slot(const glm::ivec3& pos) const {
+    if (pos.y < 0 || pos.y >= kMaxBlockHeight) return -1;
+    int dx = (pos.x >> kChunkLengthShift) - center_column_.x + 1;
+    int dz = (pos.z >> kChunkLengthShift) - center_column_.y + 1;
+    if (dx < 0 || dx > 2 || dz < 0 || dz > 2) return -1;
+    int slot = ((pos.y >> kChunkLengthShift) * 3 + dz) * 3 + dx;
+    return chunks_[slot] ? slot : -1;
+  }
+
+  [[nodiscard]] inline BlockType GetBlock(int slot, const glm::ivec3& pos) const {
+    return chunks_[slot]->data.GetBlock(util::chunk::WorldToPosInChunk(pos));
+  }
+
+  [[nodiscard]] inline uint8_t GetLight(int slot, const glm::ivec3& pos) const {
+    int idx = ChunkData::GetIndex(util::chunk::WorldToPosInChunk(pos));
+    if (edited_[slot]) return (*edited_[slot])[idx];
+    return light_[slot] ? (*light_[slot])[idx] : kFullSkyLight;
+  }
+
+  // writes to a copy of the chunk's light array, published by Publish
+  inline void SetLight(int slot, const glm::ivec3& pos, uint8_t light) {
+    if (edited_[slot] == nullptr) {
+      edited_[slot] = std::make_shared<LightArray>();
+      if (light_[slot]) {
+        *edited_[slot] = *light_[slot];
+      } else {
+        edited_[slot]->fill(kFullSkyLight);
+      }
+    }
+    glm::ivec3 p = util::chunk::WorldToPosInChunk(pos);
+    (*edited_[slot])[ChunkData::GetIndex(p)] = light;
+    min_[slot] = glm::min(min_[slot], p);
+    max_[slot] = glm::max(max_[slot], p);
+  }
+
+  // Replaces the light arrays of the chunks that changed. Mesh jobs still reading the old ones
+  // keep them alive until they finish.
+  void Publish() {
+    for (size_t slot = 0; slot < chunks_.size(); slot++) {
+      if (edited_[slot]) chunks_[slot]->data.SetLightArray(std::move(edited_[slot]));
+    }
+  }
+
+  void GetChanges(std::vector<LightChangeBounds>& out) const {
+    for (size_t slot = 0; slot < chunks_.size(); slot++) {
+      if (max_[slot].x < 0) continue;
+      out.emplace_back(LightChangeBounds{chunks_[slot]->GetPos(), min_[slot], max_[slot]});
+    }
+  }
+
+ private:
+  static constexpr int kNumSlots = 9 * kNumVerticalChunks;
+  glm::ivec2 center_column_;
+  std::array<std::shared_ptr<Chunk>, kNumSlots> chunks_;
+  // the light arrays when the neighborhood was gathered, and the copies being edited
+  std::array<std::shared_ptr<const LightArray>, kNumSlots> light_;
+  std::array<std::shared_ptr<LightArray>, kNumSlots> edited_;
+  std::array<glm::ivec3, kNumSlots> min_;
+  std::array<glm::ivec3, kNumSlots> max_;
+};
+
+}  // namespace
+
+void LightEngine::SetBlockProps(std::vector<LightBlockProps> props) {
+  props_ = std::move(props);
+  has_emitters_ = std::any_of(props_.begin(), props_.end(),
+                              [](const LightBlockProps& p) { return p.emission > 0; });
+}
+
+std::vector<LightBlockProps> LightEngine::PropsFromBlockDB(const BlockDB& block_db) {
+  const auto& block_data = block_db.GetBlockData();
+  const auto& mesh_data = block_db.GetMeshData();
+  std::vector<LightBlockProps> props(block_data.size());
+  for (size_t i = 0; i < block_data.size(); i++) {
+    bool transparent = false;
+    if (i < mesh_data.size()) {
+      for (TransparencyType type : mesh_data[i].transparency_type) {
+        transparent = transparent || type != TransparencyType::kNone;
+      }
+    }
+    props[i].passes_light = i == 0 || transparent;
+    props[i].emission = block_data[i].emits_light ? kMaxLightLevel : 0;
+  }
+  return props;
+}
+
+void LightEngine::LightColumn(const ChunkMap& chunk_map, const glm::ivec2& column_pos,
+                              ColumnLightArrays& out) const {
+  ZoneScoped;
+  // reused between columns lit on the same thread
+  thread_local std::vector<BlockType> blocks;
+  thread_local std::vector<uint8_t> light;
+  thread_local std::vector<uint32_t> queue;
+  thread_local std::array<int, kPaddedArea> sky_start;
+
+  glm::ivec3 min{column_pos.x * kChunkLength - kPadding, 0, column_pos.y * kChunkLength - kPadding};
+  glm::ivec3 max{min.x + kPaddedLength - 1, kMaxBlockHeight - 1, min.z + kPaddedLength - 1};
+  blocks.resize(kPaddedVolume);
+  BlockAccessor(chunk_map).GetBlocks(min, max, blocks, kUnloadedBlock);
+  light.assign(kPaddedVolume, 0);
+  queue.clear();
+
+  // direct sky light down to the first block that stops it
+  for (int z = 0; z < kPaddedLength; z++) {
+    for (int x = 0; x < kPaddedLength; x++) {
+      int column = z * kPaddedLength + x;
+      int y = kMaxBlockHeight - 1;
+      while (y >= 0 && GetProps(blocks[y * kPaddedArea + column]).passes_light) {
+        light[y * kPaddedArea + column] = kFullSkyLight;
+        y--;
+      }
+      sky_start[column] = y + 1;
+    }
+  }
+
+  // only direct sky light next to a shorter neighbor column spreads anywhere new
+  for (int z = 0; z < kPaddedLength; z++) {
+    for (int x = 0; x < kPaddedLength; x++) {
+      int column = z * kPaddedLength + x;
+      int neighbor_max = sky_start[column];
+      if (x > 0) neighbor_max = std::max(neighbor_max, sky_start[column - 1]);
+      if (x < kPaddedLength - 1) neighbor_max = std::max(neighbor_max, sky_start[column + 1]);
+      if (z > 0) neighbor_max = std::max(neighbor_max, sky_start[column - kPaddedLength]);
+      if (z < kPaddedLength - 1) {
+        neighbor_max = std::max(neighbor_max, sky_start[column + kPaddedLength]);
+      }
+      for (int y = sky_start[column]; y < neighbor_max; y++) {
+        queue.emplace_back(y * kPaddedArea + column);
+      }
+    }
+  }
+
+  auto propagate = [this](Channel channel) {
+    for (size_t head = 0; head < queue.size(); head++) {
+      uint32_t idx = queue[head];
+      uint8_t level = GetLevel(light[idx], channel);
+      if (level <= 1) continue;
+      int x = idx % kPaddedLength;
+      int z = (idx / kPaddedLength) % kPaddedLength;
+      int y = idx / kPaddedArea;
+      for (int face = 0; face < 6; face++) {
+        int nx = x + kFaceOffsets[face][0];
+        int ny = y + kFaceOffsets[face][1];
+        int nz = z + kFaceOffsets[face][2];
+        if (nx < 0 || nx >= kPaddedLength || nz < 0 || nz >= kPaddedLength || ny < 0 ||
+            ny >= kMaxBlockHeight) {
+          continue;
+        }
+        uint32_t n_idx = ny * kPaddedArea + nz * kPaddedLength + nx;
+        if (!GetProps(blocks[n_idx]).passes_light) continue;
+        uint8_t new_level = channel == Channel::kSky && face == kDownFace && level == kMaxLightLevel
+                                ? kMaxLightLevel
+                                : level - 1;
+        if (GetLevel(light[n_idx], channel) >= new_level) continue;
+        light[n_idx] = SetLevel(light[n_idx], new_level, channel);
+        queue.emplace_back(n_idx);
+      }
+    }
+  };
+  propagate(Channel::kSky);
+
+  if (has_emitters_) {
+    queue.clear();
+    for (uint32_t idx = 0; idx < kPaddedVolume; idx++) {
+      uint8_t emission = GetProps(blocks[idx]).emission;
+      if (emission == 0) continue;
+      light[idx] = SetLevel(light[idx], emission, Channel::kBlock);
+      queue.emplace_back(idx);
+    }
+    propagate(Channel::kBlock);
+  }
+
+  // copy out the center column, leaving chunks that are all open sky without an array
+  for (int chunk_y = 0; chunk_y < kNumVerticalChunks; chunk_y++) {
+    out[chunk_y] = nullptr;
+    bool full_sky = true;
+    for (int y = chunk_y * kChunkLength; y < (chunk_y + 1) * kChunkLength && full_sky; y++) {
+      for (int z = kPadding; z < kPadding + kChunkLength && full_sky; z++) {
+        auto row = light.begin() + y * kPaddedArea + z * kPaddedLength + kPadding;
+        full_sky = std::all_of(row, row + kChunkLength,
+                               [](uint8_t l) { return l == kFullSkyLight; });
+      }
+    }
+    if (full_sky) continue;
+    auto chunk_light = std::make_shared<LightArray>();
+    for (int y = 0; y < kChunkLength; y++) {
+      for (int z = 0; z < kChunkLength; z++) {
+        auto row = light.begin() + (chunk_y * kChunkLength + y) * kPaddedArea +
+                   (z + kPadding) * kPaddedLength + kPadding;
+        std::copy_n(row, kChunkLength, chunk_light->begin() + ChunkData::GetIndex(0, y, z));
+      }
+    }
+    out[chunk_y] = std::move(chunk_light);
+  }
+}
+
+void LightEngine::UpdateBlock(const ChunkMap& chunk_map, const glm::ivec3& world_pos,
+                              BlockType old_block,
+                              std::vector<LightChangeBounds>& out_changes) const {
+  ZoneScoped;
+  LightNeighborhood neighborhood(chunk_map, world_pos);
+  int slot = neighborhood.Slot(world_pos);
+  if (slot < 0) return;
+  const LightBlockProps& new_props = GetProps(neighborhood.GetBlock(slot, world_pos));
+  const LightBlockProps& old_props = GetProps(old_block);
+  if (new_props.passes_light == old_props.passes_light &&
+      new_props.emission == old_props.emission) {
+    return;
+  }
+
+  struct RemoveNode {
+    glm::ivec3 pos;
+    uint8_t level;
+  };
+  std::vector<RemoveNode> remove_queue;
+  std::vector<glm::ivec3> add_queue;
+  for (Channel channel : {Channel::kBlock, Channel::kSky}) {
+    remove_queue.clear();
+    add_queue.clear();
+
+    // take out the light at the changed block and everything that depended on it. Neighbors lit
+    // from elsewhere spread back in afterwards.
+    uint8_t curr_light = neighborhood.GetLight(slot, world_pos);
+    if (uint8_t old_level = GetLevel(curr_light, channel); old_level > 0) {
+      neighborhood.SetLight(slot, world_pos, SetLevel(curr_light, 0, channel));
+      remove_queue.emplace_back(RemoveNode{world_pos, old_level});
+    }
+    for (size_t head = 0; head < remove_queue.size(); head++) {
+      RemoveNode node = remove_queue[head];
+      for (int face = 0; face < 6; face++) {
+        glm::ivec3 n{node.pos.x + kFaceOffsets[face][0], node.pos.y + kFaceOffsets[face][1],
+                     node.pos.z + kFaceOffsets[face][2]};
+        int n_slot = neighborhood.Slot(n);
+        if (n_slot < 0) continue;
+        uint8_t n_light = neighborhood.GetLight(n_slot, n);
+        uint8_t n_level = GetLevel(n_light, channel);
+        if (n_level == 0) continue;
+        bool dependent = n_level < node.level ||
+                         (channel == Channel::kSky && face == kDownFace &&
+                          node.level == kMaxLightLevel && n_level == kMaxLightLevel);
+        if (!dependent) {
+          add_queue.emplace_back(n);
+          continue;
+        }
+        neighborhood.SetLight(n_slot, n, SetLevel(n_light, 0, channel));
+        remove_queue.emplace_back(RemoveNode{n, n_level});
+        if (channel == Channel::kBlock) {
+          if (uint8_t emission = GetProps(neighborhood.GetBlock(n_slot, n)).emission; emission) {
+            neighborhood.SetLight(n_slot, n, SetLevel(n_light, emission, channel));
+            add_queue.emplace_back(n);
+          }
+        }
+      }
+    }
+
+    if (new_props.passes_light) {
+      for (const auto& off : kFaceOffsets) {
+        glm::ivec3 n{world_pos.x + off[0], world_pos.y + off[1], world_pos.z + off[2]};
+        int n_slot = neighborhood.Slot(n);
+        if (n_slot >= 0 && GetLevel(neighborhood.GetLight(n_slot, n), channel) > 0) {
+          add_queue.emplace_back(n);
+        }
+      }
+      if (channel == Channel::kSky && world_pos.y == kMaxBlockHeight - 1) {
+        neighborhood.SetLight(slot, world_pos,
+                              SetLevel(neighborhood.GetLight(slot, world_pos), kMaxLightLevel,
+                                       channel));
+        add_queue.emplace_back(world_pos);
+      }
+    }
+    if (channel == Channel::kBlock && new_props.emission > 0) {
+      neighborhood.SetLight(slot, world_pos,
+                            SetLevel(neighborhood.GetLight(slot, world_pos), new_props.emission,
+                                     channel));
+      add_queue.emplace_back(world_pos);
+    }
+
+    for (size_t head = 0; head < add_queue.size(); head++) {
+      glm::ivec3 pos = add_queue[head];
+      uint8_t level = GetLevel(neighborhood.GetLight(neighborhood.Slot(pos), pos), channel);
+      if (level <= 1) continue;
+      for (int face = 0; face < 6; face++) {
+        glm::ivec3 n{pos.x + kFaceOffsets[face][0], pos.y + kFaceOffsets[face][1],
+                     pos.z + kFaceOffsets[face][2]};
+        int n_slot = neighborhood.Slot(n);
+        if (n_slot < 0 || !GetProps(neighborhood.GetBlock(n_slot, n)).passes_light) continue;
+        uint8_t new_level = channel == Channel::kSky && face == kDownFace && level == kMaxLightLevel
+                                ? kMaxLightLevel
+                                : level - 1;
+        uint8_t n_light = neighborhood.GetLight(n_slot, n);
+        if (GetLevel(n_light, channel) >= new_level) continue;
+        neighborhood.SetLight(n_slot, n, SetLevel(n_light, new_level, channel));
+        add_queue.emplace_back(n);
+      }
+    }
+  }
+  neighborhood.Publish();
+  neighborhood.GetChanges(out_changes);
+}
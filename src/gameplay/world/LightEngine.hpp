@@ -0,0 +1,60 @@
+#pragma once
+
+#include "gameplay/world/BlockAccessor.hpp"
+#include "gameplay/world/ChunkDef.hpp"
+
+class BlockDB;
+
+namespace light {
+
+inline uint8_t GetSky(uint8_t light) { return light >> 4; }
+inline uint8_t GetBlock(uint8_t light) { return light & 0xF; }
+inline uint8_t Pack(uint8_t sky, uint8_t block) { return sky << 4 | block; }
+
+}  // namespace light
+
+struct LightBlockProps {
+  bool passes_light{false};
+  uint8_t emission{0};
+};
+
+// Bounds within a chunk of light changed by an update, for remeshing.
+struct LightChangeBounds {
+  glm::ivec3 chunk_pos;
+  glm::ivec3 min;
+  glm::ivec3 max;
+};
+
+using ColumnLightArrays = std::array<std::shared_ptr<const LightArray>, kNumVerticalChunks>;
+
+// BFS sky and block light. Sky light at kMaxLightLevel travels straight down without falling
+// off, everything else loses a level per block. Needs only a chunk map, no renderer.
+class LightEngine {
+ public:
+  // Block ids not covered by props, like the unloaded block, block light.
+  void SetBlockProps(std::vector<LightBlockProps> props);
+  // Air and blocks with any transparent face pass light, emits_light blocks emit the max level.
+  static std::vector<LightBlockProps> PropsFromBlockDB(const BlockDB& block_db);
+  static constexpr BlockType kUnloadedBlock = std::numeric_limits<BlockType>::max();
+
+  // Lights the chunks of a column from the blocks within kMaxLightLevel of it, which is all the
+  // light can reach it from, so it doesn't depend on neighbor light and columns can be lit on
+  // any thread in parallel. Only reads the chunk map. Chunks left fully sky lit get no array.
+  void LightColumn(const ChunkMap& chunk_map, const glm::ivec2& column_pos,
+                   ColumnLightArrays& out) const;
+
+  // Relights around a block that was just set. The changed light arrays of the loaded chunks
+  // around it are copied and replaced, never written in place, since mesh jobs may be reading
+  // them. Call from the thread that edits blocks.
+  void UpdateBlock(const ChunkMap& chunk_map, const glm::ivec3& world_pos, BlockType old_block,
+                   std::vector<LightChangeBounds>& out_changes) const;
+
+ private:
+  std::vector<LightBlockProps> props_;
+  bool has_emitters_{false};
+
+  [[nodiscard]] inline const LightBlockProps& GetProps(BlockType block) const {
+    static constexpr LightBlockProps kOpaque{};
+    return block < props_.size() ? props_[block] : kOpaque;
+  }
+};
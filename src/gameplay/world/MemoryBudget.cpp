@@ -0,0 +1,135 @@
+#include "MemoryBudget.hpp"
+
+#include <imgui.h>
+
+#include <nlohmann/json.hpp>
+
+#include "application/Metrics.hpp"
+#include "gameplay/world/ChunkManager.hpp"
+#include "gameplay/world/ChunkPool.hpp"
+
+void MemoryBudget::LoadSettings(const nlohmann::json& j) {
+  settings.enabled = j.value("enabled", settings.enabled);
+  settings.world_budget_bytes =
+      j.value("world_budget_mb", settings.world_budget_bytes >> 20) << 20;
+  settings.high_watermark = j.value("high_watermark", settings.high_watermark);
+  settings.low_watermark =
+      std::min(j.value("low_watermark", settings.low_watermark), settings.high_watermark);
+  settings.interval_seconds = j.value("interval_seconds", settings.interval_seconds);
+  settings.grow_delay_seconds = j.value("grow_delay_seconds", settings.grow_delay_seconds);
+  settings.min_load_distance = std::max(1, j.value("min_load_distance", settings.min_load_distance));
+  settings.min_lod_1_load_distance =
+      std::max(0, j.value("min_lod_1_load_distance", settings.min_lod_1_load_distance));
+}
+
+nlohmann::json MemoryBudget::SaveSettings() const {
+  return {{"enabled", settings.enabled},
+          {"world_budget_mb", settings.world_budget_bytes >> 20},
+          {"high_watermark", settings.high_watermark},
+          {"low_watermark", settings.low_watermark},
+          {"interval_seconds", settings.interval_seconds},
+          {"grow_delay_seconds", settings.grow_delay_seconds},
+          {"min_load_distance", settings.min_load_distance},
+          {"min_lod_1_load_distance", settings.min_lod_1_load_distance}};
+}
+
+void MemoryBudget::SetTargets(int load_distance, int lod_1_load_distance) {
+  target_load_distance_ = load_distance;
+  target_lod_1_load_distance_ = lod_1_load_distance;
+}
+
+void MemoryBudget::Update(ChunkManager& chunk_manager, const ChunkMeshSink& mesh_sink) {
+  if (!settings.enabled || interval_timer_.ElapsedSeconds() < settings.interval_seconds) return;
+  ZoneScoped;
+  interval_timer_.Reset();
+
+  ChunkManager::MemoryUsage usage = chunk_manager.GetMemoryUsage();
+  world_bytes_ = usage.Total();
+  world_ratio_ = settings.world_budget_bytes
+                     ? static_cast<float>(static_cast<double>(world_bytes_) /
+                                          static_cast<double>(settings.world_budget_bytes))
+                     : 0.f;
+  ChunkMeshSink::MeshBufferUsage mesh_usage = mesh_sink.GetMeshBufferUsage();
+  mesh_occupancy_ = mesh_usage.occupancy;
+  bool new_failures = mesh_usage.failed_allocs > last_failed_allocs_;
+  last_failed_allocs_ = mesh_usage.failed_allocs;
+
+  auto& registry = MetricsRegistry::Get();
+  static auto& world_bytes_gauge = registry.GetGauge("memory.world_bytes");
+  static auto& mesh_occupancy_gauge = registry.GetGauge("memory.mesh_buffer_occupancy");
+  static auto& load_distance_gauge = registry.GetGauge("budget.load_distance");
+  static auto& lod_1_load_distance_gauge = registry.GetGauge("budget.lod_1_load_distance");
+  world_bytes_gauge.Set(static_cast<double>(world_bytes_));
+  mesh_occupancy_gauge.Set(mesh_occupancy_);
+
+  int load_distance = chunk_manager.GetLoadDistance();
+  int lod_1_load_distance = chunk_manager.GetLOD1LoadDistance();
+  bool world_pressure = world_ratio_ > settings.high_watermark;
+  // free the pooled arrays and cached evicted columns before unloading anything, the next
+  // measurement shows if it was enough
+  if (world_pressure && usage.pooled > 0 && ChunkPool::Get().Trim() > 0) world_pressure = false;
+  if (world_pressure && usage.evicted_columns > 0 && chunk_manager.TrimEvictedColumns() > 0) {
+    world_pressure = false;
+  }
+  bool mesh_pressure = new_failures || mesh_occupancy_ > settings.high_watermark;
+  at_minimum_ = false;
+  if (world_pressure || mesh_pressure) {
+    if (mesh_pressure && !world_pressure && lod_1_load_distance > settings.min_lod_1_load_distance) {
+      chunk_manager.SetLOD1LoadDistance(lod_1_load_distance - 1);
+    } else if (load_distance > settings.min_load_distance) {
+      chunk_manager.SetLoadDistance(load_distance - 1);
+    } else {
+      at_minimum_ = true;
+    }
+    if (!at_minimum_) {
+      num_shrinks_++;
+      since_shrink_timer_.Reset();
+      spdlog::warn(
+          "memory budget: world {:.0f}%, mesh buffers {:.0f}%{}, load distance {} -> {}, LOD 1 "
+          "distance {} -> {}",
+          world_ratio_ * 100, mesh_occupancy_ * 100, new_failures ? " with failed allocations" : "",
+          load_distance, chunk_manager.GetLoadDistance(), lod_1_load_distance,
+          chunk_manager.GetLOD1LoadDistance());
+    }
+  } else if (world_ratio_ < settings.low_watermark && mesh_occupancy_ < settings.low_watermark &&
+             since_shrink_timer_.ElapsedSeconds() > settings.grow_delay_seconds) {
+    if (load_distance < target_load_distance_) {
+      // only grow if the extra ring of columns is projected to stay under the high watermark
+      size_t num_columns = std::max<size_t>(usage.num_chunks / kNumVerticalChunks, 1);
+      double bytes_per_column = static_cast<double>(world_bytes_) / static_cast<double>(num_columns);
+      double projected = static_cast<double>(world_bytes_) + bytes_per_column * 8 * (load_distance + 1);
+      if (!settings.world_budget_bytes ||
+          projected < settings.high_watermark * static_cast<double>(settings.world_budget_bytes)) {
+        chunk_manager.SetLoadDistance(load_distance + 1);
+        num_grows_++;
+      }
+    } else if (lod_1_load_distance < std::min(target_lod_1_load_distance_, load_distance)) {
+      chunk_manager.SetLOD1LoadDistance(lod_1_load_distance + 1);
+      num_grows_++;
+    }
+  }
+
+  // space was freed or never ran out, either way the failed uploads can try again
+  if (!mesh_pressure && chunk_manager.NumFailedMeshAllocs() > 0) {
+    chunk_manager.RetryFailedMeshAllocs();
+  }
+  load_distance_gauge.Set(chunk_manager.GetLoadDistance());
+  lod_1_load_distance_gauge.Set(chunk_manager.GetLOD1LoadDistance());
+}
+
+void MemoryBudget::OnImGui() {
+  if (!ImGui::CollapsingHeader("Memory Budget##chunk_manager_memory_budget")) return;
+  ImGui::Checkbox("Enabled##memory_budget", &settings.enabled);
+  auto budget_mb = static_cast<int>(settings.world_budget_bytes >> 20);
+  if (ImGui::SliderInt("World Budget MB", &budget_mb, 0, 65536)) {
+    settings.world_budget_bytes = static_cast<size_t>(budget_mb) << 20;
+  }
+  ImGui::SliderFloat("High Watermark", &settings.high_watermark, 0.1f, 1.f);
+  ImGui::SliderFloat("Low Watermark", &settings.low_watermark, 0.f, settings.high_watermark);
+  ImGui::Text("World: %.2f MB (%.0f%%)", static_cast<double>(world_bytes_) / (1024.0 * 1024.0),
+              world_ratio_ * 100.f);
+  ImGui::Text("Mesh buffers: %.0f%%", mesh_occupancy_ * 100.f);
+  ImGui::Text("Targets: load %d, LOD 1 %d", target_load_distance_, target_lod_1_load_distance_);
+  ImGui::Text("Shrinks: %u, Grows: %u", num_shrinks_, num_grows_);
+  if (at_minimum_) ImGui::TextColored(ImVec4(1, 0.3f, 0.3f, 1), "Over budget at minimum distances");
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <nlohmann/json_fwd.hpp>
+
+#include "util/Timer.hpp"
+
+class ChunkManager;
+class ChunkMeshSink;
+
+// Keeps the resident world under a byte budget and the chunk mesh buffers under a high watermark.
+// Under pressure it trims one ring at a time: the LOD 1 ring first when the mesh buffers fill, since
+// regular meshes take the most buffer space, and the load distance when the world is too large or
+// the LOD ring can't shrink further, which unloads the farthest columns. Once both drop below the
+// low watermark for a while it grows back one ring at a time toward the configured distances.
+class MemoryBudget {
+ public:
+  struct Settings {
+    bool enabled{true};
+    // block, LOD and light arrays, height maps, meshes in flight, map overhead, pooled arrays and
+    // cached evicted columns. 0 is unbounded.
+    size_t world_budget_bytes{size_t{4096} << 20};
+    float high_watermark{0.9f};
+    float low_watermark{0.7f};
+    double interval_seconds{1};
+    // time after the last shrink before growing again, so it doesn't oscillate
+    double grow_delay_seconds{5};
+    int min_load_distance{4};
+    int min_lod_1_load_distance{2};
+  };
+  Settings settings;
+
+  void LoadSettings(const nlohmann::json& j);
+  [[nodiscard]] nlohmann::json SaveSettings() const;
+  // The distances to grow back to.
+  void SetTargets(int load_distance, int lod_1_load_distance);
+  [[nodiscard]] int GetTargetLoadDistance() const { return target_load_distance_; }
+  [[nodiscard]] int GetTargetLOD1LoadDistance() const { return target_lod_1_load_distance_; }
+  // Call once per ChunkManager::Update. Measures and adjusts at most once per interval.
+  void Update(ChunkManager& chunk_manager, const ChunkMeshSink& mesh_sink);
+  void OnImGui();
+
+ private:
+  int target_load_distance_{};
+  int target_lod_1_load_distance_{};
+  Timer interval_timer_;
+  Timer since_shrink_timer_;
+  uint64_t last_failed_allocs_{};
+
+  // last measurement, for the panel
+  size_t world_bytes_{};
+  float world_ratio_{};
+  float mesh_occupancy_{};
+  uint32_t num_shrinks_{};
+  uint32_t num_grows_{};
+  bool at_minimum_{false};
+};
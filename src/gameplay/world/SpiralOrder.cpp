@@ -0,0 +1,51 @@
+#include "SpiralOrder.hpp"
+
+namespace util::spiral {
+
+namespace {
+
+std::vector<glm::i16vec2> BuildTable() {
+  ZoneScoped;
+  std::vector<glm::i16vec2> offsets;
+  offsets.reserve(NumPositions(kMaxRadius));
+  constexpr int kDx[] = {1, 0, -1, 0};
+  constexpr int kDy[] = {0, 1, 0, -1};
+  int direction = 0;
+  int step_radius = 1;
+  int direction_steps_counter = 0;
+  int turn_counter = 0;
+  glm::ivec2 pos{0};
+  for (int i = 0; i < NumPositions(kMaxRadius); i++) {
+    offsets.emplace_back(pos);
+    // branchless iterate
+    direction_steps_counter++;
+    pos.x += kDx[direction];
+    pos.y += kDy[direction];
+    bool change_dir = direction_steps_counter == step_radius;
+    direction = (direction + change_dir) % 4;
+    direction_steps_counter *= !change_dir;
+    turn_counter += change_dir;
+    step_radius += change_dir * (1 - (turn_counter % 2));
+  }
+  return offsets;
+}
+
+const std::vector<glm::i16vec2>& Table() {
+  static const std::vector<glm::i16vec2> table = BuildTable();
+  return table;
+}
+
+}  // namespace
+
+std::span<const glm::i16vec2> Offsets(int radius) {
+  EASSERT_MSG(radius >= 0 && radius <= kMaxRadius, "Spiral radius out of range");
+  return std::span<const glm::i16vec2>(Table()).first(NumPositions(radius));
+}
+
+std::span<const glm::i16vec2> Ring(int radius) {
+  EASSERT_MSG(radius >= 0 && radius <= kMaxRadius, "Spiral radius out of range");
+  int begin = radius == 0 ? 0 : NumPositions(radius - 1);
+  return std::span<const glm::i16vec2>(Table()).subspan(begin, NumPositions(radius) - begin);
+}
+
+}  // namespace util::spiral
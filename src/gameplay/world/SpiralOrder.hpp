@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glm/gtc/type_precision.hpp>
+#include <glm/vec2.hpp>
+
+// The clockwise spiral chunk columns are visited in: the center, then each square ring outward.
+// The first (2r + 1)^2 offsets are exactly the square of radius r, so iterating a radius or a ring
+// is a slice of one table built once instead of walking the spiral again.
+namespace util::spiral {
+
+// twice the max load distance, AddNewChunks spirals from up to the load distance off center
+constexpr int kMaxRadius = 128;
+
+[[nodiscard]] constexpr int NumPositions(int radius) { return (radius * 2 + 1) * (radius * 2 + 1); }
+
+// offsets within radius of the center, in spiral order
+[[nodiscard]] std::span<const glm::i16vec2> Offsets(int radius);
+// offsets exactly radius from the center, in spiral order
+[[nodiscard]] std::span<const glm::i16vec2> Ring(int radius);
+
+template <typename Fn>
+void ForEach(const glm::ivec2& center, int radius, Fn&& fn) {
+  for (const glm::i16vec2& offset : Offsets(radius)) fn(center + glm::ivec2(offset));
+}
+
+// Calls fn with the positions within radius of center that weren't within radius of prev_center,
+// the ones a move exposed. Swap the centers for the ones it left behind. Row by row, so it costs
+// the positions visited rather than the whole square.
+template <typename Fn>
+void ForEachFrontier(const glm::ivec2& center, const glm::ivec2& prev_center, int radius, Fn&& fn) {
+  for (int x = center.x - radius; x <= center.x + radius; x++) {
+    if (std::abs(x - prev_center.x) > radius) {
+      for (int z = center.y - radius; z <= center.y + radius; z++) fn(glm::ivec2{x, z});
+      continue;
+    }
+    // only the rows past prev_center's square on either side
+    for (int z = center.y - radius; z <= std::min(center.y + radius, prev_center.y - radius - 1);
+         z++) {
+      fn(glm::ivec2{x, z});
+    }
+    for (int z = std::max(center.y - radius, prev_center.y + radius + 1); z <= center.y + radius;
+         z++) {
+      fn(glm::ivec2{x, z});
+    }
+  }
+}
+
+}  // namespace util::spiral
@@ -0,0 +1,112 @@
+#include "StreamPredictor.hpp"
+
+#include <imgui.h>
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <nlohmann/json.hpp>
+
+#include "application/Metrics.hpp"
+#include "gameplay/world/ChunkUtil.hpp"
+
+namespace {
+
+// seconds for the smoothed velocity to mostly catch up with a change
+constexpr double kVelocitySmoothingSeconds = 0.25;
+// moving farther in one update is a teleport
+constexpr float kMaxStep = kChunkLength * 4;
+
+glm::ivec2 ToColumn(const glm::vec3& world_pos) {
+  glm::ivec3 chunk_pos = util::chunk::WorldToChunkPos(glm::ivec3(glm::floor(world_pos)));
+  return {chunk_pos.x, chunk_pos.z};
+}
+
+}  // namespace
+
+void StreamPredictor::LoadSettings(const nlohmann::json& j) {
+  settings.enabled = j.value("enabled", settings.enabled);
+  settings.lookahead_seconds =
+      std::max(0.0, j.value("lookahead_seconds", settings.lookahead_seconds));
+  settings.min_speed = j.value("min_speed", settings.min_speed);
+  settings.heading_weight =
+      std::clamp(j.value("heading_weight", settings.heading_weight), 0.f, 1.f);
+}
+
+nlohmann::json StreamPredictor::SaveSettings() const {
+  return {{"enabled", settings.enabled},
+          {"lookahead_seconds", settings.lookahead_seconds},
+          {"min_speed", settings.min_speed},
+          {"heading_weight", settings.heading_weight}};
+}
+
+void StreamPredictor::Update(const glm::vec3& world_pos, double dt) {
+  auto& registry = MetricsRegistry::Get();
+  static auto& predictions = registry.GetCounter("stream.predictions");
+  static auto& prediction_hits = registry.GetCounter("stream.prediction_hits");
+  time_ += dt;
+  center_column_ = ToColumn(world_pos);
+  glm::vec3 step = world_pos - last_pos_;
+  if (!has_last_pos_ || glm::length(step) > kMaxStep) {
+    // where the player was heading before a teleport says nothing about after
+    velocity_ = glm::vec3{0};
+    pending_.clear();
+  } else if (dt > 0) {
+    auto alpha = static_cast<float>(1.0 - std::exp(-dt / kVelocitySmoothingSeconds));
+    velocity_ += (step / static_cast<float>(dt) - velocity_) * alpha;
+  }
+  last_pos_ = world_pos;
+  has_last_pos_ = true;
+
+  while (!pending_.empty() && pending_.front().due_time <= time_) {
+    glm::ivec2 diff = glm::abs(pending_.front().column - center_column_);
+    num_predictions_++;
+    predictions.Add();
+    if (std::max(diff.x, diff.y) <= 1) {
+      num_hits_++;
+      prediction_hits.Add();
+    }
+    pending_.pop_front();
+  }
+
+  predicted_column_ = center_column_;
+  glm::vec2 velocity_xz{velocity_.x, velocity_.z};
+  float speed = glm::length(velocity_xz);
+  if (!settings.enabled || settings.lookahead_seconds <= 0 || speed < settings.min_speed) return;
+  glm::vec2 dir = velocity_xz / speed;
+  glm::vec2 heading_xz{heading_.x, heading_.z};
+  // nothing to go on looking straight up or down
+  if (glm::length(heading_xz) > 0.01f) {
+    glm::vec2 bent = glm::mix(dir, glm::normalize(heading_xz), settings.heading_weight);
+    // looking straight back cancels out, keep the direction of travel then
+    if (glm::length(bent) > 0.01f) dir = glm::normalize(bent);
+  }
+  glm::vec2 offset = dir * speed * static_cast<float>(settings.lookahead_seconds);
+  predicted_column_ = ToColumn(world_pos + glm::vec3{offset.x, 0, offset.y});
+  pending_.push_back({time_ + settings.lookahead_seconds, predicted_column_});
+}
+
+glm::ivec2 StreamPredictor::GetPredictedColumn(const glm::ivec2& center, int max_offset) const {
+  return center + glm::clamp(predicted_column_ - center_column_, -max_offset, max_offset);
+}
+
+float StreamPredictor::GetHitRate() const {
+  return num_predictions_ ? static_cast<float>(static_cast<double>(num_hits_) /
+                                               static_cast<double>(num_predictions_))
+                          : 0.f;
+}
+
+void StreamPredictor::OnImGui() {
+  if (!ImGui::CollapsingHeader("Stream Prediction##chunk_manager_stream_prediction")) return;
+  ImGui::Checkbox("Enabled##stream_prediction", &settings.enabled);
+  auto lookahead = static_cast<float>(settings.lookahead_seconds);
+  if (ImGui::SliderFloat("Lookahead Seconds", &lookahead, 0.f, 5.f)) {
+    settings.lookahead_seconds = lookahead;
+  }
+  ImGui::SliderFloat("Min Speed", &settings.min_speed, 0.f, 100.f);
+  ImGui::SliderFloat("Heading Weight", &settings.heading_weight, 0.f, 1.f);
+  glm::ivec2 offset = predicted_column_ - center_column_;
+  ImGui::Text("Speed: %.1f, Predicted Offset: %i %i",
+              glm::length(glm::vec2{velocity_.x, velocity_.z}), offset.x, offset.y);
+  ImGui::Text("Hit Rate: %.0f%% of %lu", GetHitRate() * 100.f,
+              static_cast<unsigned long>(num_predictions_));
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <deque>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <nlohmann/json_fwd.hpp>
+
+// Predicts where the player will be a little ahead of time from how the center has moved and where
+// the camera faces, so the chunk manager can queue the columns on the way first. It only changes
+// the order columns the load square already wants are queued in, never how many. Each prediction
+// is checked against the center once its time comes, for the hit rate.
+class StreamPredictor {
+ public:
+  struct Settings {
+    bool enabled{true};
+    // how far ahead to predict, 0 predicts nothing
+    double lookahead_seconds{1};
+    // in blocks a second, slower than this loading stays centered on the player
+    float min_speed{8.f};
+    // how much the camera heading bends the direction of travel, 0 to 1
+    float heading_weight{0.25f};
+  };
+  Settings settings;
+
+  void LoadSettings(const nlohmann::json& j);
+  [[nodiscard]] nlohmann::json SaveSettings() const;
+  // The camera front, optional.
+  void SetHeading(const glm::vec3& front) { heading_ = front; }
+  // Call once per ChunkManager::Update with the position the center was set from.
+  void Update(const glm::vec3& world_pos, double dt);
+  // The column to queue loading around, at most max_offset columns from center on either axis.
+  // center when there's no prediction.
+  [[nodiscard]] glm::ivec2 GetPredictedColumn(const glm::ivec2& center, int max_offset) const;
+  // predictions whose time came and the center column was within one column of the prediction
+  [[nodiscard]] float GetHitRate() const;
+  void OnImGui();
+
+ private:
+  struct Prediction {
+    double due_time;
+    glm::ivec2 column;
+  };
+  std::deque<Prediction> pending_;
+  glm::vec3 heading_{0};
+  glm::vec3 last_pos_{0};
+  glm::vec3 velocity_{0};
+  glm::ivec2 center_column_{0};
+  glm::ivec2 predicted_column_{0};
+  double time_{0};
+  bool has_last_pos_{false};
+  uint64_t num_predictions_{};
+  uint64_t num_hits_{};
+};
@@ -21,6 +21,10 @@ BlockType BiomeLayer::GetBlock(float rand_neg_1_to_1) const {
 }
 
 void Terrain::Load(const BlockDB& block_db) {
+  if (const Terrain* bundled = block_db.GetBundledTerrain()) {
+    *this = *bundled;
+    return;
+  }
   biome_frequencies.clear();
   biomes.clear();
 
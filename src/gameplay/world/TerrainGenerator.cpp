@@ -8,6 +8,7 @@
 #include "EAssert.hpp"
 #include "gameplay/world/Chunk.hpp"
 #include "gameplay/world/ChunkDef.hpp"
+#include "gameplay/world/ColumnHeightMap.hpp"
 #include "gameplay/world/Terrain.hpp"
 
 namespace {
@@ -64,7 +65,7 @@ SingleChunkTerrainGenerator::SingleChunkTerrainGenerator(ChunkData& chunk,
                                                          const glm::ivec3& chunk_world_pos,
                                                          int seed, const Terrain& terrain)
     : chunk_(chunk), terrain_(terrain), chunk_world_pos_(chunk_world_pos), seed_(seed) {
-  chunk.blocks_ = std::make_unique<BlockTypeArray>();
+  chunk.blocks_ = ChunkPool::Get().AcquireBlocks();
 }
 
 void TerrainGenerator::SetBlock(int x, int y, int z, BlockType block) {
@@ -81,7 +82,7 @@ void TerrainGenerator::GenerateYLayer(int layer, BlockType block) {
   }
 }
 
-void TerrainGenerator::GenerateBiome() {
+void TerrainGenerator::GenerateBiome(ColumnHeightMap& heights) {
   ZoneScoped;
   EASSERT_MSG(!terrain_.biomes.empty(), "Need biomes");
   // Timer timer;
@@ -117,7 +118,9 @@ void TerrainGenerator::GenerateBiome() {
     for (int z = 0; z < kChunkLength; z++) {
       for (int x = 0; x < kChunkLength; x++, i++, j++, xz++) {
         if (y <= height_map[i]) {
-          SetBlock(x, y, z, get_block(y, height_map[i], j % kChunkVolume, xz));
+          BlockType block = get_block(y, height_map[i], j % kChunkVolume, xz);
+          SetBlock(x, y, z, block);
+          if (block != 0) heights.Set(x, z, y);
         }
       }
     }
@@ -150,7 +153,7 @@ void SingleChunkTerrainGenerator::GenerateNoise(BlockType block, float frequency
 
 void TerrainGenerator::GenerateSolid(BlockType block) {
   for (const auto& chunk : chunks_) {
-    chunk->data.blocks_ = std::make_unique<BlockTypeArray>();
+    chunk->data.blocks_ = ChunkPool::Get().AcquireBlocks();
     std::fill(chunk->data.blocks_->begin(), chunk->data.blocks_->end(), block);
     chunk->data.block_count_ = kChunkVolume;
   }
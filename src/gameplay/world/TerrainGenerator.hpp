@@ -5,13 +5,15 @@
 
 #include "gameplay/world/ChunkDef.hpp"
 class ChunkData;
+class ColumnHeightMap;
 struct Terrain;
 
 class TerrainGenerator {
  public:
   explicit TerrainGenerator(const std::array<std::shared_ptr<Chunk>, kNumVerticalChunks>& chunks,
                             const glm::ivec2& chunk_world_pos, int seed, const Terrain& terrain);
-  void GenerateBiome();
+  // Also records the height of each cell since it's known while generating.
+  void GenerateBiome(ColumnHeightMap& heights);
   void GenerateSolid(BlockType block);
   void GenerateYLayer(int layer, BlockType block);
 
@@ -0,0 +1,328 @@
+#include "WorldDataBundle.hpp"
+
+#include <fstream>
+
+#include "gameplay/world/BlockDB.hpp"
+#include "gameplay/world/Terrain.hpp"
+#include "util/Paths.hpp"
+#include "util/Timer.hpp"
+
+namespace {
+
+constexpr uint32_t kMagic = 0x42445756;  // "VWDB"
+// bump when the layout below changes
+constexpr uint32_t kVersion = 1;
+
+struct Header {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t fingerprint;
+  uint64_t payload_bytes;
+};
+
+class Writer {
+ public:
+  template <typename T>
+  void Put(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+  }
+  void Put(const std::string& str) {
+    Put(static_cast<uint32_t>(str.size()));
+    data.insert(data.end(), str.begin(), str.end());
+  }
+  template <typename T>
+  void PutVector(const std::vector<T>& values) {
+    Put(static_cast<uint32_t>(values.size()));
+    for (const auto& value : values) Put(value);
+  }
+
+  std::vector<uint8_t> data;
+};
+
+// Every read checks bounds, a failed read sets ok to false and returns a default.
+class Reader {
+ public:
+  explicit Reader(std::span<const uint8_t> data) : data_(data) {}
+
+  template <typename T>
+  T Get() {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value{};
+    if (!Has(sizeof(T))) return value;
+    std::memcpy(&value, data_.data() + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return value;
+  }
+  std::string GetString() {
+    auto size = Get<uint32_t>();
+    if (!Has(size)) return {};
+    std::string str(reinterpret_cast<const char*>(data_.data() + pos_), size);
+    pos_ += size;
+    return str;
+  }
+  template <typename T>
+  std::vector<T> GetVector() {
+    auto size = Get<uint32_t>();
+    if (!Has(static_cast<size_t>(size) * sizeof(T))) return {};
+    std::vector<T> values(size);
+    std::memcpy(values.data(), data_.data() + pos_, size * sizeof(T));
+    pos_ += size * sizeof(T);
+    return values;
+  }
+  [[nodiscard]] bool Done() const { return ok && pos_ == data_.size(); }
+
+  bool ok{true};
+
+ private:
+  bool Has(size_t bytes) {
+    ok = ok && pos_ + bytes <= data_.size();
+    return ok;
+  }
+  std::span<const uint8_t> data_;
+  size_t pos_{0};
+};
+
+void PutModel(Writer& w, const BlockModelData& model) {
+  w.Put(static_cast<uint8_t>(model.index()));
+  if (const auto* all = std::get_if<BlockModelDataAll>(&model)) {
+    w.Put(all->tex_all);
+    w.Put(static_cast<uint8_t>(all->transparency_type));
+  } else if (const auto* top_bot = std::get_if<BlockModelDataTopBot>(&model)) {
+    w.Put(top_bot->tex_top);
+    w.Put(top_bot->tex_bottom);
+    w.Put(top_bot->tex_side);
+  } else if (const auto* unique = std::get_if<BlockModelDataUnique>(&model)) {
+    for (const std::string* tex : {&unique->tex_pos_x, &unique->tex_neg_x, &unique->tex_pos_y,
+                                   &unique->tex_neg_y, &unique->tex_pos_z, &unique->tex_neg_z}) {
+      w.Put(*tex);
+    }
+  }
+}
+
+BlockModelData GetModel(Reader& r) {
+  auto index = r.Get<uint8_t>();
+  if (index == 0) {
+    BlockModelDataAll all;
+    all.tex_all = r.GetString();
+    all.transparency_type = static_cast<TransparencyType>(r.Get<uint8_t>());
+    return all;
+  }
+  if (index == 1) {
+    BlockModelDataTopBot top_bot;
+    top_bot.tex_top = r.GetString();
+    top_bot.tex_bottom = r.GetString();
+    top_bot.tex_side = r.GetString();
+    return top_bot;
+  }
+  if (index == 2) {
+    BlockModelDataUnique unique;
+    for (std::string* tex : {&unique.tex_pos_x, &unique.tex_neg_x, &unique.tex_pos_y,
+                             &unique.tex_neg_y, &unique.tex_pos_z, &unique.tex_neg_z}) {
+      *tex = r.GetString();
+    }
+    return unique;
+  }
+  r.ok = false;
+  return {};
+}
+
+}  // namespace
+
+std::filesystem::path WorldDataBundle::DefaultPath() {
+  return GET_PATH("resources/cache/world_data.bin");
+}
+
+uint64_t WorldDataBundle::SourceFingerprint() {
+  ZoneScoped;
+  std::vector<std::string> entries;
+  std::error_code ec;
+  for (const auto& file :
+       std::filesystem::recursive_directory_iterator(GET_PATH("resources/data"), ec)) {
+    if (!file.is_regular_file()) continue;
+    entries.emplace_back(fmt::format("{}|{}|{}", file.path().generic_string(), file.file_size(),
+                                     file.last_write_time().time_since_epoch().count()));
+  }
+  // directory order isn't stable across platforms
+  std::sort(entries.begin(), entries.end());
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ull;
+  for (const auto& entry : entries) {
+    for (char c : entry) {
+      hash ^= static_cast<uint8_t>(c);
+      hash *= 1099511628211ull;
+    }
+    hash ^= '\n';
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+bool WorldDataBundle::Write(const std::filesystem::path& path, uint64_t fingerprint,
+                            const BlockDB& block_db, const Terrain& terrain) {
+  ZoneScoped;
+  Writer w;
+  const auto& defaults = block_db.block_defaults_;
+  w.Put(defaults.id);
+  w.Put(defaults.name);
+  w.Put(defaults.model_name);
+  w.Put(defaults.tex_name);
+  w.Put(defaults.move_slow_multiplier);
+  w.Put(static_cast<uint8_t>(defaults.emits_light));
+
+  w.Put(static_cast<uint32_t>(block_db.block_data_arr_.size()));
+  for (size_t i = 0; i < block_db.block_data_arr_.size(); i++) {
+    const BlockData& data = block_db.block_data_arr_[i];
+    w.Put(data.id);
+    w.Put(data.full_file_path);
+    w.Put(data.name);
+    w.Put(data.formatted_name);
+    w.Put(data.move_slow_multiplier);
+    w.Put(static_cast<uint8_t>(data.emits_light));
+    w.Put(block_db.block_model_names_[i]);
+  }
+
+  PutModel(w, block_db.default_model_data_);
+  w.Put(static_cast<uint32_t>(block_db.model_name_to_model_data_.size()));
+  for (const auto& [name, model] : block_db.model_name_to_model_data_) {
+    w.Put(name);
+    PutModel(w, model);
+  }
+  w.Put(static_cast<uint32_t>(block_db.block_tex_names_in_use_.size()));
+  for (const auto& tex_name : block_db.block_tex_names_in_use_) w.Put(tex_name);
+
+  w.PutVector(terrain.biome_frequencies);
+  w.Put(terrain.id_stone);
+  w.Put(terrain.id_sand);
+  w.Put(static_cast<uint32_t>(terrain.biomes.size()));
+  for (const auto& biome : terrain.biomes) {
+    w.Put(biome.name);
+    w.Put(biome.formatted_name);
+    w.Put(biome.layer_y_sum);
+    w.Put(static_cast<uint32_t>(biome.layers.size()));
+    for (const auto& layer : biome.layers) {
+      w.PutVector(layer.block_types);
+      w.PutVector(layer.block_type_frequencies);
+      w.Put(layer.y_count);
+    }
+  }
+
+  std::error_code ec;
+  std::filesystem::create_directories(path.parent_path(), ec);
+  // write then rename so a crash never leaves a truncated bundle behind
+  std::filesystem::path tmp_path = path;
+  tmp_path += ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+      spdlog::warn("Failed to write world data bundle: {}", tmp_path.string());
+      return false;
+    }
+    Header header{kMagic, kVersion, fingerprint, w.data.size()};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(w.data.data()),
+               static_cast<std::streamsize>(w.data.size()));
+    if (!file) return false;
+  }
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    spdlog::warn("Failed to write world data bundle {}: {}", path.string(), ec.message());
+    std::filesystem::remove(tmp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+bool WorldDataBundle::Read(const std::filesystem::path& path, uint64_t fingerprint,
+                           BlockDB& block_db, Terrain& terrain) {
+  ZoneScoped;
+  Timer timer;
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) return false;
+  Header header{};
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!file || header.magic != kMagic || header.version != kVersion ||
+      header.fingerprint != fingerprint) {
+    return false;
+  }
+  std::vector<uint8_t> payload(header.payload_bytes);
+  file.read(reinterpret_cast<char*>(payload.data()), static_cast<std::streamsize>(payload.size()));
+  if (!file) return false;
+
+  // everything is read into locals first so a corrupt bundle leaves the outputs untouched
+  Reader r{payload};
+  BlockDB::BlockDataDefaults defaults;
+  defaults.id = r.Get<uint32_t>();
+  defaults.name = r.GetString();
+  defaults.model_name = r.GetString();
+  defaults.tex_name = r.GetString();
+  defaults.move_slow_multiplier = r.Get<float>();
+  defaults.emits_light = r.Get<uint8_t>();
+
+  auto num_blocks = r.Get<uint32_t>();
+  std::vector<BlockData> block_data_arr;
+  std::vector<std::string> block_model_names;
+  for (uint32_t i = 0; i < num_blocks && r.ok; i++) {
+    BlockData data;
+    data.id = r.Get<BlockType>();
+    data.full_file_path = r.GetString();
+    data.name = r.GetString();
+    data.formatted_name = r.GetString();
+    data.move_slow_multiplier = r.Get<float>();
+    data.emits_light = r.Get<uint8_t>();
+    block_data_arr.emplace_back(std::move(data));
+    block_model_names.emplace_back(r.GetString());
+  }
+
+  BlockModelData default_model_data = GetModel(r);
+  std::unordered_map<std::string, BlockModelData> model_name_to_model_data;
+  auto num_models = r.Get<uint32_t>();
+  for (uint32_t i = 0; i < num_models && r.ok; i++) {
+    std::string name = r.GetString();
+    model_name_to_model_data.emplace(std::move(name), GetModel(r));
+  }
+  std::unordered_set<std::string> tex_names_in_use;
+  auto num_tex_names = r.Get<uint32_t>();
+  for (uint32_t i = 0; i < num_tex_names && r.ok; i++) tex_names_in_use.emplace(r.GetString());
+
+  Terrain loaded_terrain;
+  loaded_terrain.biome_frequencies = r.GetVector<float>();
+  loaded_terrain.id_stone = r.Get<BlockType>();
+  loaded_terrain.id_sand = r.Get<BlockType>();
+  auto num_biomes = r.Get<uint32_t>();
+  for (uint32_t i = 0; i < num_biomes && r.ok; i++) {
+    Biome& biome = loaded_terrain.biomes.emplace_back();
+    biome.name = r.GetString();
+    biome.formatted_name = r.GetString();
+    biome.layer_y_sum = r.Get<uint32_t>();
+    auto num_layers = r.Get<uint32_t>();
+    for (uint32_t j = 0; j < num_layers && r.ok; j++) {
+      BiomeLayer& layer = biome.layers.emplace_back();
+      layer.block_types = r.GetVector<BlockType>();
+      layer.block_type_frequencies = r.GetVector<float>();
+      layer.y_count = r.Get<uint32_t>();
+    }
+  }
+  if (!r.Done()) {
+    spdlog::warn("World data bundle {} is corrupt, rebuilding from JSON", path.string());
+    return false;
+  }
+
+  block_db.block_defaults_ = std::move(defaults);
+  block_db.block_data_arr_ = std::move(block_data_arr);
+  block_db.block_model_names_ = std::move(block_model_names);
+  block_db.default_model_data_ = std::move(default_model_data);
+  block_db.model_name_to_model_data_ = std::move(model_name_to_model_data);
+  block_db.block_tex_names_in_use_ = std::move(tex_names_in_use);
+  block_db.block_name_to_id_.clear();
+  for (const auto& data : block_db.block_data_arr_) {
+    // ids missing on disk leave empty slots
+    if (!data.name.empty()) block_db.block_name_to_id_.emplace(data.name, data.id);
+  }
+  terrain = std::move(loaded_terrain);
+  spdlog::info("Loaded {} blocks and {} biomes from {} in {:.2f} ms",
+               block_db.block_data_arr_.size(), terrain.biomes.size(), path.string(),
+               timer.ElapsedMS());
+  return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+class BlockDB;
+struct Terrain;
+
+// The resolved block table, block models and terrain biomes compiled into one versioned binary
+// file, so startup reads a single file instead of walking and parsing the JSON under
+// resources/data. The bundle records a fingerprint of the JSON it was built from and is rebuilt
+// when any of it changes.
+class WorldDataBundle {
+ public:
+  [[nodiscard]] static std::filesystem::path DefaultPath();
+  // Hash of the path, size and write time of every file under resources/data.
+  [[nodiscard]] static uint64_t SourceFingerprint();
+  // Fails without touching block_db or terrain if the file is missing, from another version or
+  // built from different sources.
+  [[nodiscard]] static bool Read(const std::filesystem::path& path, uint64_t fingerprint,
+                                 BlockDB& block_db, Terrain& terrain);
+  static bool Write(const std::filesystem::path& path, uint64_t fingerprint,
+                    const BlockDB& block_db, const Terrain& terrain);
+};
@@ -0,0 +1,68 @@
+#include "HeadlessMeshSink.hpp"
+
+#include "application/Metrics.hpp"
+
+uint32_t HeadlessMeshSink::AllocateStaticChunk(std::vector<ChunkVertex>& vertices,
+                                               std::vector<uint32_t>& indices,
+                                               const glm::ivec3& /*pos*/, LODLevel /*level*/) {
+  return Allocate(vertices, indices);
+}
+
+uint32_t HeadlessMeshSink::AllocateStaticChunkTransparent(std::vector<ChunkVertex>& vertices,
+                                                          std::vector<uint32_t>& indices,
+                                                          const glm::ivec3& /*pos*/) {
+  return Allocate(vertices, indices);
+}
+
+void HeadlessMeshSink::FreeStaticChunkMesh(uint32_t& handle) { Free(handle); }
+
+void HeadlessMeshSink::FreeStaticChunkMeshTransparent(uint32_t& handle) { Free(handle); }
+
+ChunkMeshSink::MeshBufferUsage HeadlessMeshSink::GetMeshBufferUsage() const {
+  MeshBufferUsage usage;
+  if (capacity_bytes_) {
+    usage.occupancy = static_cast<float>(static_cast<double>(stats_.live_bytes) /
+                                         static_cast<double>(capacity_bytes_));
+  }
+  usage.failed_allocs = stats_.failed_allocs;
+  return usage;
+}
+
+uint32_t HeadlessMeshSink::Allocate(const std::vector<ChunkVertex>& vertices,
+                                    const std::vector<uint32_t>& indices) {
+  if (vertices.empty() || indices.empty()) {
+    spdlog::error("no vertices or indices");
+    return 0;
+  }
+  uint64_t bytes = sizeof(ChunkVertex) * vertices.size() + sizeof(uint32_t) * indices.size();
+  if (capacity_bytes_ && stats_.live_bytes + bytes > capacity_bytes_) {
+    spdlog::error("HeadlessMeshSink: {} bytes requested, {} of {} live", bytes, stats_.live_bytes,
+                  capacity_bytes_);
+    stats_.failed_allocs++;
+    return 0;
+  }
+  // what the renderer would have uploaded
+  static auto& upload_bytes = MetricsRegistry::Get().GetCounter("mesh.upload_bytes");
+  upload_bytes.Add(bytes);
+  uint32_t handle = next_handle_++;
+  handle_bytes_.emplace(handle, bytes);
+  stats_.allocs++;
+  stats_.bytes_allocated += bytes;
+  stats_.live_bytes += bytes;
+  stats_.vertices += vertices.size();
+  stats_.indices += indices.size();
+  return handle;
+}
+
+void HeadlessMeshSink::Free(uint32_t& handle) {
+  if (handle == 0) return;
+  auto it = handle_bytes_.find(handle);
+  handle = 0;
+  if (it == handle_bytes_.end()) {
+    spdlog::error("HeadlessMeshSink: handle not found");
+    return;
+  }
+  stats_.frees++;
+  stats_.live_bytes -= it->second;
+  handle_bytes_.erase(it);
+}
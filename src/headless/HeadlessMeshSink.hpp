@@ -0,0 +1,41 @@
+#pragma once
+
+#include "gameplay/world/ChunkMeshSink.hpp"
+
+// Accounts for the meshes ChunkManager would upload instead of touching the GPU.
+class HeadlessMeshSink : public ChunkMeshSink {
+ public:
+  [[nodiscard]] uint32_t AllocateStaticChunk(std::vector<ChunkVertex>& vertices,
+                                             std::vector<uint32_t>& indices, const glm::ivec3& pos,
+                                             LODLevel level) override;
+  [[nodiscard]] uint32_t AllocateStaticChunkTransparent(std::vector<ChunkVertex>& vertices,
+                                                        std::vector<uint32_t>& indices,
+                                                        const glm::ivec3& pos) override;
+  void FreeStaticChunkMesh(uint32_t& handle) override;
+  void FreeStaticChunkMeshTransparent(uint32_t& handle) override;
+  [[nodiscard]] MeshBufferUsage GetMeshBufferUsage() const override;
+  // Allocations fail once live bytes would pass capacity, like a full GPU buffer. 0 is unbounded.
+  void SetCapacity(uint64_t capacity_bytes) { capacity_bytes_ = capacity_bytes; }
+
+  struct Stats {
+    uint64_t allocs{};
+    uint64_t frees{};
+    // every mesh handed over, including ones since freed
+    uint64_t bytes_allocated{};
+    uint64_t live_bytes{};
+    uint64_t vertices{};
+    uint64_t indices{};
+    uint64_t failed_allocs{};
+  };
+  [[nodiscard]] const Stats& GetStats() const { return stats_; }
+
+ private:
+  std::unordered_map<uint32_t, uint64_t> handle_bytes_;
+  uint32_t next_handle_{1};
+  uint64_t capacity_bytes_{0};
+  Stats stats_;
+
+  uint32_t Allocate(const std::vector<ChunkVertex>& vertices,
+                    const std::vector<uint32_t>& indices);
+  void Free(uint32_t& handle);
+};
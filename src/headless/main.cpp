@@ -0,0 +1,275 @@
+// Runs terrain generation, lighting, meshing and streaming along a scripted path or a recorded
+// replay without a window or GL context, and reports throughput and frame times.
+
+#include <cstdlib>
+#include <thread>
+
+#include "application/Metrics.hpp"
+#include "application/SettingsManager.hpp"
+#include "gameplay/replay/ReplayDriver.hpp"
+#include "gameplay/world/BlockDB.hpp"
+#include "gameplay/world/ChunkManager.hpp"
+#include "headless/HeadlessMeshSink.hpp"
+#include "util/JsonUtil.hpp"
+#include "util/Timer.hpp"
+
+namespace {
+
+struct Options {
+  int load_distance{12};
+  int frames{1200};
+  // 0 runs frames back to back
+  int fps{60};
+  // blocks per second along the path
+  float speed{40.f};
+  // side length of the square the path loops around
+  int path_length{512};
+  int seed{0};
+  bool lighting{true};
+  double load_timeout_seconds{300};
+  // replaces the scripted path, frames and seed come from the replay
+  std::string replay_path;
+  // the replay report, logged as a summary only if empty
+  std::string report_path;
+  // metrics dump, CSV if it ends in .csv and JSON lines otherwise
+  std::string metrics_path;
+  double metrics_interval_seconds{1};
+};
+
+void PrintUsage() {
+  spdlog::info(
+      "usage: voxels_headless [--load-distance N] [--frames N] [--fps N] [--speed F] "
+      "[--path-length N] [--seed N] [--no-lighting] [--replay PATH [--report PATH]] "
+      "[--metrics PATH [--metrics-interval SECONDS]]");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--no-lighting") {
+      options.lighting = false;
+    } else if (arg == "--load-distance" && has_value) {
+      options.load_distance = std::atoi(argv[++i]);
+    } else if (arg == "--frames" && has_value) {
+      options.frames = std::atoi(argv[++i]);
+    } else if (arg == "--fps" && has_value) {
+      options.fps = std::atoi(argv[++i]);
+    } else if (arg == "--speed" && has_value) {
+      options.speed = static_cast<float>(std::atof(argv[++i]));
+    } else if (arg == "--path-length" && has_value) {
+      options.path_length = std::atoi(argv[++i]);
+    } else if (arg == "--seed" && has_value) {
+      options.seed = std::atoi(argv[++i]);
+    } else if (arg == "--replay" && has_value) {
+      options.replay_path = argv[++i];
+    } else if (arg == "--report" && has_value) {
+      options.report_path = argv[++i];
+    } else if (arg == "--metrics" && has_value) {
+      options.metrics_path = argv[++i];
+    } else if (arg == "--metrics-interval" && has_value) {
+      options.metrics_interval_seconds = std::atof(argv[++i]);
+    } else {
+      return false;
+    }
+  }
+  return options.load_distance > 0 && options.frames > 0 && options.fps >= 0 &&
+         options.path_length > 0 && options.metrics_interval_seconds > 0;
+}
+
+// Walks counterclockwise around a square starting at the origin.
+glm::vec3 PathPosition(const Options& options, float distance) {
+  auto length = static_cast<float>(options.path_length);
+  float along = std::fmod(distance, length * 4.f);
+  int side = static_cast<int>(along / length);
+  float t = along - static_cast<float>(side) * length;
+  constexpr float kHeight = kMaxBlockHeight * 0.75f;
+  switch (side) {
+    case 0:
+      return {t, kHeight, 0.f};
+    case 1:
+      return {length, kHeight, t};
+    case 2:
+      return {length - t, kHeight, length};
+    default:
+      return {0.f, kHeight, length - t};
+  }
+}
+
+nlohmann::json MemoryJson(const ChunkManager::MemoryUsage& usage,
+                          const HeadlessMeshSink::Stats& mesh_stats) {
+  return {{"num_chunks", usage.num_chunks},
+          {"total", usage.Total()},
+          {"chunk_objects", usage.chunk_objects},
+          {"block_arrays", usage.block_arrays},
+          {"lod_arrays", usage.lod_arrays},
+          {"light_arrays", usage.light_arrays},
+          {"height_maps", usage.height_maps},
+          {"meshes_in_flight", usage.meshes_in_flight},
+          {"chunk_map_overhead", usage.chunk_map_overhead},
+          {"pooled", usage.pooled},
+          {"evicted_columns", usage.evicted_columns},
+          // what the renderer's chunk buffers would hold
+          {"live_mesh_bytes", mesh_stats.live_bytes}};
+}
+
+double Percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0;
+  auto idx = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+  return sorted[idx];
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    PrintUsage();
+    return 1;
+  }
+
+  SettingsManager::Init();
+  // settings come from the command line rather than the user's settings file
+  nlohmann::json chunk_manager_settings = {{"load_distance", options.load_distance},
+                                           {"lighting", options.lighting}};
+  SettingsManager::Get().SaveSetting(chunk_manager_settings, "chunk_manager");
+
+  BlockDB block_db;
+  {
+    // textures are never sampled, the mesher only needs an index per texture
+    std::unordered_map<std::string, uint32_t> tex_name_to_idx;
+    uint32_t tex_idx = 0;
+    for (const auto& tex_name : block_db.GetTextureNamesInUse()) {
+      tex_name_to_idx[tex_name] = tex_idx++;
+    }
+    block_db.LoadMeshData(tex_name_to_idx);
+  }
+
+  Replay replay;
+  if (!options.replay_path.empty()) {
+    if (!replay.Load(options.replay_path) || replay.frames.empty()) {
+      spdlog::error("no replay frames in {}", options.replay_path);
+      SettingsManager::Shutdown();
+      return 1;
+    }
+    options.seed = static_cast<int>(replay.seed);
+    options.frames = static_cast<int>(replay.frames.size());
+  }
+  const bool use_replay = !replay.frames.empty();
+  const glm::vec3 start_pos = use_replay ? replay.frames[0].position : PathPosition(options, 0);
+
+  if (!options.metrics_path.empty()) {
+    MetricsRegistry::Get().SetDumpPath(options.metrics_path, options.metrics_interval_seconds);
+  }
+
+  HeadlessMeshSink mesh_sink;
+  int exit_code = 0;
+  {
+    ChunkManager chunk_manager{block_db, mesh_sink};
+    chunk_manager.SetSeed(options.seed);
+    chunk_manager.Init(glm::ivec3{start_pos});
+
+    Timer load_timer;
+    while (!chunk_manager.IsLoaded() || chunk_manager.GetStateStats().loaded_chunks <
+                                            chunk_manager.GetStateStats().max_chunks) {
+      chunk_manager.SetCenter(start_pos);
+      chunk_manager.Update(0);
+      MetricsRegistry::Get().EndFrame();
+      if (load_timer.ElapsedSeconds() > options.load_timeout_seconds) {
+        spdlog::error("initial load did not finish in {} s", options.load_timeout_seconds);
+        exit_code = 1;
+        break;
+      }
+      std::this_thread::yield();
+    }
+    double load_seconds = load_timer.ElapsedSeconds();
+    uint32_t load_columns = chunk_manager.GetStateStats().loaded_chunks / kNumVerticalChunks;
+    HeadlessMeshSink::Stats load_mesh_stats = mesh_sink.GetStats();
+
+    spdlog::info("initial load: {:.3f} s, {} columns, {} meshes, {:.2f} MB", load_seconds,
+                 load_columns, load_mesh_stats.allocs,
+                 static_cast<double>(load_mesh_stats.bytes_allocated) / (1024.0 * 1024.0));
+
+    std::unique_ptr<ReplayDriver> replay_driver;
+    if (use_replay) replay_driver = std::make_unique<ReplayDriver>(replay, chunk_manager);
+
+    std::vector<double> frame_ms;
+    frame_ms.reserve(options.frames);
+    double dt = options.fps > 0 ? 1.0 / options.fps : 1.0 / 60.0;
+    if (use_replay) dt = replay.dt;
+    auto frame_duration = std::chrono::duration<double>(options.fps > 0 ? dt : 0.0);
+    Timer stream_timer;
+    auto next_frame = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < options.frames && exit_code == 0; frame++) {
+      Timer frame_timer;
+      if (replay_driver) {
+        // includes the driver's bookkeeping, its report has Update alone
+        replay_driver->Step();
+      } else {
+        float distance = options.speed * static_cast<float>(dt * (frame + 1));
+        chunk_manager.SetCenter(PathPosition(options, distance));
+        chunk_manager.Update(dt);
+      }
+      frame_ms.emplace_back(frame_timer.ElapsedMS());
+      MetricsRegistry::Get().EndFrame();
+      if (options.fps > 0) {
+        next_frame += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            frame_duration);
+        std::this_thread::sleep_until(next_frame);
+      }
+    }
+    double stream_seconds = stream_timer.ElapsedSeconds();
+
+    const HeadlessMeshSink::Stats& mesh_stats = mesh_sink.GetStats();
+    uint32_t stream_columns =
+        chunk_manager.GetStateStats().loaded_chunks / kNumVerticalChunks - load_columns;
+    uint64_t stream_meshes = mesh_stats.allocs - load_mesh_stats.allocs;
+    uint64_t stream_bytes = mesh_stats.bytes_allocated - load_mesh_stats.bytes_allocated;
+    std::sort(frame_ms.begin(), frame_ms.end());
+    spdlog::info("streaming: {} frames in {:.3f} s, {:.1f} columns/s, {:.1f} meshes/s, {:.2f} MB/s",
+                 frame_ms.size(), stream_seconds, stream_columns / stream_seconds,
+                 static_cast<double>(stream_meshes) / stream_seconds,
+                 static_cast<double>(stream_bytes) / (1024.0 * 1024.0) / stream_seconds);
+    spdlog::info("frame ms: p50 {:.3f}, p90 {:.3f}, p99 {:.3f}, max {:.3f}",
+                 Percentile(frame_ms, 0.5), Percentile(frame_ms, 0.9), Percentile(frame_ms, 0.99),
+                 frame_ms.empty() ? 0.0 : frame_ms.back());
+    spdlog::info("mesh output: {} meshes, {} vertices, {} indices, {:.2f} MB total, {:.2f} MB live",
+                 mesh_stats.allocs, mesh_stats.vertices, mesh_stats.indices,
+                 static_cast<double>(mesh_stats.bytes_allocated) / (1024.0 * 1024.0),
+                 static_cast<double>(mesh_stats.live_bytes) / (1024.0 * 1024.0));
+
+    ChunkManager::MemoryUsage memory = chunk_manager.GetMemoryUsage();
+    constexpr double kMB = 1024.0 * 1024.0;
+    spdlog::info(
+        "memory: {:.2f} MB world ({} chunks, blocks {:.2f} MB, lod {:.2f} MB, light {:.2f} MB, "
+        "maps {:.2f} MB), {:.2f} MB meshes live",
+        static_cast<double>(memory.Total()) / kMB, memory.num_chunks,
+        static_cast<double>(memory.block_arrays) / kMB,
+        static_cast<double>(memory.lod_arrays) / kMB,
+        static_cast<double>(memory.light_arrays) / kMB,
+        static_cast<double>(memory.chunk_map_overhead) / kMB,
+        static_cast<double>(mesh_stats.live_bytes) / kMB);
+
+    if (replay_driver) {
+      auto report = replay_driver->GetReport();
+      report["memory_bytes"] = MemoryJson(memory, mesh_stats);
+      spdlog::info(
+          "replay: update ms p99 {:.3f}, max {:.3f}, time to first mesh ms p50 {:.1f}, p99 {:.1f}, "
+          "frames with visible chunks missing meshes {}",
+          report["update_ms"]["p99"].get<double>(), report["update_ms"]["max"].get<double>(),
+          report["time_to_first_mesh_ms"]["p50"].get<double>(),
+          report["time_to_first_mesh_ms"]["p99"].get<double>(),
+          report["missing_visible_meshes"]["frames_with_missing"].get<uint32_t>());
+      if (!options.report_path.empty()) {
+        util::json::WriteJson(report, options.report_path);
+        spdlog::info("replay report written to {}", options.report_path);
+      }
+    }
+    if (!options.metrics_path.empty()) {
+      MetricsRegistry::Get().Dump();
+      spdlog::info("metrics written to {}", options.metrics_path);
+    }
+  }
+  SettingsManager::Shutdown();
+  return exit_code;
+}
@@ -8,6 +8,7 @@
 #include "gameplay/world/Chunk.hpp"
 #include "gameplay/world/ChunkDef.hpp"
 #include "gameplay/world/ChunkHelpers.hpp"
+#include "gameplay/world/LightEngine.hpp"
 #include "util/Timer.hpp"
 
 ChunkMesher::ChunkMesher(const std::vector<BlockData>& db_block_data,
@@ -61,8 +62,9 @@ uint32_t GetVertexData1(uint8_t x, uint8_t y, uint8_t z, uint8_t u, uint8_t v, u
   return (x | y << 6 | z << 12 | ao << 18 | u << 20 | v << 26);
 }
 
-uint32_t GetVertexData2(uint32_t tex_idx, uint32_t quad_face) {
-  return (quad_face << 29 | tex_idx);
+// light is sky light in the high 4 bits and block light in the low 4 bits
+uint32_t GetVertexData2(uint32_t tex_idx, uint32_t quad_face, uint32_t light = kFullSkyLight) {
+  return (quad_face << 29 | light << 21 | tex_idx);
 }
 
 struct FaceInfo {
@@ -79,17 +81,17 @@ struct FaceInfo {
   };
 
   Ao ao;
+  // per vertex, packed like ChunkData light
+  std::array<uint8_t, 4> light;
   bool initialized{false};
   [[nodiscard]] bool Flip() const { return ao.v0 + ao.v2 > ao.v1 + ao.v3; }
 
-  bool operator==(const FaceInfo& other) const { return ao == other.ao; }
+  bool operator==(const FaceInfo& other) const { return ao == other.ao && light == other.light; }
 
-  bool operator!=(const FaceInfo& other) const {
-    return ao.v0 != other.ao.v0 || ao.v1 != other.ao.v1 || ao.v2 != other.ao.v2 ||
-           ao.v3 != other.ao.v3;
-  }
+  bool operator!=(const FaceInfo& other) const { return !(*this == other); }
   // FaceLighting (for meshing)
-  void SetValues(int face_num, const BlockType (&block_neighbors)[27]) {
+  void SetValues(int face_num, const BlockType (&block_neighbors)[27],
+                 const uint8_t (&light_neighbors)[27]) {
     if (initialized) return;
     initialized = true;
     // y
@@ -114,7 +116,7 @@ struct FaceInfo {
         {{9, 0, 1}, {9, 18, 19}, {11, 20, 19}, {11, 2, 1}},
         {{11, 2, 5}, {11, 20, 23}, {17, 26, 23}, {17, 8, 5}},
         {{9, 0, 3}, {15, 6, 3}, {15, 24, 21}, {9, 18, 21}}};
-    // constexpr const int Lookup1[6] = {22, 4, 16, 10, 14, 12};
+    constexpr const int kLookup1[6] = {22, 4, 16, 10, 14, 12};
 
     uint8_t sides[3];
     bool trans[3];
@@ -142,20 +144,20 @@ struct FaceInfo {
           break;
       }
 
-      //   // smooth the Light using the average value
-      //   uint8_t counter = 1, sunLightSum = sunlight_neighbours[Lookup1[face]],
-      //           torchLightSum = torchlight_neighbours[Lookup1[face]];
-      //   if (canPass[0] || canPass[2])
-      //     for (int i = 0; i < 3; ++i) {
-      //       if (!canPass[i]) continue;
-      //       counter++;
-      //       sunLightSum += sunlight_neighbours[Lookup3[face][v][i]];
-      //       torchLightSum += torchlight_neighbours[Lookup3[face][v][i]];
-      //     }
-      //
-      //   this->sunlight[v] = sunLightSum / counter;
-      //   this->torchlight[v] = torchLightSum / counter;
-      // }
+      // smooth the light using the average of the face block and the open blocks around the vertex
+      uint8_t face_light = light_neighbors[kLookup1[face_num]];
+      uint32_t counter = 1;
+      uint32_t sky_sum = light::GetSky(face_light);
+      uint32_t block_sum = light::GetBlock(face_light);
+      if (trans[0] || trans[2]) {
+        for (int i = 0; i < 3; ++i) {
+          if (!trans[i]) continue;
+          counter++;
+          sky_sum += light::GetSky(light_neighbors[kLookup3[face_num][v][i]]);
+          block_sum += light::GetBlock(light_neighbors[kLookup3[face_num][v][i]]);
+        }
+      }
+      light[v] = light::Pack(sky_sum / counter, block_sum / counter);
     }
   }
 };
@@ -337,11 +339,25 @@ void ChunkMesher::GenerateGreedy(const ChunkNeighborArray& chunks, MeshVerticesI
     return c->data.GetBlock((x + chunk_length) % chunk_length, (y + chunk_length) % chunk_length,
                             (z + chunk_length) % chunk_length);
   };
+  // snapshot once, the main thread can publish new light arrays while this runs
+  std::array<std::shared_ptr<const LightArray>, 27> lights;
+  for (size_t i = 0; i < chunks.size(); i++) {
+    if (chunks[i]) lights[i] = chunks[i]->data.GetLightArray();
+  }
+  auto get_light = [chunk_length, &lights](int x, int y, int z) -> uint8_t {
+    const auto& l = lights[PosInChunkMeshToChunkNeighborOffset(x, y, z)];
+    if (l == nullptr) return kFullSkyLight;
+    return (*l)[ChunkData::GetIndex((x + chunk_length) % chunk_length,
+                                    (y + chunk_length) % chunk_length,
+                                    (z + chunk_length) % chunk_length)];
+  };
 
   std::unordered_map<uint32_t, std::array<FaceInfo, 6>> face_info_map;
   BlockType neighbors[27];
-  auto get_face_info = [&face_info_map, &get_block, mesh_chunk_blocks, &neighbors, this](
-                           int x, int y, int z, uint32_t face) -> FaceInfo& {
+  uint8_t light_neighbors[27];
+  auto get_face_info = [&face_info_map, &get_block, &get_light, mesh_chunk_blocks, &neighbors,
+                        &light_neighbors,
+                        this](int x, int y, int z, uint32_t face) -> FaceInfo& {
     uint32_t idx = chunk::GetIndex(x, y, z);
     auto it = face_info_map.find(idx);
     if (it == face_info_map.end()) {
@@ -367,11 +383,12 @@ void ChunkMesher::GenerateGreedy(const ChunkNeighborArray& chunks, MeshVerticesI
           for (it[1] = y - 1; it[1] <= y + 1; ++it[1]) {
             for (it[2] = z - 1; it[2] <= z + 1; ++it[2], ++ind) {
               neighbors[ind] = get_block(it[0], it[1], it[2]);
+              light_neighbors[ind] = get_light(it[0], it[1], it[2]);
             }
           }
         }
       }
-      face_info_map[idx][face].SetValues(face, neighbors);
+      face_info_map[idx][face].SetValues(face, neighbors, light_neighbors);
     }
 
     return face_info_map[idx][face];
@@ -529,7 +546,6 @@ void ChunkMesher::GenerateGreedy(const ChunkNeighborArray& chunks, MeshVerticesI
                 v11v = du[v];
               }
 
-              uint32_t v_data2 = GetVertexData2(tex_idx, quad_face);
               uint32_t v00_data1 = GetVertexData1(vx, vy, vz, v00u, v00v, curr_face_info.ao.v0);
               uint32_t v01_data1 = GetVertexData1(vx + du[0], vy + du[1], vz + du[2], v01u, v01v,
                                                   curr_face_info.ao.v1);
@@ -541,10 +557,14 @@ void ChunkMesher::GenerateGreedy(const ChunkNeighborArray& chunks, MeshVerticesI
               auto& vertices = trans ? out_data.transparent_vertices : out_data.opaque_vertices;
               auto& indices = trans ? out_data.transparent_indices : out_data.opaque_indices;
               int base_vertex_idx = vertices.size();
-              vertices.emplace_back(v00_data1, v_data2);
-              vertices.emplace_back(v01_data1, v_data2);
-              vertices.emplace_back(v10_data1, v_data2);
-              vertices.emplace_back(v11_data1, v_data2);
+              vertices.emplace_back(v00_data1,
+                                    GetVertexData2(tex_idx, quad_face, curr_face_info.light[0]));
+              vertices.emplace_back(v01_data1,
+                                    GetVertexData2(tex_idx, quad_face, curr_face_info.light[1]));
+              vertices.emplace_back(v10_data1,
+                                    GetVertexData2(tex_idx, quad_face, curr_face_info.light[2]));
+              vertices.emplace_back(v11_data1,
+                                    GetVertexData2(tex_idx, quad_face, curr_face_info.light[3]));
 
               if (curr_face_info.Flip()) {
                 indices.push_back(base_vertex_idx + 0);
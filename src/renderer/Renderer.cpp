@@ -9,6 +9,7 @@
 
 #include "ShaderManager.hpp"
 #include "Vertex.hpp"
+#include "application/Metrics.hpp"
 #include "application/SettingsManager.hpp"
 #include "application/Window.hpp"
 #include "gameplay/world/ChunkDef.hpp"
@@ -20,6 +21,7 @@
 #include "renderer/Shape.hpp"
 #include "renderer/opengl/Debug.hpp"
 #include "renderer/opengl/Texture2d.hpp"
+#include "resource/TextureManager.hpp"
 #include "util/Paths.hpp"
 
 namespace {
@@ -374,6 +376,7 @@ void Renderer::DrawStaticTransparentChunks(const RenderInfo& render_info) {
     chunk_shader->Bind();
     chunk_shader->SetBool("u_UseTexture", settings.chunk_render_use_texture);
     chunk_shader->SetBool("u_UseAO", settings.chunk_use_ao);
+    chunk_shader->SetBool("u_UseLighting", settings.chunk_use_lighting);
 
     chunk_tex_array->Bind(0);
     static_transparent_chunk_vao_.Bind();
@@ -627,6 +630,7 @@ void Renderer::SetShadowCascadeLevels(float near_plane, float far_plane) {
 
 void Renderer::Render(const RenderInfo& render_info) {
   ZoneScoped;
+  FlushStaticChunkFrees();
   SetShadowCascadeLevels(render_info.camera_near_plane, render_info.camera_far_plane);
   UBOUniforms uniform_data;
   uniform_data.vp_matrix = render_info.vp_matrix;
@@ -704,6 +708,7 @@ void Renderer::Render(const RenderInfo& render_info) {
       shader.Bind();
       shader.SetBool("u_UseTexture", settings.chunk_render_use_texture);
       shader.SetBool("u_UseAO", settings.chunk_use_ao);
+      shader.SetBool("u_UseLighting", settings.chunk_use_lighting);
       if (kDrawShadows) {
         shader.SetBool("u_drawShadows", true);
         shader.SetFloat("u_farPlane", render_info.camera_far_plane);
@@ -938,6 +943,8 @@ uint32_t Renderer::AllocateStaticChunkTransparent(std::vector<ChunkVertex>& vert
     spdlog::error("no vertices or indices");
     return 0;
   }
+  static auto& upload_bytes = MetricsRegistry::Get().GetCounter("mesh.upload_bytes");
+  upload_bytes.Add(sizeof(ChunkVertex) * vertices.size() + sizeof(uint32_t) * indices.size());
   uint32_t chunk_vbo_offset;
   uint32_t chunk_ebo_offset;
   glm::ivec4 min = glm::ivec4(pos, 0);
@@ -945,6 +952,10 @@ uint32_t Renderer::AllocateStaticChunkTransparent(std::vector<ChunkVertex>& vert
   uint32_t handle = next_static_chunk_handle_++;
   uint32_t ebo_handle = static_transparent_chunk_ebo_.Allocate(sizeof(uint32_t) * indices.size(),
                                                                indices.data(), chunk_ebo_offset);
+  if (!ebo_handle) {
+    stats_.failed_chunk_allocs++;
+    return 0;
+  }
   uint32_t vbo_handle = static_transparent_chunk_vbo_.Allocate(
       sizeof(ChunkVertex) * vertices.size(), vertices.data(), chunk_vbo_offset,
       {
@@ -952,6 +963,11 @@ uint32_t Renderer::AllocateStaticChunkTransparent(std::vector<ChunkVertex>& vert
           .first_index = static_cast<uint32_t>(chunk_ebo_offset / sizeof(uint32_t)),
           .count = static_cast<uint32_t>(indices.size()),
       });
+  if (!vbo_handle) {
+    static_transparent_chunk_ebo_.Free(ebo_handle);
+    stats_.failed_chunk_allocs++;
+    return 0;
+  }
   static_chunk_allocs_.try_emplace(handle,
                                    MeshAlloc{
                                        .vbo_handle = vbo_handle,
@@ -974,6 +990,8 @@ uint32_t Renderer::AllocateStaticChunk(std::vector<ChunkVertex>& vertices,
     spdlog::error("no vertices or indices");
     return 0;
   }
+  static auto& upload_bytes = MetricsRegistry::Get().GetCounter("mesh.upload_bytes");
+  upload_bytes.Add(sizeof(ChunkVertex) * vertices.size() + sizeof(uint32_t) * indices.size());
   uint32_t chunk_vbo_offset;
   uint32_t chunk_ebo_offset;
   uint32_t handle = next_static_chunk_handle_++;
@@ -985,6 +1003,10 @@ uint32_t Renderer::AllocateStaticChunk(std::vector<ChunkVertex>& vertices,
   if (level == LODLevel::kRegular) {
     ebo_handle = static_chunk_ebo_.Allocate(sizeof(uint32_t) * indices.size(), indices.data(),
                                             chunk_ebo_offset);
+    if (!ebo_handle) {
+      stats_.failed_chunk_allocs++;
+      return 0;
+    }
     vbo_handle = static_chunk_vbo_.Allocate(
         sizeof(ChunkVertex) * vertices.size(), vertices.data(), chunk_vbo_offset,
         {
@@ -992,6 +1014,11 @@ uint32_t Renderer::AllocateStaticChunk(std::vector<ChunkVertex>& vertices,
             .first_index = static_cast<uint32_t>(chunk_ebo_offset / sizeof(uint32_t)),
             .count = static_cast<uint32_t>(indices.size()),
         });
+    if (!vbo_handle) {
+      static_chunk_ebo_.Free(ebo_handle);
+      stats_.failed_chunk_allocs++;
+      return 0;
+    }
     static_chunk_allocs_.try_emplace(handle,
                                      MeshAlloc{
                                          .vbo_handle = vbo_handle,
@@ -1007,6 +1034,10 @@ uint32_t Renderer::AllocateStaticChunk(std::vector<ChunkVertex>& vertices,
     max.y = kMaxBlockHeight;
     ebo_handle = lod_static_chunk_ebo_.Allocate(sizeof(uint32_t) * indices.size(), indices.data(),
                                                 chunk_ebo_offset);
+    if (!ebo_handle) {
+      stats_.failed_chunk_allocs++;
+      return 0;
+    }
     vbo_handle = lod_static_chunk_vbo_.Allocate(
         sizeof(ChunkVertex) * vertices.size(), vertices.data(), chunk_vbo_offset,
         {
@@ -1014,6 +1045,11 @@ uint32_t Renderer::AllocateStaticChunk(std::vector<ChunkVertex>& vertices,
             .first_index = static_cast<uint32_t>(chunk_ebo_offset / sizeof(uint32_t)),
             .count = static_cast<uint32_t>(indices.size()),
         });
+    if (!vbo_handle) {
+      lod_static_chunk_ebo_.Free(ebo_handle);
+      stats_.failed_chunk_allocs++;
+      return 0;
+    }
     lod_static_chunk_allocs_.try_emplace(
         handle, MeshAlloc{
                     .vbo_handle = vbo_handle,
@@ -1110,6 +1146,22 @@ void Renderer::FreeChunkMesh(uint32_t& handle) {
   chunk_allocs_.erase(it);
 }
 
+ChunkMeshSink::MeshBufferUsage Renderer::GetMeshBufferUsage() const {
+  MeshBufferUsage usage;
+  auto occupancy = [](const auto& buffer) {
+    auto buffer_usage = buffer.GetUsage();
+    if (!buffer_usage.capacity_bytes) return 0.f;
+    return 1.f - static_cast<float>(buffer_usage.largest_free_bytes) /
+                     static_cast<float>(buffer_usage.capacity_bytes);
+  };
+  usage.occupancy = std::max({occupancy(static_chunk_vbo_), occupancy(static_chunk_ebo_),
+                              occupancy(static_transparent_chunk_vbo_),
+                              occupancy(static_transparent_chunk_ebo_),
+                              occupancy(lod_static_chunk_vbo_), occupancy(lod_static_chunk_ebo_)});
+  usage.failed_allocs = stats_.failed_chunk_allocs;
+  return usage;
+}
+
 void Renderer::FreeStaticChunkMeshTransparent(uint32_t& handle) {
   if (handle == 0) return;
   static_transparent_chunk_buffer_dirty_ = true;
@@ -1121,8 +1173,8 @@ void Renderer::FreeStaticChunkMeshTransparent(uint32_t& handle) {
   }
   stats_.total_chunk_indices -= it->second.indices_count;
   stats_.total_chunk_vertices -= it->second.vertices_count;
-  static_transparent_chunk_vbo_.Free(it->second.vbo_handle);
-  static_transparent_chunk_ebo_.Free(it->second.ebo_handle);
+  static_transparent_chunk_vbo_.QueueFree(it->second.vbo_handle);
+  static_transparent_chunk_ebo_.QueueFree(it->second.ebo_handle);
   stats_.transparent_chunk_allocs--;
   static_chunk_allocs_.erase(it);
 }
@@ -1140,8 +1192,8 @@ void Renderer::FreeStaticChunkMesh(uint32_t& handle) {
     stats_.total_chunk_indices -= it->second.indices_count;
     stats_.total_chunk_vertices -= it->second.vertices_count;
     stats_.opaque_chunk_allocs--;
-    static_chunk_vbo_.Free(it->second.vbo_handle);
-    static_chunk_ebo_.Free(it->second.ebo_handle);
+    static_chunk_vbo_.QueueFree(it->second.vbo_handle);
+    static_chunk_ebo_.QueueFree(it->second.ebo_handle);
     static_chunk_allocs_.erase(it);
   } else {
     lod_static_chunk_buffer_dirty_ = true;
@@ -1155,12 +1207,24 @@ void Renderer::FreeStaticChunkMesh(uint32_t& handle) {
     stats_.total_chunk_vertices -= it->second.vertices_count;
     stats_.lod_chunk_indices -= it->second.indices_count;
     stats_.lod_chunk_indices -= it->second.vertices_count;
-    lod_static_chunk_vbo_.Free(it->second.vbo_handle);
-    lod_static_chunk_ebo_.Free(it->second.ebo_handle);
+    lod_static_chunk_vbo_.QueueFree(it->second.vbo_handle);
+    lod_static_chunk_ebo_.QueueFree(it->second.ebo_handle);
     lod_static_chunk_allocs_.erase(it);
   }
 }
 
+void Renderer::FlushStaticChunkFrees() {
+  ZoneScoped;
+  // unloading a ring of columns frees hundreds of meshes, one merge per buffer instead of a scan
+  // and erase each
+  static_chunk_vbo_.FlushFrees();
+  static_chunk_ebo_.FlushFrees();
+  static_transparent_chunk_vbo_.FlushFrees();
+  static_transparent_chunk_ebo_.FlushFrees();
+  lod_static_chunk_vbo_.FlushFrees();
+  lod_static_chunk_ebo_.FlushFrees();
+}
+
 void Renderer::RemoveStaticMeshes() {
   static_textured_quad_uniforms_.clear();
   stats_.textured_quad_draw_calls = 0;
@@ -1208,74 +1272,73 @@ bool Renderer::OnEvent(const SDL_Event& event) {
 }
 
 void Renderer::LoadShaders() {
-  ShaderManager::Get().AddShader("quad",
-                                 {{GET_SHADER_PATH("quad.vs.glsl"), ShaderType::kVertex},
-                                  {GET_SHADER_PATH("quad.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader("block",
-                                 {{GET_SHADER_PATH("block.vs.glsl"), ShaderType::kVertex},
-                                  {GET_SHADER_PATH("block.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader("skybox",
-                                 {{GET_SHADER_PATH("skybox.vs.glsl"), ShaderType::kVertex},
-                                  {GET_SHADER_PATH("skybox.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader("sky", {{GET_SHADER_PATH("sky.vs.glsl"), ShaderType::kVertex},
-                                         {GET_SHADER_PATH("sky.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader("color",
-                                 {{GET_SHADER_PATH("color.vs.glsl"), ShaderType::kVertex},
-                                  {GET_SHADER_PATH("color.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader("non_batch_depth",
-                                 {{GET_SHADER_PATH("non_batch_depth.vs.glsl"), ShaderType::kVertex},
-                                  {GET_SHADER_PATH("empty.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader("non_batch",
-                                 {{GET_SHADER_PATH("non_batch.vs.glsl"), ShaderType::kVertex},
-                                  {GET_SHADER_PATH("non_batch.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader(
+  auto& shader_manager = ShaderManager::Get();
+  shader_manager.QueueShader("quad", {{GET_SHADER_PATH("quad.vs.glsl"), ShaderType::kVertex},
+                                      {GET_SHADER_PATH("quad.fs.glsl"), ShaderType::kFragment}});
+  shader_manager.QueueShader("block", {{GET_SHADER_PATH("block.vs.glsl"), ShaderType::kVertex},
+                                       {GET_SHADER_PATH("block.fs.glsl"), ShaderType::kFragment}});
+  shader_manager.QueueShader(
+      "skybox", {{GET_SHADER_PATH("skybox.vs.glsl"), ShaderType::kVertex},
+                 {GET_SHADER_PATH("skybox.fs.glsl"), ShaderType::kFragment}});
+  shader_manager.QueueShader("sky", {{GET_SHADER_PATH("sky.vs.glsl"), ShaderType::kVertex},
+                                     {GET_SHADER_PATH("sky.fs.glsl"), ShaderType::kFragment}});
+  shader_manager.QueueShader("color", {{GET_SHADER_PATH("color.vs.glsl"), ShaderType::kVertex},
+                                       {GET_SHADER_PATH("color.fs.glsl"), ShaderType::kFragment}});
+  shader_manager.QueueShader(
+      "non_batch_depth", {{GET_SHADER_PATH("non_batch_depth.vs.glsl"), ShaderType::kVertex},
+                          {GET_SHADER_PATH("empty.fs.glsl"), ShaderType::kFragment}});
+  shader_manager.QueueShader(
+      "non_batch", {{GET_SHADER_PATH("non_batch.vs.glsl"), ShaderType::kVertex},
+                    {GET_SHADER_PATH("non_batch.fs.glsl"), ShaderType::kFragment}});
+  shader_manager.QueueShader(
       "color_single", {{GET_SHADER_PATH("color_single.vs.glsl"), ShaderType::kVertex},
                        {GET_SHADER_PATH("color_single.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader(
+  shader_manager.QueueShader(
       "debug_depth_quad", {{GET_SHADER_PATH("debug_depth_quad.vs.glsl"), ShaderType::kVertex},
                            {GET_SHADER_PATH("debug_depth_quad.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader(
+  shader_manager.QueueShader(
       "chunk_batch_block", {{GET_SHADER_PATH("chunk_batch_block.vs.glsl"), ShaderType::kVertex},
                             {GET_SHADER_PATH("chunk_batch_block.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader("chunk_batch",
-                                 {{GET_SHADER_PATH("chunk_batch.vs.glsl"), ShaderType::kVertex},
-                                  {GET_SHADER_PATH("chunk_batch.fs.glsl"), ShaderType::kFragment}});
-  // ShaderManager::Get().AddShader(
+  shader_manager.QueueShader(
+      "chunk_batch", {{GET_SHADER_PATH("chunk_batch.vs.glsl"), ShaderType::kVertex},
+                      {GET_SHADER_PATH("chunk_batch.fs.glsl"), ShaderType::kFragment}});
+  // shader_manager.QueueShader(
   //     "chunk_batch_depth", {{GET_SHADER_PATH("chunk_batch_depth.vs.glsl"), ShaderType::kVertex},
   //                           {GET_SHADER_PATH("shadow_map_depth.gs.glsl"), ShaderType::kGeometry},
   //                           {GET_SHADER_PATH("empty.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader(
+  shader_manager.QueueShader(
       "chunk_batch_depth", {{GET_SHADER_PATH("chunk_batch_depth.vs.glsl"), ShaderType::kVertex},
                             {GET_SHADER_PATH("chunk_batch_depth.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader(
+  shader_manager.QueueShader(
       "chunk_batch_block_depth",
       {{GET_SHADER_PATH("chunk_batch_block_depth.vs.glsl"), ShaderType::kVertex},
        {GET_SHADER_PATH("empty.fs.glsl"), ShaderType::kFragment}});
-  // ShaderManager::Get().AddShader(
+  // shader_manager.QueueShader(
   //     "lod_chunk_batch_depth",
   //     {{GET_SHADER_PATH("lod_chunk_batch_depth.vs.glsl"), ShaderType::kVertex},
   //      {GET_SHADER_PATH("shadow_map_depth.gs.glsl"), ShaderType::kGeometry},
   //      {GET_SHADER_PATH("empty.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader(
+  shader_manager.QueueShader(
       "lod_chunk_batch_depth",
       {{GET_SHADER_PATH("lod_chunk_batch_depth.vs.glsl"), ShaderType::kVertex},
        {GET_SHADER_PATH("empty.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader(
+  shader_manager.QueueShader(
       "lod_chunk_batch", {{GET_SHADER_PATH("lod_chunk_batch.vs.glsl"), ShaderType::kVertex},
                           {GET_SHADER_PATH("lod_chunk_batch.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader(
+  shader_manager.QueueShader(
       "single_texture", {{GET_SHADER_PATH("single_texture.vs.glsl"), ShaderType::kVertex},
                          {GET_SHADER_PATH("single_texture.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader(
+  shader_manager.QueueShader(
       "block_outline", {{GET_SHADER_PATH("block_outline.vs.glsl"), ShaderType::kVertex},
                         {GET_SHADER_PATH("block_outline.gs.glsl"), ShaderType::kGeometry},
                         {GET_SHADER_PATH("block_outline.fs.glsl"), ShaderType::kFragment}});
-  ShaderManager::Get().AddShader("chunk_cull",
-                                 {{GET_SHADER_PATH("chunk_cull.cs.glsl"), ShaderType::kCompute}});
-  ShaderManager::Get().AddShader(
+  shader_manager.QueueShader("chunk_cull",
+                             {{GET_SHADER_PATH("chunk_cull.cs.glsl"), ShaderType::kCompute}});
+  shader_manager.QueueShader(
       "cascade_volume_vis",
       {{GET_SHADER_PATH("shadows/cascade_volume_vis.vs.glsl"), ShaderType::kVertex},
        {GET_SHADER_PATH("shadows/cascade_volume_vis.fs.glsl"), ShaderType::kFragment}});
+  shader_manager.FinishQueuedShaders();
 }
 
 void Renderer::OnImGui() {
@@ -1291,15 +1354,53 @@ void Renderer::OnImGui() {
   ImGui::Text("Chunk Indices: %i", stats_.total_chunk_indices);
   ImGui::Text("Static Chunk VBO Allocs: %i", static_chunk_vbo_.NumActiveAllocs());
   ImGui::Text("Static Chunk EBO Allocs: %i", static_chunk_ebo_.NumActiveAllocs());
+  ImGui::Text("Static Chunk Pending Frees: %zu", static_chunk_vbo_.NumPendingFrees());
   ImGui::Checkbox("Cull Frustum", &settings.cull_frustum);
   ImGui::Checkbox("Chunk Use Texture", &settings.chunk_render_use_texture);
   ImGui::Checkbox("Chunk Use AO", &settings.chunk_use_ao);
+  ImGui::Checkbox("Chunk Use Lighting", &settings.chunk_use_lighting);
   ImGui::Checkbox("Peter Panning Front Face Cull", &settings.peter_panning_front_face);
   ImGui::Checkbox("Cascade Debug Colors", &settings.cascade_debug_colors);
   ImGui::SliderInt("Extra FOV Degrees", &settings.extra_fov_degrees, 0, 360);
   ImGui::SliderFloat("Chunk Cull Distance Min", &settings.chunk_cull_distance_min, 0, 10000);
   ImGui::SliderFloat("Chunk Cull Distance Max", &settings.chunk_cull_distance_max, 0, 10000);
   // ImGui::SliderFloat3("Dir light dir", &light_dir_.x, -1, 1);
+  if (ImGui::CollapsingHeader("Memory##renderer_memory")) {
+    constexpr double kMB = 1024.0 * 1024.0;
+    if (ImGui::BeginTable("chunk buffers", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+      for (const char* header :
+           {"buffer", "capacity MB", "used MB", "free MB", "largest free MB", "fragmentation"}) {
+        ImGui::TableSetupColumn(header);
+      }
+      ImGui::TableHeadersRow();
+      auto buffer_row = [](const char* name, const auto& buffer) {
+        auto usage = buffer.GetUsage();
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(name);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", static_cast<double>(usage.capacity_bytes) / kMB);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", static_cast<double>(usage.used_bytes) / kMB);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", static_cast<double>(usage.free_bytes) / kMB);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", static_cast<double>(usage.largest_free_bytes) / kMB);
+        ImGui::TableNextColumn();
+        ImGui::Text("%.3f (%u blocks)", usage.Fragmentation(), usage.free_blocks);
+      };
+      buffer_row("Static VBO", static_chunk_vbo_);
+      buffer_row("Static EBO", static_chunk_ebo_);
+      buffer_row("Transparent VBO", static_transparent_chunk_vbo_);
+      buffer_row("Transparent EBO", static_transparent_chunk_ebo_);
+      buffer_row("LOD VBO", lod_static_chunk_vbo_);
+      buffer_row("LOD EBO", lod_static_chunk_ebo_);
+      ImGui::EndTable();
+    }
+    ImGui::Text("Failed chunk allocs: %lu", static_cast<unsigned long>(stats_.failed_chunk_allocs));
+    ImGui::Text("Textures: %zu, %.2f MB", TextureManager::Get().NumTextures(),
+                static_cast<double>(TextureManager::Get().GetMemoryBytes()) / kMB);
+  }
 
   ImGui::End();
 }
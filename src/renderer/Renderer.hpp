@@ -4,6 +4,7 @@
 #include <glm/vec2.hpp>
 
 #include "gameplay/world/ChunkDef.hpp"
+#include "gameplay/world/ChunkMeshSink.hpp"
 #include "renderer/Common.hpp"
 #include "renderer/opengl/Buffer.hpp"
 #include "renderer/opengl/DynamicBuffer.hpp"
@@ -38,10 +39,10 @@ constexpr const int kCascadeLevels = 5;
 using FrustumCorners = std::array<glm::vec4, 8>;
 using LightSpaceMatrices = std::array<glm::mat4, kCascadeLevels>;
 
-class Renderer {
+class Renderer : public ChunkMeshSink {
  public:
   static Renderer& Get();
-  ~Renderer();
+  ~Renderer() override;
   static void Init(Window& window);
   static void Shutdown();
   void OnImGui();
@@ -60,10 +61,10 @@ class Renderer {
                                 uint32_t material_handle);
   [[nodiscard]] uint32_t AllocateStaticChunk(std::vector<ChunkVertex>& vertices,
                                              std::vector<uint32_t>& indices, const glm::ivec3& pos,
-                                             LODLevel level);
+                                             LODLevel level) override;
   [[nodiscard]] uint32_t AllocateStaticChunkTransparent(std::vector<ChunkVertex>& vertices,
                                                         std::vector<uint32_t>& indices,
-                                                        const glm::ivec3& pos);
+                                                        const glm::ivec3& pos) override;
   uint32_t next_static_chunk_handle_{1};
 
   [[nodiscard]] uint32_t AllocateChunk(std::vector<ChunkVertex>& vertices,
@@ -84,8 +85,9 @@ class Renderer {
   uint32_t fbo1_depth_tex_{};
   uint32_t rbo1_{};
 
-  void FreeStaticChunkMesh(uint32_t& handle);
-  void FreeStaticChunkMeshTransparent(uint32_t& handle);
+  void FreeStaticChunkMesh(uint32_t& handle) override;
+  void FreeStaticChunkMeshTransparent(uint32_t& handle) override;
+  [[nodiscard]] MeshBufferUsage GetMeshBufferUsage() const override;
   void FreeChunkMesh(uint32_t& handle);
   void FreeRegMesh(uint32_t& handle);
   [[nodiscard]] uint32_t AllocateMaterial(TextureMaterialData& material);
@@ -104,6 +106,7 @@ class Renderer {
     bool cull_frustum{true};
     bool chunk_render_use_texture{true};
     bool chunk_use_ao{true};
+    bool chunk_use_lighting{true};
     bool draw_lines{true};
     bool draw_skybox{true};
     bool draw_chunks{true};
@@ -143,6 +146,8 @@ class Renderer {
   void DrawStaticOpaqueNonLODChunks(const RenderInfo& render_info, ShaderFunc non_lod_shader_func);
 
   void DrawStaticTransparentChunks(const RenderInfo& render_info);
+  // applies the frame's queued static chunk frees to the buffers before they're drawn
+  void FlushStaticChunkFrees();
   template <CallableNoArgs ShaderFunc>
   void DrawNonStaticChunks(const RenderInfo& render_info, ShaderFunc shader_func);
   void DrawStaticChunksImpl(const RenderInfo& render_info);
@@ -343,6 +348,7 @@ class Renderer {
     uint32_t total_reg_mesh_indices{0};
     uint32_t opaque_chunk_allocs{0};
     uint32_t transparent_chunk_allocs{0};
+    uint64_t failed_chunk_allocs{0};
   };
   Stats stats_;
   float z_mult_light_space_matrix_{3};
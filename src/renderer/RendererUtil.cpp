@@ -17,7 +17,9 @@
 #include "renderer/opengl/Buffer.hpp"
 #include "renderer/opengl/Texture2d.hpp"
 #include "renderer/opengl/VertexArray.hpp"
+#include "resource/ImageLoader.hpp"
 #include "resource/MaterialManager.hpp"
+#include "resource/TextureManager.hpp"
 #include "util/LoadFile.hpp"
 #include "util/Paths.hpp"
 
@@ -191,29 +193,49 @@ void LoadIcons(std::vector<Image>& images) {
   }
 }
 
-SquareTextureAtlas LoadIconTextureAtlas(const std::string& tex_name, const BlockDB& block_db,
-                                        const Texture& tex_arr) {
-  SquareTextureAtlas res;
-  // Load icons into atlas for ImGui
-  std::vector<std::pair<uint32_t, Image>> images;
+std::vector<IconSource> PrepareIcons(const BlockDB& block_db, const Texture& tex_arr) {
+  ZoneScoped;
+  std::vector<IconSource> icons;
   for (const auto& data : block_db.GetBlockData()) {
     if (data.id == 0) continue;
-    Image img;
     std::filesystem::path path =
         GET_PATH("resources/icons") / std::filesystem::path(data.name + ".png");
     if (!std::filesystem::exists(path)) {
       spdlog::info("{} rendering and writing", path.string());
       util::renderer::RenderAndWriteIcon(path, block_db.GetMeshData()[data.id], tex_arr);
     }
-    util::LoadImage(img, path.string(), 0);
-    images.emplace_back(data.id, img);
+    icons.push_back({data.id, path.string()});
+  }
+  return icons;
+}
+
+DecodedIcons DecodeIcons(const std::vector<IconSource>& icons) {
+  ZoneScoped;
+  std::vector<std::string> paths;
+  paths.reserve(icons.size());
+  for (const auto& icon : icons) paths.emplace_back(icon.path);
+  ImageLoader loader;
+  auto decoded = loader.Load(paths, {.flip = true});
+  DecodedIcons res;
+  for (size_t i = 0; i < decoded.size(); i++) {
+    if (!decoded[i].IsValid()) continue;
+    res.ids.emplace_back(icons[i].block_id);
+    res.images.emplace_back(std::move(decoded[i]));
   }
+  return res;
+}
 
-  uint32_t num_textures_wide = glm::ceil(glm::sqrt(images.size()));
-  res.dims.x = num_textures_wide * images.front().second.width;
-  res.dims.y = num_textures_wide * images.front().second.height;
-  res.image_dims.x = images.front().second.width;
-  res.image_dims.y = images.front().second.height;
+SquareTextureAtlas CreateIconTextureAtlas(const std::string& tex_name, const DecodedIcons& icons) {
+  ZoneScoped;
+  SquareTextureAtlas res;
+  if (icons.images.empty()) return res;
+
+  const DecodedImage& first = icons.images.front();
+  uint32_t num_textures_wide = glm::ceil(glm::sqrt(icons.images.size()));
+  res.dims.x = num_textures_wide * first.width;
+  res.dims.y = num_textures_wide * first.height;
+  res.image_dims.x = first.width;
+  res.image_dims.y = first.height;
 
   MaterialManager::Get().Erase(tex_name);
   res.material = MaterialManager::Get().LoadTextureMaterial(
@@ -223,35 +245,84 @@ SquareTextureAtlas LoadIconTextureAtlas(const std::string& tex_name, const Block
   size_t i = 0;
   for (uint32_t row = 0; row < num_textures_wide; row++) {
     for (uint32_t col = 0; col < num_textures_wide; col++, i++) {
-      if (i >= images.size()) break;
+      if (i >= icons.images.size()) break;
       uint32_t x_offset = row * res.image_dims.x;
       uint32_t y_offset = col * res.image_dims.y;
       glTextureSubImage2D(res.material->GetTexture().Id(), 0, x_offset, y_offset, res.image_dims.x,
-                          res.image_dims.y, GL_RGBA, GL_UNSIGNED_BYTE, images[i].second.pixels);
-      res.id_to_offset_map.emplace(images[i].first, glm::vec2{x_offset, y_offset});
+                          res.image_dims.y, GL_RGBA, GL_UNSIGNED_BYTE,
+                          icons.images[i].levels.front().data());
+      res.id_to_offset_map.emplace(icons.ids[i], glm::vec2{x_offset, y_offset});
     }
   }
+  return res;
+}
+
+SquareTextureAtlas LoadIconTextureAtlas(const std::string& tex_name, const BlockDB& block_db,
+                                        const Texture& tex_arr) {
+  ZoneScoped;
+  return CreateIconTextureAtlas(tex_name, DecodeIcons(PrepareIcons(block_db, tex_arr)));
+}
+
+DecodedBlockTextures DecodeBlockTextures(const std::vector<std::string>& tex_names) {
+  ZoneScoped;
+  std::vector<std::string> paths;
+  paths.reserve(tex_names.size());
+  for (const auto& tex_name : tex_names) {
+    paths.emplace_back(GET_PATH("resources/textures/" + tex_name + ".png"));
+  }
+  ImageLoader loader;
+  auto decoded = loader.Load(paths, {.flip = true, .generate_mipmaps = true});
 
-  for (const auto& image : images) {
-    if (image.second.pixels) util::FreeImage(image.second.pixels);
+  DecodedBlockTextures res;
+  for (size_t i = 0; i < decoded.size(); i++) {
+    DecodedImage& image = decoded[i];
+    // TODO: handle other sizes/animations
+    if (image.width != 32 || image.height != 32) continue;
+    res.tex_name_to_idx[tex_names[i]] = res.images.size();
+    res.avg_colors.emplace_back(image.avg_color);
+    res.images.emplace_back(std::move(image));
   }
   return res;
 }
 
-TransparencyType LoadImageAndCheckHasTransparency(const std::string& path, int required_channels) {
-  Image img;
-  util::LoadImage(img, path, required_channels);
-  TransparencyType type = TransparencyType::kNone;
-  if (img.channels != 4) return type;
-  for (int i = 0; i < img.channels * img.width * img.height; i += 4) {
-    if (*(img.pixels + i + 3) < 255) {
-      type = TransparencyType::kAllOrNone;
-      if (*(img.pixels + i + 3) > 0) {
-        type = TransparencyType::kSemi;
-      }
+std::shared_ptr<Texture> CreateBlockTextureArray(const DecodedBlockTextures& textures) {
+  Texture2DArrayCreateParamsEmpty params{.width = 0,
+                                         .height = 0,
+                                         .layers = static_cast<uint32_t>(textures.images.size()),
+                                         .internal_format = GL_RGBA8,
+                                         .filter_mode_min = GL_NEAREST_MIPMAP_LINEAR,
+                                         .filter_mode_max = GL_NEAREST,
+                                         .texture_wrap = GL_REPEAT};
+  if (!textures.images.empty()) {
+    const DecodedImage& first = textures.images.front();
+    params.width = first.width;
+    params.height = first.height;
+    params.mip_levels = first.NumLevels();
+  }
+  return TextureManager::Get().Load(params);
+}
+
+void UploadBlockTextureLayers(const Texture& tex_arr, const DecodedBlockTextures& textures,
+                              size_t begin, size_t end) {
+  ZoneScoped;
+  for (size_t layer = begin; layer < end && layer < textures.images.size(); layer++) {
+    const DecodedImage& image = textures.images[layer];
+    for (int level = 0; level < image.NumLevels(); level++) {
+      tex_arr.SubImageLayer(layer, level, image.GetLevel(level), GL_RGBA);
     }
   }
-  return type;
-  util::FreeImage(img.pixels);
+}
+
+std::shared_ptr<Texture> LoadBlockTextureArray(
+    const std::vector<std::string>& tex_names,
+    std::unordered_map<std::string, uint32_t>& tex_name_to_idx,
+    std::vector<glm::ivec3>& tex_avg_colors) {
+  ZoneScoped;
+  auto textures = DecodeBlockTextures(tex_names);
+  tex_name_to_idx = std::move(textures.tex_name_to_idx);
+  tex_avg_colors = std::move(textures.avg_colors);
+  auto tex_arr = CreateBlockTextureArray(textures);
+  UploadBlockTextureLayers(*tex_arr, textures, 0, textures.images.size());
+  return tex_arr;
 }
 }  // namespace util::renderer
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "resource/ImageLoader.hpp"
+
 struct BlockData;
 struct BlockMeshData;
 class Texture;
@@ -7,7 +9,6 @@ struct Image;
 class BlockDB;
 class TextureMaterial;
 struct SquareTextureAtlas;
-enum class TransparencyType;
 
 namespace util::renderer {
 extern void RenderAndWriteIcons(const std::vector<BlockData>& block_data,
@@ -16,9 +17,42 @@ extern void RenderAndWriteIcons(const std::vector<BlockData>& block_data,
 extern void RenderAndWriteIcon(const std::string& path, const BlockMeshData& mesh_data,
                                const Texture& tex_arr);
 extern void LoadIcons(std::vector<Image>& images);
-extern TransparencyType LoadImageAndCheckHasTransparency(const std::string& path,
-                                                         int required_channels = 0);
 extern SquareTextureAtlas LoadIconTextureAtlas(const std::string& tex_name, const BlockDB& block_db,
                                                const Texture& tex_arr);
+// Decodes resources/textures/<name>.png for each name in parallel and builds the chunk texture
+// array with mips built during decode. Only 32x32 textures get an index.
+extern std::shared_ptr<Texture> LoadBlockTextureArray(
+    const std::vector<std::string>& tex_names,
+    std::unordered_map<std::string, uint32_t>& tex_name_to_idx,
+    std::vector<glm::ivec3>& tex_avg_colors);
+
+// The steps of LoadIconTextureAtlas and LoadBlockTextureArray, for loading over several frames.
+// The Decode functions don't use GL and can run on any thread.
+struct IconSource {
+  uint32_t block_id;
+  std::string path;
+};
+struct DecodedIcons {
+  std::vector<uint32_t> ids;
+  std::vector<DecodedImage> images;
+};
+// Renders the icons missing from resources/icons.
+extern std::vector<IconSource> PrepareIcons(const BlockDB& block_db, const Texture& tex_arr);
+extern DecodedIcons DecodeIcons(const std::vector<IconSource>& icons);
+extern SquareTextureAtlas CreateIconTextureAtlas(const std::string& tex_name,
+                                                 const DecodedIcons& icons);
+
+struct DecodedBlockTextures {
+  // layer i of the texture array
+  std::vector<DecodedImage> images;
+  std::unordered_map<std::string, uint32_t> tex_name_to_idx;
+  std::vector<glm::ivec3> avg_colors;
+};
+extern DecodedBlockTextures DecodeBlockTextures(const std::vector<std::string>& tex_names);
+// Storage for every layer, filled by UploadBlockTextureLayers.
+extern std::shared_ptr<Texture> CreateBlockTextureArray(const DecodedBlockTextures& textures);
+// Uploads layers [begin, end) with their mips.
+extern void UploadBlockTextureLayers(const Texture& tex_arr, const DecodedBlockTextures& textures,
+                                     size_t begin, size_t end);
 
 }  // namespace util::renderer
@@ -1,8 +1,10 @@
 #include "ShaderManager.hpp"
 
 #include <fstream>
+#include <thread>
 
 #include "util/Paths.hpp"
+#include "util/Timer.hpp"
 
 ShaderManager *ShaderManager::instance_ = nullptr;
 
@@ -19,7 +21,8 @@ void ShaderManager::Shutdown() {
   delete instance_;
 }
 
-ShaderManager::ShaderManager() {
+ShaderManager::ShaderManager()
+    : preprocessor_(GET_SHADER_PATH("")), binary_cache_dir_(GET_PATH("resources/cache/shaders")) {
   EASSERT_MSG(instance_ == nullptr, "Cannot create two instances.");
   instance_ = this;
 }
@@ -35,13 +38,13 @@ std::optional<Shader> ShaderManager::GetShader(const std::string &name) {
 
 std::optional<Shader> ShaderManager::AddShader(
     const std::string &name, const std::vector<ShaderCreateInfo> &create_info_vec) {
-  auto result = ShaderManager::CompileProgram(name, create_info_vec);
-  if (!result.has_value()) {
+  QueueShader(name, create_info_vec);
+  FinishQueuedShaders();
+  auto it = shader_data_.find(name);
+  if (it == shader_data_.end()) {
     return std::nullopt;
   }
-  // spdlog::info("Compiled shader: {}, Id: {}", name, result->program_id);
-  shader_data_.emplace(name.data(), result.value());
-  return Shader{result->program_id, result->uniform_locations};
+  return Shader{it->second.program_id, it->second.uniform_locations};
 }
 
 bool CheckShaderModuleCompilationSuccess(uint32_t shader_id, const char *shaderPath) {
@@ -59,14 +62,13 @@ bool CheckShaderModuleCompilationSuccess(uint32_t shader_id, const char *shaderP
 static constexpr GLenum kShaderTypeToGl[] = {GL_VERTEX_SHADER, GL_FRAGMENT_SHADER,
                                              GL_GEOMETRY_SHADER, GL_COMPUTE_SHADER};
 
-bool CheckProgramLinkSuccess(GLuint id) {
-  glLinkProgram(id);
+bool CheckProgramLinkSuccess(GLuint id, const std::string &name) {
   int success;
   glGetProgramiv(id, GL_LINK_STATUS, &success);
   if (!success) {
     char buffer[512];
     glGetProgramInfoLog(id, 512, nullptr, buffer);
-    spdlog::error("Shader Link error {}", buffer);
+    spdlog::error("Shader Link error {}: {}", name, buffer);
     return false;
   }
   return true;
@@ -81,86 +83,273 @@ uint32_t CompileShader(ShaderType type, const char *src) {
 
 namespace {
 
-std::optional<std::string> PreprocessShader(const std::string &shader_file) {
-  std::ifstream file(shader_file);
-  if (!file.is_open()) {
-    return {};
+constexpr uint32_t kBinaryMagic = 0x4E494256;  // "VBIN"
+constexpr uint32_t kBinaryVersion = 1;
+
+struct BinaryHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t cache_key;
+  uint32_t format;
+  uint32_t length;
+};
+
+const char *GLString(GLenum name) {
+  const auto *str = reinterpret_cast<const char *>(glGetString(name));
+  return str ? str : "";
+}
+
+}  // namespace
+
+void ShaderManager::InitGLState() {
+  if (gl_state_initialized_) return;
+  gl_state_initialized_ = true;
+
+  driver_id_ = fmt::format("{}|{}|{}", GLString(GL_VENDOR), GLString(GL_RENDERER),
+                           GLString(GL_VERSION));
+  GLint num_binary_formats = 0;
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_binary_formats);
+  binary_cache_supported_ = num_binary_formats > 0;
+  if (binary_cache_supported_) {
+    std::error_code ec;
+    std::filesystem::create_directories(binary_cache_dir_, ec);
+    binary_cache_supported_ = !ec;
   }
 
-  std::ostringstream content;
-  std::string line;
+  // let the driver pick how many compiler threads to use
+  if (GLAD_GL_KHR_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    parallel_compile_supported_ = true;
+  } else if (GLAD_GL_ARB_parallel_shader_compile) {
+    glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+    parallel_compile_supported_ = true;
+  }
+  spdlog::info("Shader binary cache: {}, parallel compile: {}", binary_cache_supported_,
+               parallel_compile_supported_);
+}
 
-  while (std::getline(file, line)) {
-    if (line.find("#include") == 0) {
-      size_t start = line.find('\"') + 1;
-      size_t end = line.find('\"', start);
-      std::string include_file = line.substr(start, end - start);
-      std::string full_path = GET_SHADER_PATH("") + include_file;
+std::filesystem::path ShaderManager::BinaryCachePath(const std::string &name,
+                                                     uint64_t cache_key) const {
+  return binary_cache_dir_ / fmt::format("{:016x}_{}.bin", cache_key, name);
+}
 
-      // TODO: fix macro or make another way to get true path since this is hacky way to get
-      // macro to work
-      auto include_content = PreprocessShader(full_path);
-      if (!include_content.has_value()) {
-        return {};
-      }
-      content << include_content.value();
-    } else {
-      content << line << '\n';
+bool ShaderManager::LoadProgramBinary(uint32_t program_id, const std::string &name,
+                                      uint64_t cache_key) const {
+  auto path = BinaryCachePath(name, cache_key);
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) return false;
+  BinaryHeader header{};
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (!file || header.magic != kBinaryMagic || header.version != kBinaryVersion ||
+      header.cache_key != cache_key) {
+    return false;
+  }
+  std::vector<char> binary(header.length);
+  file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+  if (!file) return false;
+
+  glProgramBinary(program_id, header.format, binary.data(), static_cast<GLsizei>(header.length));
+  GLint success;
+  glGetProgramiv(program_id, GL_LINK_STATUS, &success);
+  if (!success) {
+    // the driver can reject binaries at any time, e.g. after an update, so compile and replace it
+    file.close();
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    return false;
+  }
+  return true;
+}
+
+void ShaderManager::SaveProgramBinary(uint32_t program_id, const std::string &name,
+                                      uint64_t cache_key) const {
+  GLint length = 0;
+  glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) return;
+  std::vector<char> binary(length);
+  GLenum format;
+  GLsizei written = 0;
+  glGetProgramBinary(program_id, length, &written, &format, binary.data());
+  if (written <= 0) return;
+
+  // binaries from older sources of this program would never be loaded again
+  std::error_code ec;
+  std::string suffix = fmt::format("_{}.bin", name);
+  for (const auto &entry : std::filesystem::directory_iterator(binary_cache_dir_, ec)) {
+    auto filename = entry.path().filename().string();
+    if (filename.size() == 16 + suffix.size() && filename.ends_with(suffix)) {
+      std::filesystem::remove(entry.path(), ec);
     }
   }
 
-  return content.str();
+  // write then rename so a crash mid write can't leave a truncated binary
+  auto path = BinaryCachePath(name, cache_key);
+  auto tmp_path = path;
+  tmp_path += ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return;
+    BinaryHeader header{kBinaryMagic, kBinaryVersion, cache_key, format,
+                        static_cast<uint32_t>(written)};
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(binary.data(), written);
+    if (!file) {
+      file.close();
+      std::filesystem::remove(tmp_path, ec);
+      return;
+    }
+  }
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) {
+    spdlog::warn("Failed to write shader binary {}: {}", path.string(), ec.message());
+  }
 }
-}  // namespace
 
-std::optional<ShaderManager::ShaderProgramData> ShaderManager::CompileProgram(
+std::optional<ShaderManager::PendingProgram> ShaderManager::StartProgram(
     const std::string &name, const std::vector<ShaderCreateInfo> &create_info_vec) {
-  std::vector<uint32_t> shader_ids;
+  InitGLState();
+  std::vector<std::string> sources;
+  std::vector<ShaderPreprocessor::Stage> stages;
+  sources.reserve(create_info_vec.size());
   for (const auto &create_info : create_info_vec) {
-    auto src = PreprocessShader(create_info.shaderPath);
+    auto src = preprocessor_.Preprocess(create_info.shaderPath);
     if (!src.has_value()) {
       spdlog::error("Failed to load from file {}", create_info.shaderPath);
       return std::nullopt;
     }
-    uint32_t shader_id = CompileShader(create_info.shaderType, src.value().c_str());
-    if (!CheckShaderModuleCompilationSuccess(shader_id, create_info.shaderPath.c_str())) {
-      spdlog::error("error: {}", create_info.shaderPath.c_str());
-      return std::nullopt;
+    sources.emplace_back(std::move(src.value()));
+  }
+  for (size_t i = 0; i < create_info_vec.size(); i++) {
+    stages.push_back({create_info_vec[i].shaderType, sources[i]});
+  }
+
+  PendingProgram pending;
+  pending.name = name;
+  pending.create_info_vec = create_info_vec;
+  pending.cache_key = ShaderPreprocessor::ProgramCacheKey(stages, driver_id_);
+  pending.program_id = glCreateProgram();
+  if (binary_cache_supported_) {
+    if (LoadProgramBinary(pending.program_id, name, pending.cache_key)) {
+      stats_.binary_hits++;
+      return pending;
     }
-    shader_ids.push_back(shader_id);
+    // start from a clean program rather than one with a rejected binary
+    glDeleteProgram(pending.program_id);
+    pending.program_id = glCreateProgram();
+    glProgramParameteri(pending.program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+
+  // statuses aren't queried until FinishProgram, so the driver can compile and link every
+  // queued program in the background
+  for (size_t i = 0; i < create_info_vec.size(); i++) {
+    uint32_t shader_id = CompileShader(create_info_vec[i].shaderType, sources[i].c_str());
+    glAttachShader(pending.program_id, shader_id);
+    pending.shader_ids.push_back(shader_id);
   }
+  glLinkProgram(pending.program_id);
+  stats_.compiled++;
+  return pending;
+}
+
+bool ShaderManager::IsProgramReady(const PendingProgram &pending) const {
+  if (pending.shader_ids.empty() || !parallel_compile_supported_) return true;
+  GLint complete = GL_FALSE;
+  glGetProgramiv(pending.program_id, GL_COMPLETION_STATUS_KHR, &complete);
+  return complete == GL_TRUE;
+}
 
-  uint32_t program_id = glCreateProgram();
-  for (auto &shader_id : shader_ids) {
-    glAttachShader(program_id, shader_id);
+std::optional<ShaderManager::ShaderProgramData> ShaderManager::FinishProgram(
+    PendingProgram &pending) {
+  bool success = true;
+  if (!pending.shader_ids.empty()) {
+    for (size_t i = 0; i < pending.shader_ids.size(); i++) {
+      success &= CheckShaderModuleCompilationSuccess(
+          pending.shader_ids[i], pending.create_info_vec[i].shaderPath.c_str());
+    }
+    success = success && CheckProgramLinkSuccess(pending.program_id, pending.name);
+    for (uint32_t shader_id : pending.shader_ids) {
+      glDetachShader(pending.program_id, shader_id);
+      glDeleteShader(shader_id);
+    }
+    if (success && binary_cache_supported_) {
+      SaveProgramBinary(pending.program_id, pending.name, pending.cache_key);
+    }
   }
-  glLinkProgram(program_id);
-  if (!CheckProgramLinkSuccess(program_id)) {
+  if (!success) {
+    glDeleteProgram(pending.program_id);
     return std::nullopt;
   }
 
   ShaderProgramData data;
-  data.program_id = program_id;
-  data.name = name;
-  data.create_info_vec = create_info_vec;
+  data.program_id = pending.program_id;
+  data.name = pending.name;
+  data.create_info_vec = std::move(pending.create_info_vec);
   data.InitializeUniforms();
   return data;
 }
 
+void ShaderManager::QueueShader(const std::string &name,
+                                const std::vector<ShaderCreateInfo> &create_info_vec) {
+  auto pending = StartProgram(name, create_info_vec);
+  if (!pending.has_value()) {
+    stats_.failed++;
+    return;
+  }
+  pending_.emplace_back(std::move(pending.value()));
+}
+
+void ShaderManager::FinishQueuedShaders() {
+  ZoneScoped;
+  Timer timer;
+  while (!pending_.empty()) {
+    bool finished_any = false;
+    for (size_t i = 0; i < pending_.size();) {
+      if (!IsProgramReady(pending_[i])) {
+        i++;
+        continue;
+      }
+      auto result = FinishProgram(pending_[i]);
+      if (result.has_value()) {
+        auto it = shader_data_.find(result->name);
+        if (it != shader_data_.end()) {
+          glDeleteProgram(it->second.program_id);
+          it->second = std::move(result.value());
+        } else {
+          shader_data_.emplace(result->name, std::move(result.value()));
+        }
+      } else {
+        stats_.failed++;
+      }
+      pending_[i] = std::move(pending_.back());
+      pending_.pop_back();
+      finished_any = true;
+    }
+    if (!finished_any) {
+      std::this_thread::yield();
+    }
+  }
+  if (stats_.compiled + stats_.binary_hits > 1) {
+    spdlog::info("Shaders: {} compiled, {} from binary cache, {} failed in {:.1f} ms",
+                 stats_.compiled, stats_.binary_hits, stats_.failed, timer.ElapsedMS());
+  }
+  stats_ = {};
+}
+
 std::optional<Shader> ShaderManager::RecompileShader(const std::string &name) {
   auto it = shader_data_.find(name);
   if (it == shader_data_.end()) {
     spdlog::warn("Shader not found, cannot recompile: {}", name.data());
     return std::nullopt;
   }
-  auto recompile_result = CompileProgram(name, it->second.create_info_vec);
-  if (!recompile_result.has_value()) {
+  uint32_t old_program_id = it->second.program_id;
+  QueueShader(name, it->second.create_info_vec);
+  FinishQueuedShaders();
+  it = shader_data_.find(name);
+  if (it->second.program_id == old_program_id) {
     return std::nullopt;
   }
   spdlog::info("Shader recompiled: {}", name.data());
-  shader_data_.erase(it);
-  auto new_it = shader_data_.emplace(name, recompile_result.value());
-  return Shader{new_it.first->second.program_id, new_it.first->second.uniform_locations};
+  return Shader{it->second.program_id, it->second.uniform_locations};
 }
 
 void ShaderManager::ShaderProgramData::InitializeUniforms() {
@@ -183,13 +372,14 @@ void ShaderManager::ShaderProgramData::InitializeUniforms() {
 }
 
 void ShaderManager::RecompileShaders() {
-  // have to avoid iterator invalidation
-  std::vector<std::string> shader_names;
-  shader_names.reserve(shader_data_.size());
+  // queued together so they recompile in parallel, unchanged sources load from the binary cache
+  std::vector<std::pair<std::string, std::vector<ShaderCreateInfo>>> programs;
+  programs.reserve(shader_data_.size());
   for (auto &shader_data : shader_data_) {
-    shader_names.emplace_back(shader_data.second.name.data());
+    programs.emplace_back(shader_data.second.name, shader_data.second.create_info_vec);
   }
-  for (const auto &shader_name : shader_names) {
-    RecompileShader(shader_name);
+  for (const auto &[name, create_info_vec] : programs) {
+    QueueShader(name, create_info_vec);
   }
+  FinishQueuedShaders();
 }
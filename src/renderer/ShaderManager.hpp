@@ -1,9 +1,8 @@
 #pragma once
 
+#include "renderer/ShaderPreprocessor.hpp"
 #include "renderer/opengl/Shader.hpp"
 
-enum class ShaderType { kVertex, kFragment, kGeometry, kCompute };
-
 struct ShaderCreateInfo {
   std::string shaderPath;
   ShaderType shaderType;
@@ -17,6 +16,12 @@ class ShaderManager {
   std::optional<Shader> GetShader(const std::string& name);
   std::optional<Shader> AddShader(const std::string& name,
                                   const std::vector<ShaderCreateInfo>& create_info_vec);
+  // Starts compiling and linking without waiting on the driver. Programs queued together compile
+  // in parallel when the driver supports parallel shader compile. None are usable until
+  // FinishQueuedShaders.
+  void QueueShader(const std::string& name, const std::vector<ShaderCreateInfo>& create_info_vec);
+  // Waits for every queued program, replacing existing programs of the same name on success.
+  void FinishQueuedShaders();
   std::optional<Shader> RecompileShader(const std::string& name);
   void RecompileShaders();
 
@@ -33,7 +38,39 @@ class ShaderManager {
     void InitializeUniforms();
   };
 
-  std::optional<ShaderProgramData> CompileProgram(
-      const std::string& name, const std::vector<ShaderCreateInfo>& create_info_vec);
+  struct PendingProgram {
+    std::string name;
+    std::vector<ShaderCreateInfo> create_info_vec;
+    uint32_t program_id{0};
+    // empty when the program was loaded from a cached binary
+    std::vector<uint32_t> shader_ids;
+    uint64_t cache_key{0};
+  };
+
+  void InitGLState();
+  std::optional<PendingProgram> StartProgram(const std::string& name,
+                                             const std::vector<ShaderCreateInfo>& create_info_vec);
+  [[nodiscard]] bool IsProgramReady(const PendingProgram& pending) const;
+  std::optional<ShaderProgramData> FinishProgram(PendingProgram& pending);
+  [[nodiscard]] std::filesystem::path BinaryCachePath(const std::string& name,
+                                                      uint64_t cache_key) const;
+  bool LoadProgramBinary(uint32_t program_id, const std::string& name, uint64_t cache_key) const;
+  void SaveProgramBinary(uint32_t program_id, const std::string& name, uint64_t cache_key) const;
+
   std::unordered_map<std::string, ShaderProgramData> shader_data_;
+  std::vector<PendingProgram> pending_;
+  ShaderPreprocessor preprocessor_;
+  std::filesystem::path binary_cache_dir_;
+  std::string driver_id_;
+  bool gl_state_initialized_{false};
+  bool binary_cache_supported_{false};
+  bool parallel_compile_supported_{false};
+
+  struct Stats {
+    uint32_t compiled{};
+    uint32_t binary_hits{};
+    uint32_t failed{};
+  };
+  // of the current batch
+  Stats stats_;
 };
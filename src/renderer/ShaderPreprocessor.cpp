@@ -0,0 +1,125 @@
+#include "ShaderPreprocessor.hpp"
+
+#include "util/LoadFile.hpp"
+
+namespace {
+
+// deeper than any real include chain, stops include cycles
+constexpr int kMaxIncludeDepth = 32;
+
+// FNV-1a
+constexpr uint64_t kFnvOffset = 14695981039346656037ull;
+constexpr uint64_t kFnvPrime = 1099511628211ull;
+
+void HashBytes(uint64_t& hash, const void* data, size_t size) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= kFnvPrime;
+  }
+}
+
+void HashString(uint64_t& hash, std::string_view str) {
+  // length first so ("ab", "c") and ("a", "bc") differ
+  uint64_t len = str.size();
+  HashBytes(hash, &len, sizeof(len));
+  HashBytes(hash, str.data(), str.size());
+}
+
+}  // namespace
+
+ShaderPreprocessor::FileSource ShaderPreprocessor::DiskFileSource() {
+  return {.read = [](const std::string& path) { return util::LoadFromFile(path); },
+          .stamp = [](const std::string& path) -> std::optional<int64_t> {
+            std::error_code ec;
+            auto time = std::filesystem::last_write_time(path, ec);
+            if (ec) return std::nullopt;
+            return static_cast<int64_t>(time.time_since_epoch().count());
+          }};
+}
+
+ShaderPreprocessor::ShaderPreprocessor(std::string include_dir, FileSource source)
+    : include_dir_(std::move(include_dir)), source_(std::move(source)) {}
+
+std::optional<std::string> ShaderPreprocessor::Preprocess(const std::string& path) {
+  std::vector<Dependency> deps;
+  return Expand(path, deps, 0);
+}
+
+bool ShaderPreprocessor::IsValid(const CacheEntry& entry) const {
+  return std::ranges::all_of(entry.deps, [this](const Dependency& dep) {
+    auto stamp = source_.stamp(dep.path);
+    return stamp.has_value() && stamp.value() == dep.stamp;
+  });
+}
+
+std::optional<std::string> ShaderPreprocessor::Expand(const std::string& path,
+                                                      std::vector<Dependency>& deps, int depth) {
+  if (depth > kMaxIncludeDepth) {
+    spdlog::error("Shader include depth exceeded, include cycle? {}", path);
+    return std::nullopt;
+  }
+
+  auto it = cache_.find(path);
+  if (it != cache_.end() && IsValid(it->second)) {
+    stats_.hits++;
+    deps.insert(deps.end(), it->second.deps.begin(), it->second.deps.end());
+    return it->second.source;
+  }
+  stats_.misses++;
+
+  // stamp before reading so a write in between invalidates the entry next time
+  auto stamp = source_.stamp(path);
+  auto file = source_.read(path);
+  if (!stamp.has_value() || !file.has_value()) {
+    if (depth > 0) spdlog::error("Shader include not found: {}", path);
+    return std::nullopt;
+  }
+
+  CacheEntry entry;
+  entry.deps.push_back({path, stamp.value()});
+  std::string& content = entry.source;
+  content.reserve(file->size());
+
+  std::string_view remaining = file.value();
+  while (!remaining.empty()) {
+    size_t line_end = remaining.find('\n');
+    std::string_view line = remaining.substr(0, line_end);
+    remaining = line_end == std::string_view::npos ? std::string_view{}
+                                                   : remaining.substr(line_end + 1);
+    if (!line.starts_with("#include")) {
+      content.append(line);
+      content += '\n';
+      continue;
+    }
+    size_t start = line.find('\"');
+    size_t end = start == std::string_view::npos ? start : line.find('\"', start + 1);
+    if (end == std::string_view::npos) {
+      spdlog::error("Malformed include in {}: {}", path, line);
+      return std::nullopt;
+    }
+    std::string include_path = include_dir_;
+    include_path.append(line.substr(start + 1, end - start - 1));
+    auto include_content = Expand(include_path, entry.deps, depth + 1);
+    if (!include_content.has_value()) {
+      return std::nullopt;
+    }
+    content += include_content.value();
+  }
+
+  deps.insert(deps.end(), entry.deps.begin(), entry.deps.end());
+  auto& cached = cache_.insert_or_assign(path, std::move(entry)).first->second;
+  return cached.source;
+}
+
+uint64_t ShaderPreprocessor::ProgramCacheKey(std::span<const Stage> stages,
+                                             std::string_view driver_id) {
+  uint64_t hash = kFnvOffset;
+  HashString(hash, driver_id);
+  for (const auto& stage : stages) {
+    auto type = static_cast<uint32_t>(stage.type);
+    HashBytes(hash, &type, sizeof(type));
+    HashString(hash, stage.source);
+  }
+  return hash;
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <functional>
+
+enum class ShaderType { kVertex, kFragment, kGeometry, kCompute };
+
+// Expands #include "file" directives relative to an include directory. Expanded files are cached
+// with the write times of everything they pulled in, so reloading unchanged shaders doesn't touch
+// the disk beyond a stat per file. Doesn't use GL.
+class ShaderPreprocessor {
+ public:
+  struct FileSource {
+    std::function<std::optional<std::string>(const std::string& path)> read;
+    // any value that changes when the file does, std::nullopt if the file is missing
+    std::function<std::optional<int64_t>(const std::string& path)> stamp;
+  };
+  static FileSource DiskFileSource();
+
+  explicit ShaderPreprocessor(std::string include_dir, FileSource source = DiskFileSource());
+
+  // std::nullopt if the file or one of its includes can't be read
+  [[nodiscard]] std::optional<std::string> Preprocess(const std::string& path);
+  void ClearCache() { cache_.clear(); }
+
+  struct Stats {
+    uint32_t hits{};
+    uint32_t misses{};
+  };
+  [[nodiscard]] const Stats& GetStats() const { return stats_; }
+
+  struct Stage {
+    ShaderType type;
+    std::string_view source;
+  };
+  // Identifies a linked program binary: the preprocessed source of every stage plus the driver,
+  // since binaries are only valid for the driver that produced them.
+  [[nodiscard]] static uint64_t ProgramCacheKey(std::span<const Stage> stages,
+                                                std::string_view driver_id);
+
+ private:
+  struct Dependency {
+    std::string path;
+    int64_t stamp;
+  };
+  struct CacheEntry {
+    std::string source;
+    // the file itself first, then every include it expanded
+    std::vector<Dependency> deps;
+  };
+  std::optional<std::string> Expand(const std::string& path, std::vector<Dependency>& deps,
+                                    int depth);
+  bool IsValid(const CacheEntry& entry) const;
+
+  std::string include_dir_;
+  FileSource source_;
+  std::unordered_map<std::string, CacheEntry> cache_;
+  Stats stats_;
+};
@@ -27,6 +27,7 @@ class DynamicBuffer {
 
     glCreateBuffers(1, &id_);
     glNamedBufferStorage(id_, size_bytes, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    size_bytes_ = size_bytes;
 
     // create one large free block
     Allocation<UserT> empty_alloc{};
@@ -64,25 +65,19 @@ class DynamicBuffer {
     ZoneScoped;
     // align the size
     size_bytes += (alignment_ - (size_bytes % alignment_)) % alignment_;
-    auto smallest_free_alloc = allocs_.end();
-    {
-      ZoneScopedN("smallest free alloc");
-      // find the smallest free allocation that is large enough
-      for (auto it = allocs_.begin(); it != allocs_.end(); it++) {
-        // adequate if free and size fits
-        if (it->handle == 0 && it->size_bytes >= size_bytes) {
-          // if it's the first or it's smaller, set it to the new smallest free alloc
-          if (smallest_free_alloc == allocs_.end() ||
-              it->size_bytes < smallest_free_alloc->size_bytes) {
-            smallest_free_alloc = it;
-          }
-        }
-      }
-      // if there isn't an allocation small enough, return 0, null handle
-      if (smallest_free_alloc == allocs_.end()) {
-        spdlog::error("uh oh, no space left");
-        return 0;
-      }
+    auto smallest_free_alloc = FindSmallestFree(size_bytes);
+    // the space may only be waiting on queued frees
+    if (smallest_free_alloc == allocs_.end() && FlushFrees() > 0) {
+      smallest_free_alloc = FindSmallestFree(size_bytes);
+    }
+    // if there isn't an allocation small enough, return 0, null handle
+    if (smallest_free_alloc == allocs_.end()) {
+      Usage usage = GetUsage();
+      spdlog::error(
+          "uh oh, no space left: {} bytes requested, largest free block {} of {} free bytes in {} "
+          "blocks",
+          size_bytes, usage.largest_free_bytes, usage.free_bytes, usage.free_blocks);
+      return 0;
     }
 
     // create new allocation
@@ -129,9 +124,75 @@ class DynamicBuffer {
     --num_active_allocs_;
   }
 
+  // Frees at the next FlushFrees instead, so a frame's frees cost one pass over the allocations
+  // rather than a scan and erase each. The range stays allocated and drawn until then.
+  void QueueFree(uint32_t handle) {
+    if (handle != 0) pending_frees_.emplace_back(handle);
+  }
+
+  // Applies the queued frees in one sorted merge. Returns how many were freed.
+  uint32_t FlushFrees() {
+    ZoneScoped;
+    if (pending_frees_.empty()) return 0;
+    std::sort(pending_frees_.begin(), pending_frees_.end());
+    uint32_t num_freed = 0;
+    for (auto& alloc : allocs_) {
+      if (alloc.handle != 0 &&
+          std::binary_search(pending_frees_.begin(), pending_frees_.end(), alloc.handle)) {
+        alloc.handle = 0;
+        num_freed++;
+      }
+    }
+    pending_frees_.clear();
+    // merge each run of free allocations into its first one
+    size_t num_allocs = 0;
+    for (size_t i = 0; i < allocs_.size(); i++) {
+      if (num_allocs > 0 && allocs_[i].handle == 0 && allocs_[num_allocs - 1].handle == 0) {
+        allocs_[num_allocs - 1].size_bytes += allocs_[i].size_bytes;
+        continue;
+      }
+      allocs_[num_allocs++] = allocs_[i];
+    }
+    allocs_.resize(num_allocs);
+    num_active_allocs_ -= num_freed;
+    return num_freed;
+  }
+
+  [[nodiscard]] inline size_t NumPendingFrees() const { return pending_frees_.size(); }
+
   [[nodiscard]] inline bool Valid() const { return id_ != 0; }
   [[nodiscard]] inline uint32_t NumActiveAllocs() const { return num_active_allocs_; }
 
+  struct Usage {
+    size_t capacity_bytes{};
+    size_t used_bytes{};
+    size_t free_bytes{};
+    size_t largest_free_bytes{};
+    uint32_t free_blocks{};
+    // 0 when all free bytes are one block, near 1 when they're scattered in small blocks. Allocate
+    // fails for anything bigger than largest_free_bytes no matter how many bytes are free.
+    [[nodiscard]] float Fragmentation() const {
+      return free_bytes ? 1.f - static_cast<float>(largest_free_bytes) /
+                                    static_cast<float>(free_bytes)
+                        : 0.f;
+    }
+  };
+  // Walks the allocation list, O(allocations).
+  [[nodiscard]] Usage GetUsage() const {
+    Usage usage;
+    usage.capacity_bytes = size_bytes_;
+    for (const auto& alloc : allocs_) {
+      if (alloc.handle != 0) {
+        usage.used_bytes += alloc.size_bytes;
+        continue;
+      }
+      usage.free_bytes += alloc.size_bytes;
+      usage.largest_free_bytes = std::max<size_t>(usage.largest_free_bytes, alloc.size_bytes);
+      usage.free_blocks++;
+    }
+    return usage;
+  }
+
   template <typename UT = UserT>
   struct Allocation {
     uint64_t handle{0};
@@ -154,10 +215,30 @@ class DynamicBuffer {
   uint32_t alignment_{0};
   uint64_t next_handle_{1};
   uint32_t num_active_allocs_{0};
+  uint32_t size_bytes_{0};
   size_t max_size_;
 
   std::vector<Allocation<UserT>> allocs_;
+  std::vector<uint32_t> pending_frees_;
   using Iterator = decltype(allocs_.begin());
+
+  [[nodiscard]] Iterator FindSmallestFree(uint32_t size_bytes) {
+    ZoneScopedN("smallest free alloc");
+    auto smallest_free_alloc = allocs_.end();
+    // find the smallest free allocation that is large enough
+    for (auto it = allocs_.begin(); it != allocs_.end(); it++) {
+      // adequate if free and size fits
+      if (it->handle == 0 && it->size_bytes >= size_bytes) {
+        // if it's the first or it's smaller, set it to the new smallest free alloc
+        if (smallest_free_alloc == allocs_.end() ||
+            it->size_bytes < smallest_free_alloc->size_bytes) {
+          smallest_free_alloc = it;
+        }
+      }
+    }
+    return smallest_free_alloc;
+  }
+
   void Coalesce(Iterator& it) {
     ZoneScoped;
     EASSERT_MSG(it != allocs_.end(), "Don't coalesce a non-existent allocation");
@@ -8,6 +8,35 @@ namespace {
 uint32_t GetMipLevels(int width, int height) {
   return static_cast<GLuint>(glm::ceil(glm::log2(static_cast<float>(glm::min(width, height)))));
 }
+
+size_t BytesPerTexel(uint32_t internal_format) {
+  switch (internal_format) {
+    case GL_R8:
+      return 1;
+    case GL_RG8:
+    case GL_R16F:
+      return 2;
+    case GL_RGB8:
+    case GL_SRGB8:
+      // drivers usually pad to 4
+      return 4;
+    case GL_RGBA16F:
+      return 8;
+    case GL_RGBA32F:
+      return 16;
+    default:
+      return 4;
+  }
+}
+
+size_t TextureSizeBytes(uint32_t internal_format, int width, int height, size_t layers,
+                        uint32_t mip_levels) {
+  size_t bytes = 0;
+  for (uint32_t level = 0; level < mip_levels; level++) {
+    bytes += static_cast<size_t>(std::max(width >> level, 1)) * std::max(height >> level, 1);
+  }
+  return bytes * layers * BytesPerTexel(internal_format);
+}
 }  // namespace
 
 Texture::Texture(const TextureCubeCreateParamsPaths& params) {
@@ -21,6 +50,7 @@ Texture::Texture(const TextureCubeCreateParamsPaths& params) {
   GLenum internal_format = images[0].channels == 3 ? GL_RGB8 : GL_RGBA8;
   GLenum format = images[0].channels == 3 ? GL_RGB : GL_RGBA;
   glTextureStorage2D(id_, 1, internal_format, images[0].width, images[0].height);
+  size_bytes_ = TextureSizeBytes(internal_format, images[0].width, images[0].height, 6, 1);
   int i = 0;
   for (auto& image : images) {
     glTextureSubImage3D(id_, 0, 0, 0, i++, image.width, image.height, 1, format, GL_UNSIGNED_BYTE,
@@ -45,6 +75,7 @@ Texture::Texture(const Texture2DCreateParamsEmpty& params) {
 
   uint32_t mip_levels = params.generate_mipmaps ? GetMipLevels(dims_.x, dims_.y) : 1;
   glTextureStorage2D(id_, mip_levels, GL_RGBA8, dims_.x, dims_.y);
+  size_bytes_ = TextureSizeBytes(GL_RGBA8, dims_.x, dims_.y, 1, mip_levels);
 
   if (params.bindless) {
     bindless_handle_ = glGetTextureHandleARB(id_);
@@ -71,6 +102,7 @@ Texture::Texture(const Texture2DCreateParams& params) {
 
   uint32_t mip_levels = params.generate_mipmaps ? GetMipLevels(dims_.x, dims_.y) : 1;
   glTextureStorage2D(id_, mip_levels, params.internal_format, dims_.x, dims_.y);
+  size_bytes_ = TextureSizeBytes(params.internal_format, dims_.x, dims_.y, 1, mip_levels);
 
   glTextureSubImage2D(id_,
                       0,                 // first mip level
@@ -108,6 +140,7 @@ Texture::Texture(Texture&& other) noexcept { *this = std::move(other); }
 Texture& Texture::operator=(Texture&& other) noexcept {
   this->id_ = std::exchange(other.id_, 0);
   this->dims_ = other.dims_;
+  this->size_bytes_ = std::exchange(other.size_bytes_, 0);
   this->bindless_handle_ = std::exchange(other.bindless_handle_, 0);
   return *this;
 }
@@ -140,23 +173,62 @@ Texture::Texture(const Texture2DArrayCreateParams& params) {
   glTextureParameteri(id_, GL_TEXTURE_MAG_FILTER, params.filter_mode_max);
 
   uint32_t mip_levels = 1;
-  if (params.generate_mipmaps) {
+  if (params.mip_images) {
+    EASSERT_MSG(params.mip_images->size() == params.images.size(),
+                "Need mip levels for every image");
+    mip_levels = params.mip_images->front().size() + 1;
+  } else if (params.generate_mipmaps) {
     mip_levels = glm::floor(glm::log2(static_cast<float>(glm::max(dims_.x, dims_.y)))) + 1;
   }
 
   glTextureStorage3D(id_, mip_levels, params.internal_format, dims_.x, dims_.y,
                      params.images.size());
+  size_bytes_ = TextureSizeBytes(params.internal_format, dims_.x, dims_.y, params.images.size(),
+                                 mip_levels);
 
   // spdlog::info("create tex array {} of depth: {}", id_, params.all_pixels_data.size());
   for (size_t i = 0; i < params.images.size(); i++) {
     glTextureSubImage3D(id_, 0, 0, 0, i, dims_.x, dims_.y, 1, params.format, GL_UNSIGNED_BYTE,
                         params.images[i].pixels);
   }
-  if (params.generate_mipmaps) glGenerateTextureMipmap(id_);
+  if (params.mip_images) {
+    for (size_t i = 0; i < params.images.size(); i++) {
+      const auto& levels = (*params.mip_images)[i];
+      for (uint32_t level = 1; level < mip_levels && level - 1 < levels.size(); level++) {
+        const Image& image = levels[level - 1];
+        glTextureSubImage3D(id_, level, 0, 0, i, image.width, image.height, 1, params.format,
+                            GL_UNSIGNED_BYTE, image.pixels);
+      }
+    }
+  } else if (params.generate_mipmaps) {
+    glGenerateTextureMipmap(id_);
+  }
   if (params.bindless) {
     bindless_handle_ = glGetTextureHandleARB(id_);
     MakeResident();
   }
 }
 
+Texture::Texture(const Texture2DArrayCreateParamsEmpty& params) {
+  ZoneScoped;
+  if (params.layers == 0) return;
+  dims_ = glm::ivec2(params.width, params.height);
+  glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &id_);
+  glTextureParameteri(id_, GL_TEXTURE_WRAP_S, params.texture_wrap);
+  glTextureParameteri(id_, GL_TEXTURE_WRAP_T, params.texture_wrap);
+  glTextureParameteri(id_, GL_TEXTURE_WRAP_R, params.texture_wrap);
+  glTextureParameteri(id_, GL_TEXTURE_MIN_FILTER, params.filter_mode_min);
+  glTextureParameteri(id_, GL_TEXTURE_MAG_FILTER, params.filter_mode_max);
+  glTextureStorage3D(id_, params.mip_levels, params.internal_format, dims_.x, dims_.y,
+                     params.layers);
+  size_bytes_ = TextureSizeBytes(params.internal_format, dims_.x, dims_.y, params.layers,
+                                 params.mip_levels);
+}
+
+void Texture::SubImageLayer(uint32_t layer, uint32_t level, const Image& image,
+                            uint32_t format) const {
+  glTextureSubImage3D(id_, level, 0, 0, layer, image.width, image.height, 1, format,
+                      GL_UNSIGNED_BYTE, image.pixels);
+}
+
 void Texture::Bind(int unit) const { glBindTextureUnit(unit, id_); }
@@ -37,6 +37,21 @@ struct Texture2DArrayCreateParams {
   uint32_t filter_mode_max{GL_LINEAR};
   uint32_t texture_wrap{GL_CLAMP_TO_EDGE};
   bool bindless{false};
+  // levels 1 and up of each image, built on the CPU. Uploaded instead of generating mipmaps on the
+  // GPU when set.
+  const std::vector<std::vector<Image>>* mip_images{nullptr};
+};
+
+// Storage only, filled a layer at a time with SubImageLayer.
+struct Texture2DArrayCreateParamsEmpty {
+  uint32_t width;
+  uint32_t height;
+  uint32_t layers;
+  uint32_t mip_levels{1};
+  uint32_t internal_format{GL_RGBA8};
+  uint32_t filter_mode_min{GL_LINEAR};
+  uint32_t filter_mode_max{GL_LINEAR};
+  uint32_t texture_wrap{GL_CLAMP_TO_EDGE};
 };
 
 class Texture {
@@ -44,6 +59,7 @@ class Texture {
   explicit Texture(const Texture2DCreateParamsEmpty& params);
   explicit Texture(const Texture2DCreateParams& params);
   explicit Texture(const Texture2DArrayCreateParams& params);
+  explicit Texture(const Texture2DArrayCreateParamsEmpty& params);
   // explicit Texture(const TextureCubeCreateParams& params);
   explicit Texture(const TextureCubeCreateParamsPaths& params);
   Texture(const Texture& other) = delete;
@@ -53,6 +69,8 @@ class Texture {
   ~Texture();
   [[nodiscard]] uint32_t Id() const { return id_; }
   [[nodiscard]] glm::ivec2 Dims() const { return dims_; }
+  // estimated from the storage format, dimensions, layers and mip levels
+  [[nodiscard]] size_t SizeBytes() const { return size_bytes_; }
   [[nodiscard]] uint64_t BindlessHandle() const { return bindless_handle_; }
   void MakeNonResident();
   void MakeResident();
@@ -60,10 +78,13 @@ class Texture {
 
   void Bind() const;
   void Bind(int unit) const;
+  // Uploads one mip level of one layer of a 2D array texture.
+  void SubImageLayer(uint32_t layer, uint32_t level, const Image& image, uint32_t format) const;
 
  private:
   uint32_t id_{0};
   uint32_t bindless_handle_{0};
   bool resident_{false};
   glm::ivec2 dims_{};
+  size_t size_bytes_{};
 };
@@ -0,0 +1,227 @@
+#include "ImageLoader.hpp"
+
+#include <stb_image.h>
+
+#include <BS_thread_pool.hpp>
+#include <fstream>
+
+#include "util/Paths.hpp"
+#include "util/Timer.hpp"
+
+namespace {
+
+constexpr uint32_t kCacheMagic = 0x474d4956;  // "VIMG"
+constexpr uint32_t kCacheVersion = 1;
+
+struct CacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  int32_t width;
+  int32_t height;
+  int32_t num_levels;
+  int32_t avg_color[3];
+};
+
+std::optional<std::vector<uint8_t>> ReadFileBytes(const std::string& path) {
+  std::ifstream file(path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) return std::nullopt;
+  std::vector<uint8_t> bytes(static_cast<size_t>(file.tellg()));
+  file.seekg(0);
+  file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+  if (!file) return std::nullopt;
+  return bytes;
+}
+
+// FNV-1a, only needs to tell file versions apart
+uint64_t HashBytes(const std::vector<uint8_t>& bytes) {
+  uint64_t hash = 14695981039346656037ull;
+  for (uint8_t b : bytes) {
+    hash ^= b;
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+std::filesystem::path CachePath(const std::filesystem::path& cache_dir, uint64_t hash,
+                                const ImageLoadParams& params) {
+  return cache_dir / fmt::format("{:016x}_{}{}.bin", hash, params.flip ? 'f' : 'n',
+                                 params.generate_mipmaps ? 'm' : 'b');
+}
+
+bool ReadCached(const std::filesystem::path& path, DecodedImage& image) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file.is_open()) return false;
+  CacheHeader header{};
+  file.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!file || header.magic != kCacheMagic || header.version != kCacheVersion ||
+      header.width <= 0 || header.height <= 0 || header.num_levels <= 0) {
+    return false;
+  }
+  image.width = header.width;
+  image.height = header.height;
+  image.avg_color = {header.avg_color[0], header.avg_color[1], header.avg_color[2]};
+  image.levels.resize(header.num_levels);
+  for (int level = 0; level < header.num_levels; level++) {
+    size_t w = std::max(header.width >> level, 1);
+    size_t h = std::max(header.height >> level, 1);
+    image.levels[level].resize(w * h * 4);
+    file.read(reinterpret_cast<char*>(image.levels[level].data()),
+              static_cast<std::streamsize>(image.levels[level].size()));
+  }
+  if (!file) {
+    image = {};
+    return false;
+  }
+  return true;
+}
+
+void WriteCached(const std::filesystem::path& path, const DecodedImage& image) {
+  // write then rename so a crash or a concurrent launch never leaves a truncated entry behind
+  std::filesystem::path tmp_path = path;
+  tmp_path += ".tmp";
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return;
+    CacheHeader header{kCacheMagic,
+                       kCacheVersion,
+                       image.width,
+                       image.height,
+                       image.NumLevels(),
+                       {image.avg_color.x, image.avg_color.y, image.avg_color.z}};
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& level : image.levels) {
+      file.write(reinterpret_cast<const char*>(level.data()),
+                 static_cast<std::streamsize>(level.size()));
+    }
+    if (!file) return;
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp_path, path, ec);
+  if (ec) std::filesystem::remove(tmp_path, ec);
+}
+
+// 2x2 box filter like glGenerateMipmap, odd edges repeat the last texel
+void BuildMipLevels(DecodedImage& image) {
+  int w = image.width;
+  int h = image.height;
+  while (w > 1 || h > 1) {
+    const std::vector<uint8_t>& src = image.levels.back();
+    int next_w = std::max(w >> 1, 1);
+    int next_h = std::max(h >> 1, 1);
+    std::vector<uint8_t> dst(static_cast<size_t>(next_w) * next_h * 4);
+    for (int y = 0; y < next_h; y++) {
+      int y0 = std::min(y * 2, h - 1);
+      int y1 = std::min(y * 2 + 1, h - 1);
+      for (int x = 0; x < next_w; x++) {
+        int x0 = std::min(x * 2, w - 1);
+        int x1 = std::min(x * 2 + 1, w - 1);
+        for (int c = 0; c < 4; c++) {
+          int sum = src[(y0 * w + x0) * 4 + c] + src[(y0 * w + x1) * 4 + c] +
+                    src[(y1 * w + x0) * 4 + c] + src[(y1 * w + x1) * 4 + c];
+          dst[(y * next_w + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+        }
+      }
+    }
+    image.levels.emplace_back(std::move(dst));
+    w = next_w;
+    h = next_h;
+  }
+}
+
+bool Decode(const std::vector<uint8_t>& bytes, const ImageLoadParams& params,
+            DecodedImage& image) {
+  stbi_set_flip_vertically_on_load_thread(params.flip);
+  int channels;
+  uint8_t* pixels = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()),
+                                          &image.width, &image.height, &channels, 4);
+  if (!pixels) return false;
+  image.levels.emplace_back(pixels, pixels + static_cast<size_t>(image.width) * image.height * 4);
+  stbi_image_free(pixels);
+  image.avg_color = ImageLoader::AverageColor(image.levels[0].data(), image.width, image.height);
+  if (params.generate_mipmaps) BuildMipLevels(image);
+  return true;
+}
+
+}  // namespace
+
+Image DecodedImage::GetLevel(int level) const {
+  EASSERT_MSG(level < NumLevels(), "Mip level out of range");
+  // Image is shared with stb, which hands out mutable pixels
+  return {.pixels = const_cast<uint8_t*>(levels[level].data()),
+          .width = std::max(width >> level, 1),
+          .height = std::max(height >> level, 1),
+          .channels = 4};
+}
+
+ImageLoader::ImageLoader(std::filesystem::path cache_dir) : cache_dir_(std::move(cache_dir)) {
+  if (cache_dir_.empty()) return;
+  std::error_code ec;
+  std::filesystem::create_directories(cache_dir_, ec);
+  if (ec) {
+    spdlog::warn("Failed to create image cache directory {}: {}", cache_dir_.string(),
+                 ec.message());
+    cache_dir_.clear();
+  }
+}
+
+std::filesystem::path ImageLoader::DefaultCacheDir() {
+  return GET_PATH("resources/cache/images");
+}
+
+glm::ivec3 ImageLoader::AverageColor(const uint8_t* rgba, int width, int height) {
+  glm::ivec3 sum{0, 0, 0};
+  for (int i = 0; i < width * height * 4; i += 4) {
+    sum.x += rgba[i];
+    sum.y += rgba[i + 1];
+    sum.z += rgba[i + 2];
+  }
+  return sum / std::max(width * height, 1);
+}
+
+std::vector<DecodedImage> ImageLoader::Load(const std::vector<std::string>& paths,
+                                            const ImageLoadParams& params) {
+  ZoneScoped;
+  Timer timer;
+  std::vector<DecodedImage> images(paths.size());
+  std::vector<uint8_t> cache_hit(paths.size(), 0);
+  {
+    BS::thread_pool pool(std::min<size_t>(paths.size(), std::thread::hardware_concurrency()));
+    for (size_t i = 0; i < paths.size(); i++) {
+      pool.detach_task([this, &paths, &params, &images, &cache_hit, i] {
+        ZoneScopedN("Decode image");
+        auto bytes = ReadFileBytes(paths[i]);
+        if (!bytes) return;
+        std::filesystem::path cache_path;
+        if (!cache_dir_.empty()) {
+          cache_path = CachePath(cache_dir_, HashBytes(*bytes), params);
+          if (ReadCached(cache_path, images[i])) {
+            cache_hit[i] = 1;
+            return;
+          }
+        }
+        if (!Decode(*bytes, params, images[i])) {
+          images[i] = {};
+          return;
+        }
+        if (!cache_path.empty()) WriteCached(cache_path, images[i]);
+      });
+    }
+    pool.wait();
+  }
+
+  stats_ = {};
+  for (size_t i = 0; i < paths.size(); i++) {
+    if (!images[i].IsValid()) {
+      spdlog::error("Failed to load image at path {}", paths[i]);
+      stats_.failed++;
+    } else if (cache_hit[i]) {
+      stats_.cache_hits++;
+    } else {
+      stats_.decoded++;
+    }
+  }
+  stats_.ms = timer.ElapsedMS();
+  spdlog::info("Loaded {} images in {:.2f} ms, {} decoded, {} from cache, {} failed",
+               paths.size(), stats_.ms, stats_.decoded, stats_.cache_hits, stats_.failed);
+  return images;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <glm/vec3.hpp>
+
+#include "resource/Image.hpp"
+
+// RGBA8 pixels with an optional mip chain built on the CPU.
+struct DecodedImage {
+  int width{}, height{};
+  // level 0 first, each level half the size of the last down to 1x1
+  std::vector<std::vector<uint8_t>> levels;
+  // of level 0, for LOD vertex colors
+  glm::ivec3 avg_color{};
+
+  [[nodiscard]] bool IsValid() const { return !levels.empty(); }
+  [[nodiscard]] int NumLevels() const { return static_cast<int>(levels.size()); }
+  // Non-owning view of a level, don't pass it to util::FreeImage.
+  [[nodiscard]] Image GetLevel(int level = 0) const;
+};
+
+struct ImageLoadParams {
+  bool flip{true};
+  bool generate_mipmaps{false};
+};
+
+// Decodes batches of PNGs on a thread pool. Decoded pixels and mips are cached on disk keyed by a
+// hash of the file contents, so later loads of unchanged files skip PNG decode entirely.
+class ImageLoader {
+ public:
+  // Empty cache_dir disables the cache.
+  explicit ImageLoader(std::filesystem::path cache_dir = DefaultCacheDir());
+
+  // One result per path in the same order. Files that fail to load give an invalid image.
+  [[nodiscard]] std::vector<DecodedImage> Load(const std::vector<std::string>& paths,
+                                               const ImageLoadParams& params);
+
+  struct Stats {
+    uint32_t decoded{};
+    uint32_t cache_hits{};
+    uint32_t failed{};
+    double ms{};
+  };
+  // of the last Load
+  [[nodiscard]] const Stats& GetStats() const { return stats_; }
+
+  static std::filesystem::path DefaultCacheDir();
+  static glm::ivec3 AverageColor(const uint8_t* rgba, int width, int height);
+
+ private:
+  std::filesystem::path cache_dir_;
+  Stats stats_;
+};
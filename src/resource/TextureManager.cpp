@@ -29,6 +29,13 @@ std::shared_ptr<Texture> TextureManager::Load(const Texture2DArrayCreateParams&
   return tex;
 }
 
+std::shared_ptr<Texture> TextureManager::Load(const Texture2DArrayCreateParamsEmpty& params) {
+  uint32_t handle = next_tex_array_handle_++;
+  auto tex = std::make_shared<Texture>(params);
+  texture_map_.emplace(std::to_string(handle), tex);
+  return tex;
+}
+
 std::shared_ptr<Texture> TextureManager::Load(const std::string& name,
                                               const TextureCubeCreateParamsPaths& params) {
   auto it = texture_map_.find(name);
@@ -72,4 +79,10 @@ void TextureManager::RemoveUnusedTextures() {
   }
 }
 
+size_t TextureManager::GetMemoryBytes() const {
+  size_t bytes = 0;
+  for (const auto& [name, tex] : texture_map_) bytes += tex->SizeBytes();
+  return bytes;
+}
+
 void TextureManager::Erase(const std::string& name) { texture_map_.erase(name); }
@@ -3,6 +3,7 @@
 using TextureHandle = uint32_t;
 class Texture;
 struct Texture2DArrayCreateParams;
+struct Texture2DArrayCreateParamsEmpty;
 struct TextureCubeCreateParamsPaths;
 struct Texture2DCreateParams;
 struct Texture2DCreateParamsEmpty;
@@ -15,12 +16,16 @@ class TextureManager {
   void Erase(const std::string& name);
 
   [[nodiscard]] std::shared_ptr<Texture> Load(const Texture2DArrayCreateParams& params);
+  [[nodiscard]] std::shared_ptr<Texture> Load(const Texture2DArrayCreateParamsEmpty& params);
   [[nodiscard]] std::shared_ptr<Texture> Load(const std::string& name,
                                               const TextureCubeCreateParamsPaths& params);
   [[nodiscard]] std::shared_ptr<Texture> Load(const Texture2DCreateParams& params);
   [[nodiscard]] std::shared_ptr<Texture> Load(const std::string& name,
                                               const Texture2DCreateParamsEmpty& params);
   void RemoveUnusedTextures();
+  [[nodiscard]] size_t NumTextures() const { return texture_map_.size(); }
+  // estimated GPU bytes of every texture the manager holds
+  [[nodiscard]] size_t GetMemoryBytes() const;
 
  private:
   static TextureManager* instance_;